@@ -28,6 +28,8 @@ SPDX-License-Identifier: MIT-0
 #include "core/swtrace/swtrace-led.h"
 #include "mcu/clock/mco.h"
 #include "mcu/clock/clock-tree-default-config.h"
+#include "mcu/clock/timebase.h"
+#include "mcu/clock/timer-service.h"
 
 // MCU Device Definition
 #include "CMSIS/Device/ST/STM32L4xx/Include/stm32l476xx.h"
@@ -44,10 +46,31 @@ SPDX-License-Identifier: MIT-0
 // =============================================================================================#=
 
 // -----------------------------------------------------+-
-// Defines how long to wait between blinkies;
+// Defines how long to wait between blinkies, in microseconds;
 // Volatile because this is changed by the button ISR.
 // -----------------------------------------------------+-
-static volatile int32_t  Blinky_Delay = 0x0007FFFF;
+#define BLINKY_PERIOD_MAX_US   (32000U)
+#define BLINKY_PERIOD_STEP_US  (4000U)
+
+static volatile int32_t  Blinky_Period_Us = BLINKY_PERIOD_MAX_US;
+
+// -----------------------------------------------------+-
+// The blinky sequence: a burst of blinkies, then the
+// green LED on, then off; stepped by a software timer.
+// -----------------------------------------------------+-
+#define BLINKY_BURST_TOGGLES   (0xFFU)
+#define BLINKY_GREEN_ON_US     (800000U)
+#define BLINKY_GREEN_OFF_US    (350000U)
+
+typedef enum {
+    BLINKY_BURST,
+    BLINKY_GREEN_ON,
+    BLINKY_GREEN_OFF,
+} Blinky_Phase;
+
+static MCU_Timer     Blinky_Timer;
+static Blinky_Phase  Blinky_Phase_Now = BLINKY_BURST;
+static uint32_t      Blinky_Toggles   = 0;
 
 
 // =============================================================================================#=
@@ -136,12 +159,57 @@ static void user_button_config(void)
 // -----------------------------------------------------------------------------+-
 static void user_button_callback(void)
 {
-    Blinky_Delay = Blinky_Delay - 0x00000FFFF;
+    Blinky_Period_Us = Blinky_Period_Us - BLINKY_PERIOD_STEP_US;
     Trace_Red_Toggle();
-    if( Blinky_Delay < 0)
+    if( Blinky_Period_Us <= 0)
     {
         Trace_Green_Toggle();
-        Blinky_Delay = 0x0007FFFF;
+        Blinky_Period_Us = BLINKY_PERIOD_MAX_US;
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// Blinky Timer Callback; one step of the blinky sequence.
+// Runs in the TIM2 interrupt; each step starts the timer for the next.
+// -----------------------------------------------------------------------------+-
+static void blinky_timer_callback(void *context)
+{
+    (void)context;
+
+    switch (Blinky_Phase_Now)
+    {
+        case BLINKY_BURST:
+            if (Blinky_Toggles == 0) {
+                Trace_OnBrdGreen_On();
+                Trace_Blue_Off();
+            }
+            if (Blinky_Toggles < BLINKY_BURST_TOGGLES) {
+                // Blinking blue and green;
+                Trace_Blue_Toggle();
+                Trace_OnBrdGreen_Toggle();
+                Blinky_Toggles++;
+                MCU_Timer_Start_Once(&Blinky_Timer, (uint64_t)Blinky_Period_Us);
+                break;
+            }
+            Blinky_Toggles = 0;
+            // Trace_Yellow_On();
+            Trace_OnBrdGreen_On();
+            Blinky_Phase_Now = BLINKY_GREEN_ON;
+            MCU_Timer_Start_Once(&Blinky_Timer, BLINKY_GREEN_ON_US);
+            break;
+
+        case BLINKY_GREEN_ON:
+            // Trace_Yellow_Off();
+            Trace_OnBrdGreen_Off();
+            Blinky_Phase_Now = BLINKY_GREEN_OFF;
+            MCU_Timer_Start_Once(&Blinky_Timer, BLINKY_GREEN_OFF_US);
+            break;
+
+        case BLINKY_GREEN_OFF:
+        default:
+            Blinky_Phase_Now = BLINKY_BURST;
+            MCU_Timer_Start_Once(&Blinky_Timer, 0);
+            break;
     }
 }
 
@@ -193,11 +261,8 @@ void SysTick_Handler(void) {
 // =============================================================================================#=
 int main(void)
 {
-    // TODO: Explain what's going on here.
-    // Refactor? Move?
-    LL_FLASH_SetLatency(LL_FLASH_LATENCY_1);
-
     // Initialize Clock Tree and SysTick at startup;
+    // This also sets the flash wait states and enables the ART caches.
     MCU_Clock_Tree_Default_Config();
 
     // Configure Microcontroller Clock Output
@@ -208,31 +273,17 @@ int main(void)
     SW_Trace_OnBoard_LED_Init();
     user_button_config();
 
+    // Start the 64-bit timebase on TIM2, and the software timers on it;
+    MCU_Timebase_Init();
+    MCU_Timer_Service_Init();
+
     // Forever toggle some LEDs...
+    // The blinky timer steps the sequence; the core sleeps in between.
+    MCU_Timer_Init(&Blinky_Timer, blinky_timer_callback, NULL);
+    MCU_Timer_Start_Once(&Blinky_Timer, 0);
+
     while (1)
     {
-        Trace_OnBrdGreen_On();
-        Trace_Blue_Off();
-
-        for( uint32_t i=0; i<0x000000FF; i++) {
-
-            // Blinking blue and green;
-            Trace_Blue_Toggle();
-            Trace_OnBrdGreen_Toggle();
-
-            // Busy wait to delay;
-            // Duration can vary depending on delay value;
-            for( uint32_t i=0; i<Blinky_Delay; i++) {}
-        }
-
-        // Trace_Yellow_On();
-        Trace_OnBrdGreen_On();
-        for( uint32_t i=0; i<0x00F77777; i++) {}
-
-        // Trace_Yellow_Off();
-        Trace_OnBrdGreen_Off();
-        for( uint32_t i=0; i<0x00700000; i++) {}
+        __WFI();
     }
 }
-
-
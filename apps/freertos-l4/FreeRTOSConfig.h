@@ -50,13 +50,14 @@
 
 
 #define configUSE_PREEMPTION			1
-#define configUSE_IDLE_HOOK				0
+#define configUSE_IDLE_HOOK				1
 #define configUSE_TICK_HOOK				1
 #define configCPU_CLOCK_HZ				( SystemCoreClock )
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 5 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 60 )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 6500 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 10000 ) )
+#define configAPPLICATION_ALLOCATED_HEAP	1	/* ucHeap is in SRAM2; see main.c */
 #define configMAX_TASK_NAME_LEN			( 5 )
 #define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
@@ -68,7 +69,7 @@
 #define configUSE_MALLOC_FAILED_HOOK	1
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
 #define configENFORCE_SYSTEM_CALLS_FROM_KERNEL_ONLY  1
 #define configALLOW_UNPRIVILEGED_CRITICAL_SECTIONS   1
 
@@ -94,6 +95,14 @@ to exclude the API function. */
 #define INCLUDE_xQueueGetMutexHolder            1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_eTaskGetState                   1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+
+/* Run time statistics count DWT cycles, as does the CPU load meter; see
+core/prof/cpu-load.h.  The counter wraps every 53 seconds at 80 MHz, so only
+the change over a shorter period is meaningful; see core/prof/rtos-top.h */
+#include "core/prof/cpu-load.h"
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()  CPU_LOAD_Init()
+#define portGET_RUN_TIME_COUNTER_VALUE()          CPU_LOAD_CYCLES()
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -130,7 +139,30 @@ standard names - or at least those used in the unmodified vector table. */
 #define xPortPendSVHandler PendSV_Handler
 /* IMPORTANT: This define MUST be commented when used with STM32Cube firmware,
               to prevent overwriting SysTick_Handler defined within STM32Cube HAL */
+/* With interrupt statistics enabled, main.c wraps the port handler in its own
+SysTick_Handler instead; see mcu/vtor/irq-stat.h */
+#if !defined(IRQSTAT_ENABLE) || !IRQSTAT_ENABLE
 #define xPortSysTickHandler SysTick_Handler
+#endif
+
+/* Tickless idle on LPTIM1; the idle task sleeps through the ticks in which no
+task is due to run, in Stop 2 where allowed.  See mcu/power/tickless-idle.h */
+#if defined(TICKLESS_ENABLE) && TICKLESS_ENABLE
+#include "mcu/power/tickless-idle.h"
+#define configUSE_TICKLESS_IDLE                 2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )  MCU_Tickless_Sleep( xExpectedIdleTime )
+#endif
+
+/* Each run of the idle task is idle time for the CPU load meter; these expand
+within tasks.c, where the idle task's handle is in scope. */
+#define TRC_RTOS_SWITCHED_IN_HOOK()  do { \
+    if( ( void * ) pxCurrentTCB == ( void * ) xIdleTaskHandle ) CPU_LOAD_Idle_Begin(); \
+} while( 0 )
+#define TRC_RTOS_SWITCHED_OUT_HOOK() CPU_LOAD_Idle_End()
+
+/* Trace macros that record the scheduler timeline; see core/swtrace/trc-rtos.h */
+#include "core/swtrace/trc-rtos.h"
 
 #endif /* FREERTOS_CONFIG_H */
 
@@ -17,13 +17,37 @@ SPDX-License-Identifier: MIT-0
 
 // Project Dependencies
 #include "platform/usart/usart-it-cli.h"
+#include "platform/cli/cli-cmd.h"
 
 #include "core/swtrace/trc.h"
 #include "core/swtrace/trc-core.h"
+#include "core/swtrace/trc-cli.h"
 #include "core/swtrace/trc-led.h"
+#include "core/swtrace/trc-rtos.h"
+#include "core/swtrace/trc-sink-itm.h"
+#include "core/swtrace/trc-throttle.h"
+
+#include "core/prof/prof.h"
+#include "core/prof/prof-cli.h"
+#include "core/prof/cpu-load.h"
+#include "core/prof/rtos-top.h"
+
+#include "mcu/vtor/irq-stat.h"
+#include "mcu/vtor/irq-stat-cli.h"
+#include "mcu/vtor/ramfunc.h"
+#include "mcu/vtor/sram2.h"
+#include "mcu/vtor/vtor.h"
+#include "mcu/vtor/vtor-cli.h"
 
 #include "mcu/clock/mco.h"
 #include "mcu/clock/clock-tree-default-config.h"
+#include "mcu/clock/flash-cli.h"
+#include "mcu/clock/clock-profile.h"
+#include "mcu/clock/clock-profile-cli.h"
+#include "mcu/clock/clock-tree-info-cli.h"
+#include "mcu/clock/timebase.h"
+#include "mcu/power/tickless-idle.h"
+#include "mcu/power/tickless-idle-cli.h"
 
 // MCU Device Definition
 #include "CMSIS/Device/ST/STM32L4xx/Include/stm32l476xx.h"
@@ -61,6 +85,10 @@ the queue empty. */
 uint8_t  Input_Buffer[256];
 uint32_t Input_Buffer_Len = sizeof(Input_Buffer);
 
+// The FreeRTOS heap, per configAPPLICATION_ALLOCATED_HEAP; in SRAM2, and so
+// are the task stacks, which heap_1 allocates from it.
+uint8_t ucHeap[configTOTAL_HEAP_SIZE] MCU_SRAM2_BSS;
+
 
 // =============================================================================#=
 // QUEUE
@@ -112,6 +140,12 @@ void vApplicationIdleHook( void )
         important that vApplicationIdleHook() is permitted to return to its calling
         function, because it is the responsibility of the idle task to clean up
         memory allocated by the kernel to any task that has since been deleted. */
+
+        // Send the recorded scheduler events, if any, to the trace sinks;
+        TRC_RTOS_Flush();
+
+        // Report what the trace throttle suppressed, once the storm is over;
+        TRC_Throttle_Flush();
 }
 /*-----------------------------------------------------------*/
 
@@ -135,6 +169,21 @@ void vApplicationTickHook( void )
         added here, but the tick hook is called from an interrupt context, so
         code must not attempt to block, and only the interrupt safe FreeRTOS API
         functions can be used (those that end in FromISR()). */
+
+        // Measure the CPU load over windows of one second or so;
+        // On the tick count, not on calls to this hook, which are not made
+        // for the ticks that the tickless idle steps over.  A window thus
+        // ends at the first tick after a second; at most a second plus the
+        // longest tickless sleep, about 2 seconds, well within the wrap of
+        // the cycle counter.
+        static TickType_t window_start = 0;
+        TickType_t        now          = xTaskGetTickCountFromISR();
+
+        if( ( TickType_t )( now - window_start ) >= configTICK_RATE_HZ )
+        {
+            window_start = now;
+            CPU_LOAD_Sample();
+        }
 }
 /*-----------------------------------------------------------*/
 
@@ -255,27 +304,50 @@ static void prvQueueReceiveTask( void *pvParameters )
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 // USART2 Interrupt Request
 // (An external interrupt from the Cortex-M4 vector table;)
+// Runs from SRAM, as does the CLI ISR; see mcu/vtor/ramfunc.h
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
-void USART2_IRQHandler(void)
+MCU_RAMFUNC void USART2_IRQHandler(void)
 {
+    IRQSTAT_ENTER();
+    trcRtosIsrEnter();
     USART_IT_CLI_ISR();
+    trcRtosIsrExit();
+    IRQSTAT_EXIT();
+};
+
+
+#if IRQSTAT_ENABLE
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// SysTick Exception
+// (A system exception from the Cortex-M4 vector table;)
+//
+// Normally the FreeRTOS port handler is the SysTick handler itself;
+// see FreeRTOSConfig.h.  With interrupt statistics enabled it is
+// wrapped here instead, so that its time and latency are recorded.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void xPortSysTickHandler(void);
+
+void SysTick_Handler(void)
+{
+    IRQSTAT_ENTER_LATENCY( IRQSTAT_SysTick_Latency() );
+    xPortSysTickHandler();
+    IRQSTAT_EXIT();
 };
+#endif
 
 
 // -----------------------------------------------------------------------------+-
 // Rx Data Available Callback;
+// Hand each command line over to the CLI command dispatcher.
 // -----------------------------------------------------------------------------+-
 static void rx_data_avail_callback(uint32_t len)
 {
-    strcpy((char *)Input_Buffer, "\nmain: ");
-    USART_IT_CLI_Put_Response(Input_Buffer, strlen((const char *)Input_Buffer));
-
     uint32_t byte_count = USART_IT_CLI_Get_Line(
         Input_Buffer, Input_Buffer_Len
     );
 
     if( byte_count > 0) {
-        USART_IT_CLI_Put_Response(Input_Buffer, byte_count);
+        CLI_CMD_Process_Line((char *)Input_Buffer);
     }
 }
 
@@ -283,27 +355,92 @@ static void rx_data_avail_callback(uint32_t len)
 
 
 
+// -----------------------------------------------------------------------------+-
+// Clock Profile Subscriber;
+// Re-program the CLI USART baud rate for the new PCLK1; see clock-profile.h
+// The FreeRTOS tick, i.e. the SysTick, is kept at configTICK_RATE_HZ by the
+// subscriber that MCU_Clock_Tree_Default_Config() registers.
+// -----------------------------------------------------------------------------+-
+static void usart_clock_changed(MCU_Clock_Change_Event event, const MCU_Clock_Frequencies *clocks)
+{
+    if (event == MCU_CLOCK_CHANGE_BEGIN) {
+        USART_IT_CLI_Clock_Change_Begin();
+    }
+    else {
+        USART_IT_CLI_Clock_Change_End(clocks->pclk1_hz);
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// Clock Profile Subscriber;
+// Keep the profiler's sampling rate; TIM6 is clocked at PCLK1, as below.
+// -----------------------------------------------------------------------------+-
+static void prof_clock_changed(MCU_Clock_Change_Event event, const MCU_Clock_Frequencies *clocks)
+{
+    if (event == MCU_CLOCK_CHANGE_END) {
+        PROF_Timer_Clock_Changed(clocks->pclk1_hz);
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// Clock Profile Subscriber;
+// Keep the SWO bit rate; the TPIU is clocked at the HCLK.
+// -----------------------------------------------------------------------------+-
+static void itm_clock_changed(MCU_Clock_Change_Event event, const MCU_Clock_Frequencies *clocks)
+{
+    if (event == MCU_CLOCK_CHANGE_END) {
+        TRC_Sink_ITM_Core_Clock_Changed(clocks->hclk_hz);
+    }
+}
+
+
+
 // =============================================================================================#=
 // MAIN
 // =============================================================================================#=
 int main( void )
 {
-    // TODO: Explain what's going on here.
-    // Refactor? Move?
-    LL_FLASH_SetLatency(LL_FLASH_LATENCY_1);
+    // Move the vector table to SRAM, if the build is so configured;
+    CMSIS_VTOR_SetVectorTableLocation();
 
     // Initialize Clock Tree and SysTick at startup;
+    // This also sets the flash wait states and enables the ART caches.
     MCU_Clock_Tree_Default_Config();
 
     // Configure Microcontroller Clock Output
     MCU_Clock_MCO_Config();
 
+    // Start the 64-bit timebase on TIM2;
+    MCU_Timebase_Init();
+
     TRC_OnBoard_LED_Init();
     TRC_External_LED_Init();
     TRC_Initialize();
+    MCU_Clock_Subscribe(itm_clock_changed);
+    TRC_CLI_Init();
+
+    // The APB1 prescaler is 1, so TIM6 is clocked at PCLK1;
+    PROF_Init( MCU_Clock_Get_PCLK1_Frequency_Hz() );
+    MCU_Clock_Subscribe(prof_clock_changed);
+    PROF_CLI_Init();
+
+    IRQSTAT_Init();
+    IRQSTAT_CLI_Init();
+
+    MCU_Flash_CLI_Init();
+    MCU_Clock_Profile_CLI_Init();
+    MCU_Clock_Tree_Info_CLI_Init();
+    CMSIS_VTOR_CLI_Init();
+
+#if TICKLESS_ENABLE
+    // Sleep through the idle ticks, on LPTIM1; Stop 2 is allowed from the CLI.
+    MCU_Tickless_Init();
+    MCU_Tickless_CLI_Init();
+#endif
 
     USART_IT_CLI_Register_Rx_Callback(rx_data_avail_callback);
     USART_IT_CLI_Module_Init( MCU_Clock_Get_PCLK1_Frequency_Hz() );
+    MCU_Clock_Subscribe(usart_clock_changed);
 
     // -------------------------------------------------------------+-
     // Let's Begin!
@@ -316,6 +453,10 @@ int main( void )
 
     if( xQueue != NULL )
     {
+        // Name the queue for the trace; see core/swtrace/trc-rtos.h
+        vQueueAddToRegistry( xQueue, "RxQ" );
+        RTOS_TOP_Add_Queue( xQueue );
+
         // Start the two tasks as described in the comments at the top of this file.
         xTaskCreate(
             prvQueueReceiveTask,        /* The function that implements the task. */
@@ -335,6 +476,9 @@ int main( void )
             NULL
         );
 
+        // The report task of the 'top' command;
+        RTOS_TOP_Init();
+
         // Start the tasks and timer running.
         vTaskStartScheduler();
     }
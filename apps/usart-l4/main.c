@@ -22,6 +22,7 @@ SPDX-License-Identifier: MIT-0
 #include "core/swtrace/swtrace-led.h"
 #include "mcu/clock/mco.h"
 #include "mcu/clock/clock-tree-default-config.h"
+#include "mcu/clock/timebase.h"
 #include "platform/usart/usart-it-cli.h"
 #include "platform/cli/cli-api.h"
 
@@ -284,16 +285,16 @@ int main(void)
     // in_fptr = &in_shim;
     // out_fptr = &out_shim;
 
-    // TODO: Explain what's going on here.
-    // Refactor? Move?
-    LL_FLASH_SetLatency(LL_FLASH_LATENCY_1);
-
     // Initialize Clock Tree and SysTick at startup;
+    // This also sets the flash wait states and enables the ART caches.
     MCU_Clock_Tree_Default_Config();
 
     // Configure Microcontroller Clock Output
     MCU_Clock_MCO_Config();
 
+    // Start the 64-bit timebase on TIM2;
+    MCU_Timebase_Init();
+
     // Application specific init.
     SW_Trace_External_LED_Init();
     SW_Trace_OnBoard_LED_Init();
@@ -85,6 +85,12 @@ SPDX-License-Identifier: MIT-0
 #define  SW_DEBUG_EXTERNAL_YELLOW_LED_PERIPH  GPIOC
 #define  SW_DEBUG_EXTERNAL_YELLOW_LED_PIN     LL_GPIO_PIN_3
 
+// Together the four LEDs carry a 4-bit event marker, written with one store;
+// See core/swtrace/trc-led.h.  They must be consecutive pins of one port,
+// with red as the least significant bit of the marker code.
+#define  SW_DEBUG_MARKER_PERIPH               GPIOC
+#define  SW_DEBUG_MARKER_SHIFT                (0U)
+
 
 // -------------------------------------------------------------+-
 // Software Debug On-Board Green LED.
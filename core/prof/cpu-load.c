@@ -0,0 +1,160 @@
+
+/*
+================================================================================================#=
+CPU LOAD METER
+core/prof/cpu-load.c
+
+Description:
+    Measures the CPU load from the idle time; see cpu-load.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "core/prof/cpu-load.h"
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+_Static_assert((CPU_LOAD_AVERAGE_WINDOWS & (CPU_LOAD_AVERAGE_WINDOWS - 1)) == 0,
+    "CPU_LOAD_AVERAGE_WINDOWS must be a power of two");
+
+// All of the below is guarded with PRIMASK rather than BASEPRI,
+// so that the sample may be taken from any priority.
+
+// The current window;
+static uint32_t Window_Start = 0;
+static uint32_t Idle_Cycles  = 0;
+
+// The open idle span, if any;
+static uint32_t Idle_Start   = 0;
+static bool     In_Idle      = false;
+
+static CPU_LOAD_Stats Stats;
+
+// The average is kept scaled up, so that small changes are not lost;
+static uint32_t Average_Scaled = 0;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void CPU_LOAD_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Window_Start   = CPU_LOAD_CYCLES();
+    Idle_Cycles    = 0;
+    Average_Scaled = 0;
+    Stats = (CPU_LOAD_Stats){ 0 };
+    __set_PRIMASK(primask);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void CPU_LOAD_Idle_Begin(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Idle_Start = CPU_LOAD_CYCLES();
+    In_Idle    = true;
+    __set_PRIMASK(primask);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void CPU_LOAD_Idle_End(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (In_Idle)
+    {
+        Idle_Cycles += CPU_LOAD_CYCLES() - Idle_Start;
+        In_Idle      = false;
+    }
+    __set_PRIMASK(primask);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The first window is measured from initialization, and the average
+// starts from it, rather than ramping up from zero.
+// ---------------------------------------------------------------------------------------------+-
+void CPU_LOAD_Sample(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now     = CPU_LOAD_CYCLES();
+
+    // Split an open idle span at the window boundary;
+    if (In_Idle)
+    {
+        Idle_Cycles += now - Idle_Start;
+        Idle_Start   = now;
+    }
+
+    uint32_t window = now - Window_Start;
+    uint32_t idle   = Idle_Cycles;
+
+    Window_Start = now;
+    Idle_Cycles  = 0;
+
+    if (window == 0)
+    {
+        __set_PRIMASK(primask);
+        return;
+    }
+    if (idle > window) idle = window;
+
+    uint32_t load = 1000U - (uint32_t)(((uint64_t)idle * 1000U) / window);
+
+    if (Stats.windows == 0) {
+        Average_Scaled = load * CPU_LOAD_AVERAGE_WINDOWS;
+    }
+    else {
+        Average_Scaled = Average_Scaled - (Average_Scaled / CPU_LOAD_AVERAGE_WINDOWS) + load;
+    }
+
+    Stats.load    = load;
+    Stats.average = Average_Scaled / CPU_LOAD_AVERAGE_WINDOWS;
+    if (load > Stats.peak) Stats.peak = load;
+    Stats.windows++;
+    __set_PRIMASK(primask);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void CPU_LOAD_Get(CPU_LOAD_Stats *stats_out)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats_out = Stats;
+    __set_PRIMASK(primask);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void CPU_LOAD_Clear_Peak(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Stats.peak = Stats.load;
+    __set_PRIMASK(primask);
+    return;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+================================================================================================#=
+CPU LOAD METER
+core/prof/cpu-load.h
+
+Description:
+    Measures the fraction of time the CPU is busy, from the time it spends idle.
+
+    The idle code brackets itself with CPU_LOAD_Idle_Begin() and
+    CPU_LOAD_Idle_End(); the cycles in between, as counted by the DWT
+    cycle counter, are accumulated as idle time.  CPU_LOAD_Sample(), called
+    about once a second, e.g. from a timer or tick hook, closes a measurement
+    window and computes the load over it; i.e. the cycles of the window that
+    were not idle.  An idle span still open at the end of a window is split
+    between that window and the next.  The windows need not be of equal
+    length, but should be timed on elapsed time: with a tickless idle, the
+    tick hook is not called for the ticks slept through; so count the ticks
+    with xTaskGetTickCountFromISR(), rather than the calls.
+
+    Bare-metal: bracket the wait in the main loop; e.g. the polling for
+    the next event.  FreeRTOS: FreeRTOSConfig.h brackets every run of the
+    idle task, as it is switched in and out; see core/swtrace/trc-rtos.h.
+    Idle hook work, such as TRC_RTOS_Flush(), therefore counts as idle.
+
+    The cycle counter stops while the core sleeps, in WFI or WFE; so the idle
+    code measured here must either spin, or advance the counter by the time
+    asleep, as the tickless idle of mcu/power/tickless-idle.h does.  Sleep
+    not so accounted for would show up as neither busy nor idle, and the load
+    would read high.
+
+    The load is reported in per mille, for the last window, as an average,
+    and as the peak since last cleared.  The average is an exponential
+    moving average over about CPU_LOAD_AVERAGE_WINDOWS windows.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+//
+// The weight of the last window in the average is one in this many;
+// MUST be a power of two.
+// -----------------------------------------------------------------------------+-
+#ifndef CPU_LOAD_AVERAGE_WINDOWS
+#define CPU_LOAD_AVERAGE_WINDOWS (8U)
+#endif
+
+// The cycle counter; DWT->CYCCNT on the Cortex-M3/M4/M7;
+// It wraps every 53 seconds at 80 MHz, which bounds the window length.
+#ifndef CPU_LOAD_CYCLES
+#define CPU_LOAD_CYCLES() (*(volatile uint32_t *)0xE0001004UL)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// CPU load statistics; all in per mille;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  load;         // Over the last window;
+    uint32_t  average;      // Moving average over recent windows;
+    uint32_t  peak;         // Highest window since last cleared;
+    uint32_t  windows;      // Number of windows measured;
+
+}   CPU_LOAD_Stats;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// One-time startup initialization for the module;
+// Starts the DWT cycle counter and the first measurement window.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void CPU_LOAD_Init(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Mark the beginning and end of idle time;
+// An end without a matching begin is ignored.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void CPU_LOAD_Idle_Begin(void);
+extern void CPU_LOAD_Idle_End(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Close the current measurement window and start the next;
+// Call about once a second, from any context; windows longer than the wrap
+// time of the cycle counter are measured incorrectly.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void CPU_LOAD_Sample(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Report the load statistics;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void CPU_LOAD_Get(CPU_LOAD_Stats *stats_out);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Reset the peak load to that of the last window;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void CPU_LOAD_Clear_Peak(void);
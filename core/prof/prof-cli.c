@@ -0,0 +1,226 @@
+
+/*
+================================================================================================#=
+PROFILER CLI
+core/prof/prof-cli.c
+
+Description:
+    Command line interface to the PC-sampling profiler.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/prof/prof-cli.h"
+#include "core/prof/prof.h"
+
+#include "platform/cli/cli-cmd.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// -----------------------------------------------------------------------------+-
+// The histogram is dumped one page at a time so that each page fits
+// within the CLI response buffer; the slot of the next page is kept
+// between commands.
+// -----------------------------------------------------------------------------+-
+#ifndef PROF_CLI_PAGE_ENTRIES
+#define PROF_CLI_PAGE_ENTRIES (12U)
+#endif
+#define ENTRIES_PER_LINE (3U)
+
+// The number of hottest samples shown by the status command;
+#ifndef PROF_CLI_TOP_ENTRIES
+#define PROF_CLI_TOP_ENTRIES (5U)
+#endif
+
+static uint32_t Dump_Slot = PROF_HISTOGRAM_SIZE;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// prof
+// Show the status and the hottest samples; a selection pass per line
+// keeps this free of any sort buffer.
+// ---------------------------------------------------------------------------------------------+-
+static void prof_status(void)
+{
+    PROF_Status status;
+    PROF_Entry  entry;
+    PROF_Entry  top;
+    uint32_t    below = UINT32_MAX;
+
+    PROF_Get_Status(&status);
+
+    CLI_CMD_Printf("  %s at %lu Hz; %lu samples, %lu dropped, %lu of %u entries\n",
+        status.running ? "running" : "stopped",
+        (unsigned long)status.rate_hz,
+        (unsigned long)status.samples,
+        (unsigned long)status.dropped,
+        (unsigned long)status.entries,
+        PROF_HISTOGRAM_SIZE
+    );
+    if (status.samples == 0) return;
+
+    for (uint32_t rank=0; rank<PROF_CLI_TOP_ENTRIES; rank++)
+    {
+        top.count = 0;
+        for (uint32_t slot=PROF_Next_Entry(0, &entry); slot<PROF_HISTOGRAM_SIZE; slot=PROF_Next_Entry(slot+1, &entry))
+        {
+            if (entry.count < below && entry.count > top.count) top = entry;
+        }
+        if (top.count == 0) break;
+
+        CLI_CMD_Printf("  pc %08lx  lr %08lx  %6lu  %3lu%%\n",
+            (unsigned long)top.pc,
+            (unsigned long)top.lr,
+            (unsigned long)top.count,
+            (unsigned long)((top.count * 100ULL) / status.samples)
+        );
+        // Entries with equal counts after the first are not shown;
+        // this is a quick look, the dump is the full picture.
+        below = top.count;
+    }
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// prof dump|more
+//
+// The dump is line oriented so that it can be picked out of a captured
+// terminal session by tools/prof-report.
+// ---------------------------------------------------------------------------------------------+-
+static void prof_dump_page(void)
+{
+    PROF_Entry entry;
+    uint32_t   shown = 0;
+
+    while (shown < PROF_CLI_PAGE_ENTRIES && Dump_Slot < PROF_HISTOGRAM_SIZE)
+    {
+        char     line[4 + ENTRIES_PER_LINE * 29 + 2];
+        uint32_t line_len = 0;
+
+        line_len += snprintf(&line[line_len], sizeof(line) - line_len, "prof");
+        for (uint32_t col=0; col<ENTRIES_PER_LINE; col++)
+        {
+            Dump_Slot = PROF_Next_Entry(Dump_Slot, &entry);
+            if (Dump_Slot >= PROF_HISTOGRAM_SIZE) break;
+
+            line_len += snprintf(&line[line_len], sizeof(line) - line_len, " %08lx:%08lx:%lu",
+                (unsigned long)entry.pc, (unsigned long)entry.lr, (unsigned long)entry.count
+            );
+            Dump_Slot++;
+            shown++;
+        }
+        if (line_len > 4) CLI_CMD_Printf("%s\n", line);
+    }
+
+    if (Dump_Slot < PROF_HISTOGRAM_SIZE) {
+        CLI_CMD_Printf("  -- slot %lu of %u; 'prof more' to continue --\n",
+            (unsigned long)Dump_Slot, PROF_HISTOGRAM_SIZE
+        );
+    }
+    else {
+        CLI_CMD_Printf("prof-end\n");
+    }
+    return;
+}
+
+static void prof_dump_start(void)
+{
+    PROF_Status status;
+
+    // Sampling is stopped so that the pages are consistent;
+    PROF_Stop();
+    PROF_Get_Status(&status);
+    Dump_Slot = 0;
+
+    CLI_CMD_Printf("prof-rate %lu\n", (unsigned long)status.rate_hz);
+    CLI_CMD_Printf("prof-samples %lu %lu\n",
+        (unsigned long)status.samples, (unsigned long)status.dropped
+    );
+    prof_dump_page();
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// prof [start [hz]|stop|clear|dump|more]
+// ---------------------------------------------------------------------------------------------+-
+static void prof_cmd(int argc, char *argv[])
+{
+    if (argc == 1)
+    {
+        prof_status();
+        return;
+    }
+
+    if (argc <= 3 && strcmp(argv[1], "start") == 0)
+    {
+        uint32_t rate_hz = (argc == 3) ? strtoul(argv[2], NULL, 0) : PROF_DEFAULT_RATE_HZ;
+
+        if (!PROF_Start(rate_hz)) {
+            CLI_CMD_Printf("prof: rate must be 1 to %u Hz\n", PROF_MAX_RATE_HZ);
+        }
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "stop") == 0)
+    {
+        PROF_Stop();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "clear") == 0)
+    {
+        PROF_Clear();
+        Dump_Slot = PROF_HISTOGRAM_SIZE;
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "dump") == 0)
+    {
+        prof_dump_start();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "more") == 0)
+    {
+        prof_dump_page();
+        return;
+    }
+
+    CLI_CMD_Printf("usage: prof [start [hz]|stop|clear|dump|more]\n");
+    return;
+}
+
+static const CLI_CMD_Descriptor Prof_Cmd = {
+    .name    = "prof",
+    .help    = "run the PC-sampling profiler",
+    .handler = prof_cmd,
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void PROF_CLI_Init(void)
+{
+    CLI_CMD_Register(&Prof_Cmd);
+    return;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+/*
+================================================================================================#=
+PROFILER CLI
+core/prof/prof-cli.h
+
+Description:
+    Provides the 'prof' command to run the PC-sampling profiler
+    from the command line interface.
+
+        prof                show the profiler status and the hottest samples
+        prof start [hz]     start sampling; at 1000 Hz by default
+        prof stop           stop sampling
+        prof clear          empty the histogram
+        prof dump           stop sampling and dump the histogram for tools/prof-report
+        prof more           dump the next page of the histogram
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// One-time startup initialization for the module;
+// Registers the profiler command with the CLI.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void PROF_CLI_Init(void);
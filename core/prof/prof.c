@@ -0,0 +1,232 @@
+
+/*
+================================================================================================#=
+PROFILER
+core/prof/prof.c
+
+Description:
+    A statistical, PC-sampling profiler driven by TIM6 on the STM32L4.
+    See prof.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "core/prof/prof.h"
+
+#include <string.h>
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_bus.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_tim.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+_Static_assert((PROF_HISTOGRAM_SIZE & (PROF_HISTOGRAM_SIZE - 1)) == 0,
+    "PROF_HISTOGRAM_SIZE must be a power of two");
+
+// How far to probe for a free slot before dropping the sample;
+#define MAX_PROBES (8U)
+
+// The sampling timer counts at this rate;
+#define TIMER_TICK_HZ (1000000U)
+
+// Offsets, in words, of the stacked registers in the exception frame;
+#define FRAME_LR (5U)
+#define FRAME_PC (6U)
+
+static PROF_Entry Histogram[PROF_HISTOGRAM_SIZE];
+
+static volatile uint32_t Samples = 0;
+static volatile uint32_t Dropped = 0;
+static volatile uint32_t Entries = 0;
+
+static uint32_t Timer_Clock_Hz = 0;
+static uint32_t Rate_Hz        = 0;
+static bool     Running        = false;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Count the given {PC, LR} pair in the histogram;
+// Open addressing with linear probing; a PC of zero marks a free slot.
+// ---------------------------------------------------------------------------------------------+-
+static void count_sample(uint32_t pc, uint32_t lr)
+{
+    uint32_t slot = ((pc >> 1) ^ (lr * 0x9E3779B1U)) & (PROF_HISTOGRAM_SIZE - 1U);
+
+    for (uint32_t probe=0; probe<MAX_PROBES; probe++)
+    {
+        PROF_Entry *entry = &Histogram[slot];
+
+        if (entry->pc == pc && entry->lr == lr)
+        {
+            entry->count++;
+            Samples++;
+            return;
+        }
+        if (entry->pc == 0)
+        {
+            entry->pc    = pc;
+            entry->lr    = lr;
+            entry->count = 1;
+            Entries++;
+            Samples++;
+            return;
+        }
+        slot = (slot + 1U) & (PROF_HISTOGRAM_SIZE - 1U);
+    }
+    Dropped++;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Called from the TIM6 interrupt handler, below, with the address of the
+// exception frame of the interrupted code; not static, as it is the target
+// of a branch from inline assembly.
+// ---------------------------------------------------------------------------------------------+-
+void PROF_Sample_From_Frame(const uint32_t *frame)
+{
+    LL_TIM_ClearFlag_UPDATE(TIM6);
+
+    count_sample(frame[FRAME_PC], frame[FRAME_LR] & ~1U);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// TIM6 Interrupt Request
+// (An external interrupt from the Cortex-M4 vector table;)
+//
+// The exception frame is on the main stack if the interrupted code was
+// a handler, or on the process stack if it was a FreeRTOS task;
+// bit 2 of EXC_RETURN, in LR on entry, tells which.  The branch, rather
+// than a call, leaves EXC_RETURN in LR for the C function to return with.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+__attribute__((naked)) void TIM6_DAC_IRQHandler(void)
+{
+    __asm volatile(
+        "    tst   lr, #4                   \n"
+        "    ite   eq                       \n"
+        "    mrseq r0, msp                  \n"
+        "    mrsne r0, psp                  \n"
+        "    b     PROF_Sample_From_Frame   \n"
+    );
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void PROF_Init(uint32_t timer_clock_hz)
+{
+    Timer_Clock_Hz = timer_clock_hz;
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM6);
+
+    LL_TIM_DisableCounter(TIM6);
+    LL_TIM_SetPrescaler(TIM6, (Timer_Clock_Hz / TIMER_TICK_HZ) - 1U);
+    LL_TIM_EnableARRPreload(TIM6);
+    LL_TIM_EnableIT_UPDATE(TIM6);
+
+    NVIC_SetPriority(TIM6_DAC_IRQn, 0);
+    NVIC_EnableIRQ(TIM6_DAC_IRQn);
+
+    PROF_Clear();
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The prescaler is buffered; the update event loads it at once, and
+// restarts the sampling period.
+// ---------------------------------------------------------------------------------------------+-
+void PROF_Timer_Clock_Changed(uint32_t timer_clock_hz)
+{
+    Timer_Clock_Hz = timer_clock_hz;
+
+    LL_TIM_SetPrescaler(TIM6, (Timer_Clock_Hz / TIMER_TICK_HZ) - 1U);
+    LL_TIM_GenerateEvent_UPDATE(TIM6);
+    LL_TIM_ClearFlag_UPDATE(TIM6);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool PROF_Start(uint32_t rate_hz)
+{
+    if (rate_hz == 0 || rate_hz > PROF_MAX_RATE_HZ) return false;
+
+    Rate_Hz = rate_hz;
+
+    LL_TIM_DisableCounter(TIM6);
+    LL_TIM_SetAutoReload(TIM6, (TIMER_TICK_HZ / Rate_Hz) - 1U);
+    LL_TIM_SetCounter(TIM6, 0);
+    LL_TIM_GenerateEvent_UPDATE(TIM6);
+    LL_TIM_ClearFlag_UPDATE(TIM6);
+    LL_TIM_EnableCounter(TIM6);
+
+    Running = true;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void PROF_Stop(void)
+{
+    LL_TIM_DisableCounter(TIM6);
+    Running = false;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void PROF_Clear(void)
+{
+    NVIC_DisableIRQ(TIM6_DAC_IRQn);
+
+    memset(Histogram, 0, sizeof(Histogram));
+    Samples = 0;
+    Dropped = 0;
+    Entries = 0;
+
+    NVIC_EnableIRQ(TIM6_DAC_IRQn);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void PROF_Get_Status(PROF_Status *status_out)
+{
+    status_out->running = Running;
+    status_out->rate_hz = Rate_Hz;
+    status_out->samples = Samples;
+    status_out->dropped = Dropped;
+    status_out->entries = Entries;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t PROF_Next_Entry(uint32_t slot, PROF_Entry *entry_out)
+{
+    for ( ; slot<PROF_HISTOGRAM_SIZE; slot++)
+    {
+        if (Histogram[slot].pc != 0)
+        {
+            *entry_out = Histogram[slot];
+            return slot;
+        }
+    }
+    return PROF_HISTOGRAM_SIZE;
+}
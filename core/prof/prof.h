@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+================================================================================================#=
+PROFILER
+core/prof/prof.h
+
+Description:
+    A statistical, PC-sampling profiler.
+
+    A hardware timer (TIM6) interrupts the MCU at a configurable rate;
+    its handler reads the program counter (PC) and link register (LR)
+    from the exception stack frame of whatever code it interrupted,
+    and counts each distinct {PC, LR} pair in a hash histogram in RAM.
+
+    The PC identifies the function that was running; the LR usually
+    identifies its caller, which gives one level of call stack context.
+    (A function that has already pushed LR and called another may
+    show a stale LR; treat the caller as a hint.)
+
+    The timer interrupt runs at the highest NVIC priority, 0, above
+    configMAX_SYSCALL_INTERRUPT_PRIORITY, so that FreeRTOS critical sections,
+    which only mask interrupts via BASEPRI, are sampled as well; and above
+    the CLI USART, at USART_IT_CLI_IRQ_PRIORITY, so that the USART ISR and
+    the CLI commands are sampled too.  Code that runs with PRIMASK set,
+    or another interrupt at priority 0, is not sampled; its time is counted
+    against the instruction after it.  The handler does not call into FreeRTOS.
+
+    The histogram is inspected with the 'prof' CLI command and symbolized
+    on the host by tools/prof-report; see prof-cli.h.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+//
+// The number of histogram entries MUST be a power of two;
+// each entry takes 12 bytes of RAM.
+// -----------------------------------------------------------------------------+-
+#ifndef PROF_HISTOGRAM_SIZE
+#define PROF_HISTOGRAM_SIZE (512U)
+#endif
+
+#ifndef PROF_DEFAULT_RATE_HZ
+#define PROF_DEFAULT_RATE_HZ (1000U)
+#endif
+
+#ifndef PROF_MAX_RATE_HZ
+#define PROF_MAX_RATE_HZ (20000U)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// One histogram entry;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  pc;
+    uint32_t  lr;
+    uint32_t  count;
+
+}   PROF_Entry;
+
+// -----------------------------------------------------------------------------+-
+// Profiler status;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    bool      running;
+    uint32_t  rate_hz;
+    uint32_t  samples;      // Samples counted in the histogram;
+    uint32_t  dropped;      // Samples lost because the histogram was full;
+    uint32_t  entries;      // Distinct {PC, LR} pairs in the histogram;
+
+}   PROF_Status;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// One-time startup initialization for the module;
+// The given frequency is that of the clock feeding the sampling timer;
+// i.e. the APB1 timer clock.  The profiler is left stopped.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void PROF_Init(uint32_t timer_clock_hz);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Call when the clock feeding the sampling timer changes, e.g. from a clock
+// profile subscriber, with interrupts disabled; the sampling rate is kept.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void PROF_Timer_Clock_Changed(uint32_t timer_clock_hz);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Start sampling at the given rate, adding to the histogram;
+// Returns false if the rate is out of range.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool PROF_Start(uint32_t rate_hz);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Stop sampling; the histogram is kept.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void PROF_Stop(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Empty the histogram;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void PROF_Clear(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Report the profiler status;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void PROF_Get_Status(PROF_Status *status_out);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Get the next used histogram entry at or after the given slot;
+// Returns the slot of the entry found, or PROF_HISTOGRAM_SIZE if none.
+// Stop the profiler first for a consistent view.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t PROF_Next_Entry(uint32_t slot, PROF_Entry *entry_out);
@@ -0,0 +1,341 @@
+
+/*
+================================================================================================#=
+RTOS TOP
+core/prof/rtos-top.c
+
+Description:
+    The 'top' command and its report task; see rtos-top.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "core/prof/rtos-top.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "task.h"
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+#include "core/prof/cpu-load.h"
+
+#include "platform/cli/cli-cmd.h"
+#include "platform/usart/usart-it-cli.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+#if configGENERATE_RUN_TIME_STATS != 1 || configUSE_TRACE_FACILITY != 1
+#error "rtos-top needs configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY"
+#endif
+
+// Well within the wrap time of the run time counters;
+#define MAX_PERIOD_S    (30U)
+
+// How often the task looks for a request, and how long a single report measures;
+// The command runs above the FreeRTOS syscall priority and cannot notify the
+// task; it polls, but slowly, so as not to cut the tickless idle short.
+#define POLL_MS         (1000U)
+#define ONE_SHOT_MS     (1000U)
+
+#define LINE_SIZE       (80U)
+
+static TaskHandle_t Top_Task = NULL;
+
+// Set by the command handler;
+static volatile bool     Report_Requested = false;
+static volatile uint32_t Period_S         = 0;
+
+static QueueHandle_t Queues[RTOS_TOP_MAX_QUEUES];
+static uint32_t      Queue_Count = 0;
+
+// The current snapshot, and the run time counters of the last one;
+static TaskStatus_t Tasks[RTOS_TOP_MAX_TASKS];
+
+static struct
+{
+    UBaseType_t  number;
+    uint32_t     run_time;
+
+}   Last[RTOS_TOP_MAX_TASKS];
+
+static uint32_t Last_Count = 0;
+static uint32_t Last_Total = 0;
+
+static const char State_Char[] = {
+    [eRunning]   = 'X',
+    [eReady]     = 'R',
+    [eBlocked]   = 'B',
+    [eSuspended] = 'S',
+    [eDeleted]   = 'D',
+    [eInvalid]   = '?',
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Send one line of the report to the CLI;
+//
+// The response buffer is shared with the USART interrupt, whose priority
+// is above anything a FreeRTOS critical section masks; hence PRIMASK.
+// The task waits, a tick at a time, for room for the whole line.
+// ---------------------------------------------------------------------------------------------+-
+static void top_printf(const char *format_string, ...)
+    __attribute__((format(printf, 1, 2)));
+
+static void top_printf(const char *format_string, ...)
+{
+    char    line[LINE_SIZE];
+    int     num_chars;
+    va_list argptr;
+
+    va_start(argptr, format_string);
+    num_chars = vsnprintf(line, sizeof(line), format_string, argptr);
+    va_end(argptr);
+
+    if (num_chars < 0) return;
+    if (num_chars >= sizeof(line)) num_chars = sizeof(line) - 1;
+
+    for (;;)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        bool room = USART_IT_CLI_Response_Slots_Available() >= (uint32_t)num_chars;
+        if (room) USART_IT_CLI_Put_Response((uint8_t *)line, (uint8_t)num_chars);
+
+        __set_PRIMASK(primask);
+
+        if (room) return;
+        vTaskDelay(1);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The run time counter of the given task in the last snapshot;
+// Zero for a task created since, so that its whole run time is counted.
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t last_run_time(UBaseType_t number)
+{
+    for (uint32_t idx=0; idx<Last_Count; idx++)
+    {
+        if (Last[idx].number == number) return Last[idx].run_time;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Print a per mille value as a percentage;
+// ---------------------------------------------------------------------------------------------+-
+#define PERCENT(_pm_) (unsigned long)((_pm_) / 10U), (unsigned long)((_pm_) % 10U)
+
+// ---------------------------------------------------------------------------------------------+-
+// Take a snapshot of the tasks, and optionally report on the time since the last one;
+// ---------------------------------------------------------------------------------------------+-
+static void snapshot(bool report)
+{
+    uint32_t    total;
+    UBaseType_t count = uxTaskGetSystemState(Tasks, RTOS_TOP_MAX_TASKS, &total);
+
+    if (count == 0)
+    {
+        if (report) top_printf("top: more than %u tasks\n", RTOS_TOP_MAX_TASKS);
+        return;
+    }
+
+    // Sort by task number, so that the rows keep their order between reports;
+    for (UBaseType_t idx=1; idx<count; idx++)
+    {
+        TaskStatus_t task = Tasks[idx];
+        UBaseType_t  pos  = idx;
+
+        while (pos > 0 && Tasks[pos-1].xTaskNumber > task.xTaskNumber)
+        {
+            Tasks[pos] = Tasks[pos-1];
+            pos--;
+        }
+        Tasks[pos] = task;
+    }
+
+    if (report)
+    {
+        CPU_LOAD_Stats load;
+        uint32_t       elapsed = total - Last_Total;
+
+        CPU_LOAD_Get(&load);
+        top_printf("cpu %lu.%lu%%  avg %lu.%lu%%  peak %lu.%lu%%  heap %u free\n",
+            PERCENT(load.load), PERCENT(load.average), PERCENT(load.peak),
+            (unsigned)xPortGetFreeHeapSize()
+        );
+        top_printf("  #  %-*s st pri   cpu%%  stack\n", configMAX_TASK_NAME_LEN, "name");
+
+        for (UBaseType_t idx=0; idx<count; idx++)
+        {
+            const TaskStatus_t *task  = &Tasks[idx];
+            uint32_t            delta = task->ulRunTimeCounter - last_run_time(task->xTaskNumber);
+            uint32_t            share = elapsed ? (uint32_t)(((uint64_t)delta * 1000U) / elapsed) : 0;
+
+            top_printf("%3lu  %-*s  %c %3lu  %3lu.%lu  %5u\n",
+                (unsigned long)task->xTaskNumber,
+                configMAX_TASK_NAME_LEN, task->pcTaskName,
+                State_Char[task->eCurrentState],
+                (unsigned long)task->uxCurrentPriority,
+                PERCENT(share),
+                (unsigned)task->usStackHighWaterMark
+            );
+        }
+
+        for (uint32_t idx=0; idx<Queue_Count; idx++)
+        {
+            UBaseType_t waiting = uxQueueMessagesWaiting(Queues[idx]);
+            UBaseType_t length  = waiting + uxQueueSpacesAvailable(Queues[idx]);
+            const char *name    = pcQueueGetName(Queues[idx]);
+
+            top_printf("queue %-8s %lu/%lu\n",
+                name ? name : "-", (unsigned long)waiting, (unsigned long)length
+            );
+        }
+    }
+
+    for (UBaseType_t idx=0; idx<count; idx++)
+    {
+        Last[idx].number   = Tasks[idx].xTaskNumber;
+        Last[idx].run_time = Tasks[idx].ulRunTimeCounter;
+    }
+    Last_Count = count;
+    Last_Total = total;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The report task;
+//
+// A requested report measures from a fresh snapshot, since the last one
+// may be older than the wrap time of the counters; periodic reports follow,
+// each measuring from the one before.  The task sleeps until the next
+// periodic report is due, or for POLL_MS if that is sooner.
+// ---------------------------------------------------------------------------------------------+-
+static void top_task(void *params)
+{
+    TickType_t last_report = xTaskGetTickCount();
+
+    (void)params;
+
+    for (;;)
+    {
+        TickType_t wait     = pdMS_TO_TICKS(POLL_MS);
+        uint32_t   period_s = Period_S;
+
+        if (period_s != 0)
+        {
+            TickType_t since  = xTaskGetTickCount() - last_report;
+            TickType_t period = pdMS_TO_TICKS(period_s * 1000U);
+            TickType_t due    = (since < period) ? (period - since) : 0;
+
+            if (due < wait) wait = due;
+        }
+        if (wait > 0) vTaskDelay(wait);
+
+        if (Report_Requested)
+        {
+            Report_Requested = false;
+            snapshot(false);
+            vTaskDelay(pdMS_TO_TICKS(ONE_SHOT_MS));
+            snapshot(true);
+            last_report = xTaskGetTickCount();
+            continue;
+        }
+
+        period_s = Period_S;
+
+        if (period_s != 0 && (xTaskGetTickCount() - last_report) >= pdMS_TO_TICKS(period_s * 1000U))
+        {
+            snapshot(true);
+            last_report = xTaskGetTickCount();
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// top [secs|off]
+// ---------------------------------------------------------------------------------------------+-
+static void top_cmd(int argc, char *argv[])
+{
+    char *end;
+
+    if (Top_Task == NULL)
+    {
+        CLI_CMD_Printf("top: the report task is not running\n");
+        return;
+    }
+
+    if (argc == 1)
+    {
+        Report_Requested = true;
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "off") == 0)
+    {
+        Period_S = 0;
+        return;
+    }
+
+    if (argc == 2)
+    {
+        uint32_t secs = strtoul(argv[1], &end, 0);
+
+        if (*end == '\0' && secs >= 1 && secs <= MAX_PERIOD_S)
+        {
+            Period_S         = secs;
+            Report_Requested = true;
+            return;
+        }
+    }
+
+    CLI_CMD_Printf("usage: top [secs|off]; every 1 to %u secs\n", MAX_PERIOD_S);
+    return;
+}
+
+static const CLI_CMD_Descriptor Top_Cmd = {
+    .name    = "top",
+    .help    = "show the CPU load and task statistics",
+    .handler = top_cmd,
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void RTOS_TOP_Init(void)
+{
+    xTaskCreate(top_task, "top", RTOS_TOP_TASK_STACK_SIZE, NULL, RTOS_TOP_TASK_PRIORITY, &Top_Task);
+    CLI_CMD_Register(&Top_Cmd);
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool RTOS_TOP_Add_Queue(QueueHandle_t queue)
+{
+    if (Queue_Count >= RTOS_TOP_MAX_QUEUES) return false;
+
+    Queues[Queue_Count++] = queue;
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+================================================================================================#=
+RTOS TOP
+core/prof/rtos-top.h
+
+Description:
+    Provides the 'top' command, which shows the CPU load, and for each
+    FreeRTOS task its share of the CPU, state, priority and stack high-water
+    mark, along with the depth of each watched queue.
+
+        top                 show one report, measured over the next second
+        top <secs>          show a report every 1 to 30 seconds
+        top off             stop the periodic reports
+
+    A task's share of the CPU is taken from the FreeRTOS run-time statistics,
+    which count DWT cycles; see FreeRTOSConfig.h.  The counters wrap every
+    53 seconds at 80 MHz, so reports are made from the change between
+    snapshots no more than 30 seconds apart.  The overall load is that of
+    core/prof/cpu-load.h, sampled once a second.
+
+    The stack column is the least free stack the task has had, in words.
+    The states are: X running, R ready, B blocked, S suspended, D deleted.
+
+    The CLI command handlers run in the USART interrupt, above the FreeRTOS
+    syscall priority; the handler only sets the request, and a low priority
+    task makes the reports.  The task waits for room in the CLI response
+    buffer before each line, rather than drop output.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// -----------------------------------------------------------------------------+-
+
+// The number of tasks shown; others are counted but not shown;
+#ifndef RTOS_TOP_MAX_TASKS
+#define RTOS_TOP_MAX_TASKS (8U)
+#endif
+
+// The number of queues that can be watched;
+#ifndef RTOS_TOP_MAX_QUEUES
+#define RTOS_TOP_MAX_QUEUES (4U)
+#endif
+
+#ifndef RTOS_TOP_TASK_PRIORITY
+#define RTOS_TOP_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#endif
+
+// In words; enough for the report formatting;
+#ifndef RTOS_TOP_TASK_STACK_SIZE
+#define RTOS_TOP_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 6)
+#endif
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// One-time startup initialization for the module;
+// Creates the report task and registers the command with the CLI.
+// Call before the scheduler is started.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void RTOS_TOP_Init(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Show the depth of the given queue in the reports;
+// Its name is taken from the queue registry, if it is registered.
+// Returns false if the queue table is full.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool RTOS_TOP_Add_Queue(QueueHandle_t queue);
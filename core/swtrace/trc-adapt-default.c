@@ -13,19 +13,281 @@ SPDX-License-Identifier: MIT-0
 
 #include "core/swtrace/trc-adaptation.h"
 
+#include <stdio.h>
 
+#include "core/swtrace/trc-flightrec.h"
+#include "core/swtrace/trc-frame.h"
+#include "core/swtrace/trc-lz.h"
+#include "core/swtrace/trc-sink-itm.h"
+#include "mcu/clock/cmsis-clock.h"
 #include "platform/usart/usart-it-cli.h"
 
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_rcc.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------+-
+// Map each trace level onto a USART CLI trace lane;
+// ERROR and FATAL get their own lane so they are never queued
+// behind, nor crowded out by, a flood of INFO and DEBUG.
+// ---------------------------------------------------------------------+-
+static const USART_IT_CLI_Trace_Lane Level_To_Lane[trcLvlNone] = {
+    [trcLvlDebug] = USART_IT_CLI_Trace_Lane_Low,
+    [trcLvlInfo]  = USART_IT_CLI_Trace_Lane_Low,
+    [trcLvlError] = USART_IT_CLI_Trace_Lane_High,
+    [trcLvlFatal] = USART_IT_CLI_Trace_Lane_High,
+};
+
+static const char* Lane_Names[USART_IT_CLI_Trace_Lane_NumOf] = {
+    [USART_IT_CLI_Trace_Lane_High] = "high",
+    [USART_IT_CLI_Trace_Lane_Low]  = "low",
+};
+
+// ---------------------------------------------------------------------+-
+// Number of dropped messages already reported in-band, per lane;
+// ---------------------------------------------------------------------+-
+static uint32_t Reported_Drops[USART_IT_CLI_Trace_Lane_NumOf];
+
+// ---------------------------------------------------------------------+-
+// FATAL handling;
+//
+// When enabled, a FATAL message resets the MCU once the message has had
+// a chance to drain from the high priority lane; the drain is bounded
+// because the USART interrupt cannot run if the FATAL was raised from
+// an interrupt of equal or higher priority.
+// ---------------------------------------------------------------------+-
+#ifndef TRC_ADAPT_FATAL_RESET
+#define TRC_ADAPT_FATAL_RESET 1
+#endif
+
+#ifndef TRC_ADAPT_FATAL_DRAIN_SPINS
+#define TRC_ADAPT_FATAL_DRAIN_SPINS (2000000U)
+#endif
+
+// ---------------------------------------------------------------------+-
+// ITM/SWO sinks;
+//
+// The initial level of the ITM text sink; trcLvlNone leaves it off
+// until enabled from the CLI, e.g. 'trc sink itm debug', which, along
+// with 'trc sink usart none', moves the trace off the CLI USART entirely.
+// The SWO bit rate must match that of the capturing debug probe.
+// ---------------------------------------------------------------------+-
+#ifndef TRC_ADAPT_ITM_LEVEL
+#define TRC_ADAPT_ITM_LEVEL trcLvlNone
+#endif
+
+#ifndef TRC_ADAPT_SWO_BIT_RATE
+#define TRC_ADAPT_SWO_BIT_RATE (2000000U)
+#endif
+
+// ---------------------------------------------------------------------+-
+// Reset flags in the RCC CSR register, most telling first;
+// Note that the pin flag is set by every reset, since any internal
+// reset source also drives the NRST pin.
+// ---------------------------------------------------------------------+-
+static const struct
+{
+    uint32_t    mask;
+    const char *name;
+
+}   Reset_Causes[] = {
+    { RCC_CSR_LPWRRSTF, "low-power"  },
+    { RCC_CSR_WWDGRSTF, "wwdg"       },
+    { RCC_CSR_IWDGRSTF, "iwdg"       },
+    { RCC_CSR_SFTRSTF,  "software"   },
+    { RCC_CSR_FWRSTF,   "firewall"   },
+    { RCC_CSR_OBLRSTF,  "option-byte"},
+    { RCC_CSR_BORRSTF,  "brown-out"  },
+    { RCC_CSR_PINRSTF,  "pin"        },
+};
+#define NUM_RESET_CAUSES (sizeof(Reset_Causes)/sizeof(Reset_Causes[0]))
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------+-
+// If messages were dropped from the given lane since the last report,
+// and there is now room for it, tell the reader about it in-band.
+// ---------------------------------------------------------------------+-
+static void report_lane_drops(USART_IT_CLI_Trace_Lane lane)
+{
+    char     notice[48];
+    uint32_t dropped = USART_IT_CLI_Trace_Dropped_Count(lane);
+
+    if(dropped == Reported_Drops[lane]) return;
+
+    int notice_len = snprintf(notice, sizeof(notice),
+        "trc: %lu %s priority messages lost\n",
+        (unsigned long)(dropped - Reported_Drops[lane]),
+        Lane_Names[lane]
+    );
+    if(notice_len <= 0 || notice_len >= sizeof(notice)) return;
+
+    // Only report when the notice itself will not be dropped;
+    if(USART_IT_CLI_Trace_Slots_Available(lane) < notice_len) return;
+
+    USART_IT_CLI_Put_Trace(lane, (uint8_t *)notice, notice_len);
+    Reported_Drops[lane] = dropped;
+}
+
+
+// ---------------------------------------------------------------------+-
+// USART text sink;
+// Writes the content of each record, as is, to the lane for its level.
+// ---------------------------------------------------------------------+-
+static bool usart_text_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    if(record->level >= trcLvlNone) return false;
+
+    USART_IT_CLI_Trace_Lane lane = Level_To_Lane[record->level];
+
+    report_lane_drops(lane);
+
+    // The USART CLI accepts at most UINT8_MAX bytes per message;
+    uint32_t msg_len = record->msg_len;
+    if(msg_len > UINT8_MAX) msg_len = UINT8_MAX;
+
+    return USART_IT_CLI_Put_Trace(lane, (uint8_t *)record->msg, msg_len);
+};
+
+// ---------------------------------------------------------------------+-
+// USART binary sink;
+// Writes each record as a binary frame to the lane for its level;
+// see trc-frame.h.  Off by default, since the frames are not meant
+// for a terminal; enable it, and disable the text sink, with the CLI.
+// ---------------------------------------------------------------------+-
+static uint8_t Frame_Buffer[UINT8_MAX];
+
+static bool usart_binary_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    if(record->level >= trcLvlNone) return false;
+
+    uint32_t frame_len = TRC_Frame_Encode(record, Frame_Buffer, sizeof(Frame_Buffer));
+    if(frame_len == 0) return false;
+
+    return USART_IT_CLI_Put_Trace(Level_To_Lane[record->level], Frame_Buffer, frame_len);
+};
+
+// ---------------------------------------------------------------------+-
+// USART compressed sink;
+// Writes each record as a binary frame compressed into a block;
+// see trc-lz.h and tools/trc-lz-decode.  For when the bit rate of the
+// link cannot be raised; off by default, like the binary sink; e.g.
+// 'trc sink usart-lz debug' and 'trc sink usart none'.
+//
+// The high priority lane preempts the low one at message boundaries,
+// so that its blocks may reach the host out of order; they are sent
+// stored, and only the low priority lane is compressed.
+// A block that is dropped makes the encoder start afresh.
+// ---------------------------------------------------------------------+-
+// Frames are cut to this, so that even a block of all literals
+// fits in one message;
+#define LZ_FRAME_MAX (240U)
+
+static TRC_LZ_Encoder Lz_Encoder;
+static uint8_t        Lz_Block[UINT8_MAX];
+
+_Static_assert(TRC_LZ_BLOCK_MAX(LZ_FRAME_MAX) <= sizeof(Lz_Block),
+    "LZ_FRAME_MAX is too long for the compressed block");
+
+static bool usart_lz_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    uint32_t block_len;
+
+    if(record->level >= trcLvlNone) return false;
+
+    USART_IT_CLI_Trace_Lane lane = Level_To_Lane[record->level];
+
+    uint32_t frame_len = TRC_Frame_Encode(record, Frame_Buffer, LZ_FRAME_MAX);
+    if(frame_len == 0) return false;
+
+    if(lane == USART_IT_CLI_Trace_Lane_High) {
+        block_len = TRC_LZ_Encode_Stored(Frame_Buffer, frame_len, Lz_Block, sizeof(Lz_Block));
+    }
+    else {
+        block_len = TRC_LZ_Encode(&Lz_Encoder, Frame_Buffer, frame_len, Lz_Block, sizeof(Lz_Block));
+    }
+    if(block_len == 0) return false;
+
+    bool sent = USART_IT_CLI_Put_Trace(lane, Lz_Block, block_len);
+    if(!sent && lane != USART_IT_CLI_Trace_Lane_High) TRC_LZ_Discard(&Lz_Encoder);
+
+    return sent;
+};
+
+// ---------------------------------------------------------------------+-
+// The USART sinks share the same lanes;
+// ---------------------------------------------------------------------+-
+static uint32_t usart_sink_occupancy(TRC_Sink *sink, trcLvl level)
+{
+    if(level >= trcLvlNone) return 0;
+
+    return USART_IT_CLI_Trace_Occupancy_Percent(Level_To_Lane[level]);
+};
+
+static TRC_Sink Usart_Text_Sink = {
+    .name      = "usart",
+    .write     = usart_text_sink_write,
+    .occupancy = usart_sink_occupancy,
+    .min_level = trcLvlDebug,
+};
+
+static TRC_Sink Usart_Binary_Sink = {
+    .name      = "usart-bin",
+    .write     = usart_binary_sink_write,
+    .occupancy = usart_sink_occupancy,
+    .min_level = trcLvlNone,
+    .binary    = true,
+};
+
+static TRC_Sink Usart_Lz_Sink = {
+    .name      = "usart-lz",
+    .write     = usart_lz_sink_write,
+    .occupancy = usart_sink_occupancy,
+    .min_level = trcLvlNone,
+    .binary    = true,
+};
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------+-
+uint32_t TRC_Adapt_Get_Lane_Stats(TRC_Adapt_Lane_Stats *stats_out, uint32_t max_lanes)
+{
+    uint32_t lane;
+
+    for(lane=0; lane<USART_IT_CLI_Trace_Lane_NumOf && lane<max_lanes; lane++)
+    {
+        stats_out[lane].name    = Lane_Names[lane];
+        stats_out[lane].queued  = USART_IT_CLI_Trace_Queued_Count(lane);
+        stats_out[lane].dropped = USART_IT_CLI_Trace_Dropped_Count(lane);
+    }
+    return lane;
+};
 
 
 // ---------------------------------------------------------------------+-
-bool TRC_Dispatch_Message(uint8_t *given_msg, uint32_t msg_len)
+// Timestamps are taken from the DWT cycle counter; i.e. they count
+// core clock cycles and wrap every 53 seconds or so at 80 MHz.
+// ---------------------------------------------------------------------+-
+uint32_t TRC_Adapt_Timestamp(void)
 {
-    if(USART_IT_CLI_Trace_Slots_Available() < msg_len) return false;
+    return DWT->CYCCNT;
+};
 
-    USART_IT_CLI_Put_Trace(given_msg, msg_len);
 
-    return true;
+uint32_t TRC_Adapt_Timestamp_Hz(void)
+{
+    return SystemCoreClock;
 };
 
 
@@ -34,10 +296,81 @@ bool TRC_Dispatch_Message(uint8_t *given_msg, uint32_t msg_len)
 // ---------------------------------------------------------------------+-
 void TRC_Adapt_Init(void)
 {
+    char     notice[80];
+    uint32_t reset_flags = 0;
+
+    // Start the cycle counter for the timestamps; never reset it, as the
+    // spans, irqstat, the cpu load and the run-time stats all share it.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // Latch, and then clear, the reason for this reset;
+    for(uint32_t idx=0; idx<NUM_RESET_CAUSES; idx++) {
+        reset_flags |= (RCC->CSR & Reset_Causes[idx].mask);
+    }
+    LL_RCC_ClearResetFlags();
+
+    TRC_FlightRec_Init(reset_flags);
+
+    TRC_Sink_Register(&Usart_Text_Sink);
+    TRC_Sink_Register(&Usart_Binary_Sink);
+
+    TRC_LZ_Init(&Lz_Encoder);
+    TRC_Sink_Register(&Usart_Lz_Sink);
+
+    TRC_Sink_Register(&TRC_FlightRec_Sink);
+
+    // Claims the SWO pin only with a debugger attached; TRCENA, set above
+    // for the cycle counter, says nothing about that.
+    TRC_Sink_ITM_Configure_SWO(SystemCoreClock, TRC_ADAPT_SWO_BIT_RATE);
+    TRC_Sink_ITM_Text.min_level = TRC_ADAPT_ITM_LEVEL;
+    TRC_Sink_Register(&TRC_Sink_ITM_Text);
+    TRC_Sink_Register(&TRC_Sink_ITM_Binary);
+
+    // Let the reader know there is a record of the previous session;
+    TRC_FlightRec_Info prev;
+    if(!TRC_FlightRec_Get_Previous(&prev)) return;
+
+    int notice_len = snprintf(notice, sizeof(notice),
+        "trc: boot %lu ended by %s reset%s; %lu bytes recorded; see 'trc dump'\n",
+        (unsigned long)prev.boot_count,
+        TRC_Adapt_Reset_Cause_Name(prev.end_reset),
+        prev.fatal ? " after FATAL" : "",
+        (unsigned long)prev.length
+    );
+    if(notice_len <= 0 || notice_len >= sizeof(notice)) return;
+
+    TRC_Sink_Dispatch_Text(trcLvlInfo, notice, notice_len);
+};
+
+
+// ---------------------------------------------------------------------+-
+// Default implementation of the FATAL handler;
+// ---------------------------------------------------------------------+-
+void TRC_Adapt_Fatal(void)
+{
+    TRC_FlightRec_Mark_Fatal();
+
+#if TRC_ADAPT_FATAL_RESET
+    for(volatile uint32_t spin=0; spin<TRC_ADAPT_FATAL_DRAIN_SPINS; spin++) {
+        if(USART_IT_CLI_Trace_Is_Empty(USART_IT_CLI_Trace_Lane_High)) break;
+    }
+    NVIC_SystemReset();
+#endif
     return;
 };
 
 
+// ---------------------------------------------------------------------+-
+const char *TRC_Adapt_Reset_Cause_Name(uint32_t reset_flags)
+{
+    for(uint32_t idx=0; idx<NUM_RESET_CAUSES; idx++) {
+        if(reset_flags & Reset_Causes[idx].mask) return Reset_Causes[idx].name;
+    }
+    return "unknown";
+};
+
+
 
 
 
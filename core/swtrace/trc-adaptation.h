@@ -15,24 +15,70 @@ SPDX-License-Identifier: MIT-0
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "trc.h"
+#include "trc-sink.h"
+
 
 
 // ---------------------------------------------------------------------+-
-// A function to do the needful with the given trace message.
-// It's up to the adaptation to decide what that means
-// but, typically, it means writing the message to a local serial port.
-// 
-// This should be implemented by
-// an adaptation sub-module suitable for the target platform.
+// One-time startup initialization of the adaptation;
+//
+// Called by TRC_Initialize(); this is where the adaptation registers
+// the trace sinks suitable for the target platform; see trc-sink.h.
 // ---------------------------------------------------------------------+-
-bool TRC_Dispatch_Message(
-    uint8_t  *trace_message,
-    uint32_t  trace_messageLen );
+void TRC_Adapt_Init(void);
 
 
 // ---------------------------------------------------------------------+-
+// Returns the current time, in units chosen by the adaptation,
+// for the timestamp of each trace record.
 // ---------------------------------------------------------------------+-
-void TRC_Adapt_Init(void);
+uint32_t TRC_Adapt_Timestamp(void);
+
+// ---------------------------------------------------------------------+-
+// Returns the rate at which the timestamps, and the span cycle counts,
+// advance; in ticks per second.
+// ---------------------------------------------------------------------+-
+uint32_t TRC_Adapt_Timestamp_Hz(void);
+
+
+// ---------------------------------------------------------------------+-
+// Called by the trace core after a FATAL message has been dispatched.
+//
+// It's up to the adaptation to decide what happens next but, typically,
+// it means recording the fatal event where it will survive a reset,
+// giving the message a chance to drain, and then resetting the MCU;
+// in which case this function does not return.
+// ---------------------------------------------------------------------+-
+void TRC_Adapt_Fatal(void);
+
+
+// ---------------------------------------------------------------------+-
+// Returns a printable name for the given MCU reset flags,
+// as recorded by the flight recorder; see trc-flightrec.h.
+// ---------------------------------------------------------------------+-
+const char *TRC_Adapt_Reset_Cause_Name(uint32_t reset_flags);
+
+
+// ---------------------------------------------------------------------+-
+// Backend statistics;
+//
+// An adaptation may queue trace messages in one or more lanes,
+// typically one lane per group of trace levels.  This reports the number
+// of messages queued to, and dropped from, each lane since startup.
+// Fills in at most max_lanes entries and returns the number filled in.
+// ---------------------------------------------------------------------+-
+typedef struct
+{
+    const char *name;
+    uint32_t    queued;
+    uint32_t    dropped;
+
+}   TRC_Adapt_Lane_Stats;
+
+uint32_t TRC_Adapt_Get_Lane_Stats(
+    TRC_Adapt_Lane_Stats *stats_out,
+    uint32_t              max_lanes );
 
 
 
@@ -0,0 +1,453 @@
+
+/*
+================================================================================================#=
+TRACE CLI
+core/swtrace/trc-cli.c
+
+Description:
+    Command line interface to the software trace facility.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#define TRC_MODULE trcModTrace
+#include "trc-cli.h"
+#include "trc-core.h"
+#include "trc-adaptation.h"
+#include "trc-throttle.h"
+#include "trc-flightrec.h"
+#include "trc-sink.h"
+#include "trc-span.h"
+#include "trc-rtos.h"
+
+#include "platform/cli/cli-cmd.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// -----------------------------------------------------------------------------+-
+// The flight recorder is dumped one page at a time so that each page
+// fits within the CLI response buffer; the offset of the next page
+// is kept between commands.
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_CLI_DUMP_PAGE_SIZE
+#define TRC_CLI_DUMP_PAGE_SIZE (320U)
+#endif
+#define DUMP_CHUNK_SIZE (64U)
+
+static uint32_t Dump_Offset = 0;
+
+// -----------------------------------------------------------------------------+-
+// Likewise, the span snapshot is dumped a page at a time;
+// the page is kept short since each event takes 18 characters.
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_CLI_SPAN_PAGE_EVENTS
+#define TRC_CLI_SPAN_PAGE_EVENTS (16U)
+#endif
+#define SPAN_EVENTS_PER_LINE (4U)
+
+static uint32_t Span_Dump_Index = 0;
+static uint32_t Span_Dump_Len   = 0;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Whether messages of the given level are built in, per TRC_ENABLE_LVL_*;
+// The CLI is built with the same settings as the rest of the application.
+// ---------------------------------------------------------------------------------------------+-
+static bool level_is_built_in(trcLvl level)
+{
+    switch (level)
+    {
+        case trcLvlDebug: return TRC_ENABLE_LVL_DEBUG == 1;
+        case trcLvlInfo:  return TRC_ENABLE_LVL_INFO  == 1;
+        case trcLvlError: return TRC_ENABLE_LVL_ERROR == 1;
+        default:          return true;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// trc level [[module] level]
+// ---------------------------------------------------------------------------------------------+-
+static void trc_level_cmd(int argc, char *argv[])
+{
+    trcMod module;
+    trcLvl level;
+
+    if (argc == 2)
+    {
+        for (uint32_t mod=0; mod<trcModNumOf; mod++)
+        {
+            CLI_CMD_Printf("  %-8s %s\n",
+                TRC_GetModuleName((trcMod)mod),
+                TRC_GetLevelName(TRC_GetModuleLogLevel((trcMod)mod))
+            );
+        }
+        if (!level_is_built_in(trcLvlDebug)) {
+            CLI_CMD_Printf("  (debug messages are compiled out of this build)\n");
+        }
+        return;
+    }
+
+    if (!TRC_LookupLevel(argv[argc-1], &level))
+    {
+        CLI_CMD_Printf("trc: unknown level: %s\n", argv[argc-1]);
+        return;
+    }
+
+    if (argc == 3)
+    {
+        TRC_SetLogLevel(level);
+    }
+    else if (TRC_LookupModule(argv[2], &module))
+    {
+        TRC_SetModuleLogLevel(module, level);
+    }
+    else
+    {
+        CLI_CMD_Printf("trc: unknown module: %s\n", argv[2]);
+        return;
+    }
+
+    if (!level_is_built_in(level))
+    {
+        CLI_CMD_Printf("trc: %s messages are compiled out of this build; see TRC_ENABLE_LVL_* in trc.h\n",
+            TRC_GetLevelName(level));
+    }
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// trc stats
+// ---------------------------------------------------------------------------------------------+-
+static void trc_stats_cmd(int argc, char *argv[])
+{
+    TRC_Adapt_Lane_Stats lane_stats[4];
+    uint32_t num_lanes = TRC_Adapt_Get_Lane_Stats(lane_stats, 4);
+
+    CLI_CMD_Printf("  %-8s %10s %10s\n", "lane", "queued", "dropped");
+    for (uint32_t lane=0; lane<num_lanes; lane++)
+    {
+        CLI_CMD_Printf("  %-8s %10lu %10lu\n",
+            lane_stats[lane].name,
+            (unsigned long)lane_stats[lane].queued,
+            (unsigned long)lane_stats[lane].dropped
+        );
+    }
+
+    TRC_Throttle_Stats throttle;
+    TRC_Throttle_Get_Stats(&throttle);
+
+    CLI_CMD_Printf("  throttle: %s; suppressed %lu debug, %lu info, %lu repeats\n",
+        (throttle.throttle_level == trcLvlDebug) ? "off" : TRC_GetLevelName(throttle.throttle_level),
+        (unsigned long)throttle.suppressed[trcLvlDebug],
+        (unsigned long)throttle.suppressed[trcLvlInfo],
+        (unsigned long)throttle.repeats
+    );
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// trc sink [name level]
+// ---------------------------------------------------------------------------------------------+-
+static void trc_sink_cmd(int argc, char *argv[])
+{
+    if (argc == 2)
+    {
+        CLI_CMD_Printf("  %-10s %-6s %10s %10s\n", "sink", "level", "delivered", "dropped");
+        for (uint32_t idx=0; idx<TRC_Sink_Count(); idx++)
+        {
+            TRC_Sink *sink = TRC_Sink_Get(idx);
+            CLI_CMD_Printf("  %-10s %-6s %10lu %10lu\n",
+                sink->name,
+                TRC_GetLevelName(sink->min_level),
+                (unsigned long)sink->delivered,
+                (unsigned long)sink->dropped
+            );
+        }
+        return;
+    }
+
+    TRC_Sink *sink = TRC_Sink_Find(argv[2]);
+    if (sink == NULL)
+    {
+        CLI_CMD_Printf("trc: unknown sink: %s\n", argv[2]);
+        return;
+    }
+
+    trcLvl level;
+    if (!TRC_LookupLevel(argv[3], &level))
+    {
+        CLI_CMD_Printf("trc: unknown level: %s\n", argv[3]);
+        return;
+    }
+    sink->min_level = level;
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// trc dump [more|clear]
+// ---------------------------------------------------------------------------------------------+-
+static void trc_dump_cmd(int argc, char *argv[])
+{
+    TRC_FlightRec_Info prev;
+    uint8_t            chunk[DUMP_CHUNK_SIZE];
+
+    if (!TRC_FlightRec_Get_Previous(&prev))
+    {
+        CLI_CMD_Printf("trc: no previous session recorded\n");
+        return;
+    }
+
+    if (argc == 3 && strcmp(argv[2], "clear") == 0)
+    {
+        TRC_FlightRec_Discard_Previous();
+        Dump_Offset = 0;
+        return;
+    }
+
+    if (argc == 2)
+    {
+        Dump_Offset = 0;
+        CLI_CMD_Printf("  boot %lu ended by %s reset%s; %lu bytes, %lu older bytes lost\n",
+            (unsigned long)prev.boot_count,
+            TRC_Adapt_Reset_Cause_Name(prev.end_reset),
+            prev.fatal ? " after FATAL" : "",
+            (unsigned long)prev.length,
+            (unsigned long)prev.lost
+        );
+    }
+
+    uint32_t page_end = Dump_Offset + TRC_CLI_DUMP_PAGE_SIZE;
+    while (Dump_Offset < page_end)
+    {
+        uint32_t count = TRC_FlightRec_Read_Previous(Dump_Offset, chunk, sizeof(chunk));
+        if (count == 0) break;
+
+        CLI_CMD_Printf("%.*s", (int)count, (char *)chunk);
+        Dump_Offset += count;
+    }
+
+    if (Dump_Offset < prev.length) {
+        CLI_CMD_Printf("\n  -- %lu of %lu bytes; 'trc dump more' to continue --\n",
+            (unsigned long)Dump_Offset, (unsigned long)prev.length
+        );
+    }
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// trc span [dump|more|clear]
+//
+// The dump is line oriented so that it can be picked out of a captured
+// terminal session by tools/trc-span-stats.
+// ---------------------------------------------------------------------------------------------+-
+static void trc_span_summary(void)
+{
+    TRC_Span_Stats stats[trcSpanNumOf];
+    uint32_t       mhz = TRC_Adapt_Timestamp_Hz() / 1000000U;
+
+    TRC_Span_Take_Snapshot();
+    TRC_Span_Summarize(stats);
+
+    CLI_CMD_Printf("  %-20s %6s %8s %8s %8s  (cycles; %lu per us)\n",
+        "span", "count", "min", "avg", "max", (unsigned long)mhz
+    );
+    for (uint32_t span=0; span<trcSpanNumOf; span++)
+    {
+        uint32_t avg = stats[span].count ? (uint32_t)(stats[span].total_cycles / stats[span].count) : 0;
+        CLI_CMD_Printf("  %-20s %6lu %8lu %8lu %8lu\n",
+            TRC_Span_Get_Name((trcSpan)span),
+            (unsigned long)stats[span].count,
+            (unsigned long)stats[span].min_cycles,
+            (unsigned long)avg,
+            (unsigned long)stats[span].max_cycles
+        );
+    }
+    return;
+}
+
+static void trc_span_dump_page(void)
+{
+    trcSpanEvent event;
+    uint32_t     page_end = Span_Dump_Index + TRC_CLI_SPAN_PAGE_EVENTS;
+
+    while (Span_Dump_Index < page_end && Span_Dump_Index < Span_Dump_Len)
+    {
+        char     line[4 + SPAN_EVENTS_PER_LINE * 18 + 2];
+        uint32_t line_len = 0;
+
+        line_len += snprintf(&line[line_len], sizeof(line) - line_len, "span");
+        for (uint32_t col=0; col<SPAN_EVENTS_PER_LINE; col++)
+        {
+            if (!TRC_Span_Get_Event(Span_Dump_Index, &event)) break;
+            line_len += snprintf(&line[line_len], sizeof(line) - line_len, " %08lx:%08lx",
+                (unsigned long)event.cycles, (unsigned long)event.tag
+            );
+            Span_Dump_Index++;
+        }
+        CLI_CMD_Printf("%s\n", line);
+    }
+
+    if (Span_Dump_Index < Span_Dump_Len) {
+        CLI_CMD_Printf("  -- %lu of %lu events; 'trc span more' to continue --\n",
+            (unsigned long)Span_Dump_Index, (unsigned long)Span_Dump_Len
+        );
+    }
+    else {
+        CLI_CMD_Printf("span-end\n");
+    }
+    return;
+}
+
+static void trc_span_cmd(int argc, char *argv[])
+{
+    if (argc == 2)
+    {
+        trc_span_summary();
+        return;
+    }
+
+    if (strcmp(argv[2], "clear") == 0)
+    {
+        TRC_Span_Clear();
+        Span_Dump_Index = 0;
+        Span_Dump_Len   = 0;
+        return;
+    }
+
+    if (strcmp(argv[2], "dump") == 0)
+    {
+        Span_Dump_Len   = TRC_Span_Take_Snapshot();
+        Span_Dump_Index = 0;
+
+        CLI_CMD_Printf("span-clock %lu\n", (unsigned long)TRC_Adapt_Timestamp_Hz());
+        for (uint32_t span=0; span<trcSpanNumOf; span++) {
+            CLI_CMD_Printf("span-name %lu %s\n", (unsigned long)span, TRC_Span_Get_Name((trcSpan)span));
+        }
+    }
+    else if (strcmp(argv[2], "more") != 0)
+    {
+        CLI_CMD_Printf("trc: unknown span option: %s\n", argv[2]);
+        return;
+    }
+
+    trc_span_dump_page();
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// trc rtos [on|isr|off]
+// ---------------------------------------------------------------------------------------------+-
+static void trc_rtos_cmd(int argc, char *argv[])
+{
+    if (argc == 3)
+    {
+        if (strcmp(argv[2], "on") == 0)        TRC_RTOS_Enable(true, false);
+        else if (strcmp(argv[2], "isr") == 0)  TRC_RTOS_Enable(true, true);
+        else if (strcmp(argv[2], "off") == 0)  TRC_RTOS_Enable(false, false);
+        else {
+            CLI_CMD_Printf("trc: unknown rtos option: %s\n", argv[2]);
+            return;
+        }
+    }
+
+    TRC_RTOS_Stats stats;
+    TRC_RTOS_Get_Stats(&stats);
+
+    CLI_CMD_Printf("  rtos: %s; %lu recorded, %lu lost, %lu flushed, %lu pending\n",
+        !stats.enabled ? "off" : (stats.isr_enabled ? "on with isr" : "on"),
+        (unsigned long)stats.recorded,
+        (unsigned long)stats.lost,
+        (unsigned long)stats.flushed,
+        (unsigned long)stats.pending
+    );
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// trc <subcommand> ...
+// ---------------------------------------------------------------------------------------------+-
+static void trc_cmd(int argc, char *argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "level") == 0 && argc <= 4)
+    {
+        trc_level_cmd(argc, argv);
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "stats") == 0)
+    {
+        trc_stats_cmd(argc, argv);
+        return;
+    }
+
+    if ((argc == 2 || argc == 4) && strcmp(argv[1], "sink") == 0)
+    {
+        trc_sink_cmd(argc, argv);
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "span") == 0 && argc <= 3)
+    {
+        trc_span_cmd(argc, argv);
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "dump") == 0 && argc <= 3)
+    {
+        trc_dump_cmd(argc, argv);
+        return;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "rtos") == 0 && argc <= 3)
+    {
+        trc_rtos_cmd(argc, argv);
+        return;
+    }
+
+    CLI_CMD_Printf("usage: trc level [[module] debug|info|error|fatal|none]\n");
+    CLI_CMD_Printf("       trc stats\n");
+    CLI_CMD_Printf("       trc sink [name debug|info|error|fatal|none]\n");
+    CLI_CMD_Printf("       trc dump [more|clear]\n");
+    CLI_CMD_Printf("       trc span [dump|more|clear]\n");
+    CLI_CMD_Printf("       trc rtos [on|isr|off]\n");
+    return;
+}
+
+static const CLI_CMD_Descriptor Trc_Cmd = {
+    .name    = "trc",
+    .help    = "manage the software trace",
+    .handler = trc_cmd,
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_CLI_Init(void)
+{
+    CLI_CMD_Register(&Trc_Cmd);
+    return;
+}
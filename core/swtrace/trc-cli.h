@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE CLI
+core/swtrace/trc-cli.h
+
+Description:
+    Provides the 'trc' command to manage the software trace facility
+    from the command line interface at run time.
+
+        trc level                   show the level of each module
+        trc level <level>           set the level of every module
+        trc level <module> <level>  set the level of one module; reports a level
+                                    whose messages are compiled out, per trc.h
+        trc stats                   show the backend queued and dropped counts
+        trc sink                    show the level and counts of each trace sink
+        trc sink <name> <level>     set the level of one trace sink
+        trc dump                    show the trace recorded before the last reset
+        trc dump more               show the next page of that trace
+        trc dump clear              discard that trace
+        trc span                    show the min/avg/max cycles of each span
+        trc span dump               dump the span ring for tools/trc-span-stats
+        trc span more               dump the next page of the span ring
+        trc span clear              discard the span ring
+        trc rtos                    show the RTOS event recording counts
+        trc rtos on|isr|off         record scheduler and queue events; with isr,
+                                    interrupt entry and exit as well; see trc-rtos.h
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// One-time startup initialization for the module;
+// Registers the trace commands with the CLI.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_CLI_Init(void);
@@ -17,8 +17,11 @@ SPDX-License-Identifier: MIT-0
 #include <stdio.h>
 
 
+#define TRC_MODULE trcModTrace
 #include "trc-core.h"
 #include "trc-adaptation.h"
+#include "trc-sink.h"
+#include "trc-throttle.h"
 
 
 
@@ -27,13 +30,107 @@ SPDX-License-Identifier: MIT-0
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 static bool ModuleInitialized = false;
 
-static trcLvl MinLevelToDispatch = trcLvlDebug;
+// -----------------------------------------------------------------------------+-
+// Minimum level to be dispatched for each module;
+// This is public so that the trace macros can check it inline;
+// See trc.h for details.
+// -----------------------------------------------------------------------------+-
+// Debug is off until asked for, e.g. for one module with 'trc level';
+#ifndef TRC_DEFAULT_LOG_LEVEL
+#define TRC_DEFAULT_LOG_LEVEL trcLvlInfo
+#endif
+volatile uint8_t TRC_Module_Level[trcModNumOf] = {
+    [0 ... trcModNumOf-1] = TRC_DEFAULT_LOG_LEVEL,
+};
+
+// -----------------------------------------------------------------------------+-
+// Printable names for each module and level;
+// Keep these in sync with the enums in trc.h.
+// -----------------------------------------------------------------------------+-
+static const char* ModuleNames[trcModNumOf] = {
+    [trcModApp]   = "app",
+    [trcModTrace] = "trc",
+    [trcModCli]   = "cli",
+    [trcModUsart] = "usart",
+    [trcModRtos]  = "rtos",
+};
+
+static const char* LevelNames[trcLvlNone+1] = {
+    [trcLvlDebug] = "debug",
+    [trcLvlInfo]  = "info",
+    [trcLvlError] = "error",
+    [trcLvlFatal] = "fatal",
+    [trcLvlNone]  = "none",
+};
 
 #ifndef CONTENT_BUFFER_SIZE
 #define CONTENT_BUFFER_SIZE (140U)
 #endif
 static char Content_Buffer[CONTENT_BUFFER_SIZE];
 
+// -----------------------------------------------------------------------------+-
+// Hex dump lines; the longest is an 8 digit offset, the hex bytes,
+// and the ASCII column between bars.
+// -----------------------------------------------------------------------------+-
+static const char Hex_Digits[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+};
+
+_Static_assert(10U + 3U * TRC_HEX_BYTES_PER_LINE + 2U + TRC_HEX_BYTES_PER_LINE + 1U <= CONTENT_BUFFER_SIZE,
+    "TRC_HEX_BYTES_PER_LINE is too many for the content buffer");
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Format one line of a hex dump into the content buffer;
+// Returns the length of the line.
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t format_hex_line(const uint8_t *bytes, uint32_t count,
+        uint32_t offset, uint32_t offset_digits, uint32_t options)
+{
+    char *out = Content_Buffer;
+
+    if (options & TRC_HEX_OFFSET)
+    {
+        for (uint32_t shift=4*offset_digits; shift>0; shift-=4) {
+            *out++ = Hex_Digits[(offset >> (shift-4)) & 0x0FU];
+        }
+        *out++ = ':';
+        *out++ = ' ';
+    }
+
+    for (uint32_t idx=0; idx<count; idx++)
+    {
+        *out++ = Hex_Digits[bytes[idx] >> 4];
+        *out++ = Hex_Digits[bytes[idx] & 0x0FU];
+        *out++ = ' ';
+    }
+
+    if (options & TRC_HEX_ASCII)
+    {
+        // Pad a short last line so that the ASCII column lines up;
+        for (uint32_t idx=count; idx<TRC_HEX_BYTES_PER_LINE; idx++) {
+            *out++ = ' ';
+            *out++ = ' ';
+            *out++ = ' ';
+        }
+        *out++ = '|';
+        for (uint32_t idx=0; idx<count; idx++) {
+            *out++ = (bytes[idx] >= 0x20 && bytes[idx] < 0x7F) ? (char)bytes[idx] : '.';
+        }
+        *out++ = '|';
+    }
+    else if (count > 0) {
+        out--;      // the trailing space;
+    }
+
+    return (uint32_t)(out - Content_Buffer);
+}
+
+
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 // Public API Functions
@@ -42,7 +139,7 @@ static char Content_Buffer[CONTENT_BUFFER_SIZE];
 
 // ---------------------------------------------------------------------------------------------+-
 // ---------------------------------------------------------------------------------------------+-
-extern void TRC_Core( trcType trace_type,
+extern void TRC_Core( trcType trace_type, trcMod trace_module,
         const char *file_name, const char *function_name, int line_number,
         trcLvl trace_level, const char *format_string, ...)
 {
@@ -53,7 +150,12 @@ extern void TRC_Core( trcType trace_type,
 
     if (!ModuleInitialized) return;
 
-    if (!(trace_level >= MinLevelToDispatch)) return;
+    // Note: the level of the caller's module has already been
+    // checked inline by the trace macros; see trc.h.
+
+    // Under backend pressure, the throttle may drop this message;
+    // decide that before paying for the formatting below.
+    if (!TRC_Throttle_Admit(trace_level, function_name, line_number)) return;
 
     // Format the caller's message into the content buffer.
     // The vsnprintf() function does not write more than size bytes
@@ -78,9 +180,75 @@ extern void TRC_Core( trcType trace_type,
         content_len = num_chars;
     }
 
-    TRC_Dispatch_Message((uint8_t *)Content_Buffer, content_len);
-#if 0
-#endif
+    // Every sink shares this one record, and hence the one formatted content;
+    TRC_Record record = {
+        .type          = trace_type,
+        .level         = trace_level,
+        .module        = trace_module,
+        .file_name     = file_name,
+        .function_name = function_name,
+        .line_number   = line_number,
+        .timestamp     = TRC_Adapt_Timestamp(),
+        .msg           = (const uint8_t *)Content_Buffer,
+        .msg_len       = content_len,
+    };
+    TRC_Sink_Dispatch(&record);
+
+    // The adaptation decides how to stop; typically, by resetting the MCU.
+    if (trace_level == trcLvlFatal) TRC_Adapt_Fatal();
+
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// The throttle admits or drops the dump as a whole; each line is then
+// dispatched as a record of its own.
+// ---------------------------------------------------------------------------------------------+-
+extern void TRC_Core_Hex( trcMod trace_module,
+        const char *file_name, const char *function_name, int line_number,
+        trcLvl trace_level, const void *data, uint32_t data_len, uint32_t options)
+{
+    const uint8_t *bytes         = (const uint8_t *)data;
+    uint32_t       offset_digits = (data_len > 0x10000U) ? 8U : 4U;
+    uint32_t       lines         = 0;
+
+    if (!ModuleInitialized) return;
+    if (data_len == 0) return;
+
+    if (!TRC_Throttle_Admit(trace_level, function_name, line_number)) return;
+
+    TRC_Record record = {
+        .type          = trcTypeHex,
+        .level         = trace_level,
+        .module        = trace_module,
+        .file_name     = file_name,
+        .function_name = function_name,
+        .line_number   = line_number,
+        .msg           = (const uint8_t *)Content_Buffer,
+    };
+
+    for (uint32_t offset=0; offset<data_len; offset+=TRC_HEX_BYTES_PER_LINE)
+    {
+        uint32_t count = data_len - offset;
+
+        if (lines++ == TRC_HEX_MAX_LINES)
+        {
+            int num_chars = snprintf(Content_Buffer, CONTENT_BUFFER_SIZE,
+                "... %lu more bytes", (unsigned long)count
+            );
+            record.timestamp = TRC_Adapt_Timestamp();
+            record.msg_len   = (num_chars < CONTENT_BUFFER_SIZE) ? num_chars : CONTENT_BUFFER_SIZE - 1;
+            TRC_Sink_Dispatch(&record);
+            break;
+        }
+
+        if (count > TRC_HEX_BYTES_PER_LINE) count = TRC_HEX_BYTES_PER_LINE;
+
+        record.timestamp = TRC_Adapt_Timestamp();
+        record.msg_len   = format_hex_line(&bytes[offset], count, offset, offset_digits, options);
+        TRC_Sink_Dispatch(&record);
+    }
 
     return;
 }
@@ -96,6 +264,80 @@ void TRC_Initialize(void)
 }
 
 
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_SetLogLevel(trcLvl given_level)
+{
+    if (given_level > trcLvlNone) return;
+
+    for (uint32_t mod=0; mod<trcModNumOf; mod++)
+    {
+        TRC_Module_Level[mod] = given_level;
+    }
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_SetModuleLogLevel(trcMod given_module, trcLvl given_level)
+{
+    if (given_module >= trcModNumOf) return;
+    if (given_level  >  trcLvlNone)  return;
+
+    TRC_Module_Level[given_module] = given_level;
+    return;
+}
+
+trcLvl TRC_GetModuleLogLevel(trcMod given_module)
+{
+    if (given_module >= trcModNumOf) return trcLvlNone;
+
+    return (trcLvl)TRC_Module_Level[given_module];
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+const char *TRC_GetModuleName(trcMod given_module)
+{
+    if (given_module >= trcModNumOf) return "?";
+
+    return ModuleNames[given_module];
+}
+
+const char *TRC_GetLevelName(trcLvl given_level)
+{
+    if (given_level > trcLvlNone) return "?";
+
+    return LevelNames[given_level];
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_LookupModule(const char *given_name, trcMod *module_out)
+{
+    for (uint32_t mod=0; mod<trcModNumOf; mod++)
+    {
+        if (strcmp(given_name, ModuleNames[mod]) == 0) {
+            *module_out = (trcMod)mod;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TRC_LookupLevel(const char *given_name, trcLvl *level_out)
+{
+    for (uint32_t lvl=0; lvl<=trcLvlNone; lvl++)
+    {
+        if (strcmp(given_name, LevelNames[lvl]) == 0) {
+            *level_out = (trcLvl)lvl;
+            return true;
+        }
+    }
+    return false;
+}
+
+
 #if 0
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@|@
 ================================================================================================#=
@@ -16,6 +16,8 @@ SPDX-License-Identifier: MIT-0
 ================================================================================================#=
 */
 
+#include <stdbool.h>
+
 #include "trc.h"
 
 
@@ -27,7 +29,26 @@ extern void TRC_Initialize(void);
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 // Set trace level such that only those messages at or above
 // the given level are logged to the backend.
+// This applies the given level to every module.
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 extern void TRC_SetLogLevel(trcLvl given_level);
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Set or get the trace level of a single module.
+// Out of range modules and levels are ignored.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void   TRC_SetModuleLogLevel(trcMod given_module, trcLvl given_level);
+extern trcLvl TRC_GetModuleLogLevel(trcMod given_module);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Map modules and levels to and from their printable names;
+// These support the CLI and any other human interface to the trace core.
+// The lookup functions return false when the given name is not recognized.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern const char *TRC_GetModuleName(trcMod given_module);
+extern const char *TRC_GetLevelName(trcLvl given_level);
+
+extern bool TRC_LookupModule(const char *given_name, trcMod *module_out);
+extern bool TRC_LookupLevel(const char *given_name, trcLvl *level_out);
+
 
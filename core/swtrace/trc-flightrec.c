@@ -0,0 +1,231 @@
+
+/*
+================================================================================================#=
+TRACE FLIGHT RECORDER
+core/swtrace/trc-flightrec.c
+
+Description:
+    Crash-surviving record of the most recent trace messages.
+    See trc-flightrec.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "core/swtrace/trc-flightrec.h"
+
+#include <stddef.h>
+
+#include "mcu/vtor/sram2.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Types and Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// -----------------------------------------------------------------------------+-
+// The magic numbers tell a recorder that survived a reset
+// from the random content found in SRAM after power-up.
+// Change these whenever the layout below changes.
+// -----------------------------------------------------------------------------+-
+#define RECORDER_MAGIC (0x46524543U)   // "FREC"
+#define SESSION_MAGIC  (0x53455331U)   // "SES1"
+#define FATAL_MARK     (0xFA7A1000U)
+
+#define NUM_SESSIONS   (2U)
+
+// The free-running write count wraps cleanly only if the size is a power of two;
+_Static_assert((TRC_FLIGHTREC_SESSION_SIZE & (TRC_FLIGHTREC_SESSION_SIZE - 1)) == 0,
+    "TRC_FLIGHTREC_SESSION_SIZE must be a power of two");
+
+// -----------------------------------------------------------------------------+-
+// One session ring;
+// The write count runs freely; the ring index is the count modulo the size.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  magic;
+    uint32_t  boot_count;
+    uint32_t  start_reset;    // Reset flags latched by the boot that began the session;
+    uint32_t  fatal_mark;
+    uint32_t  write_count;
+    uint8_t   data[TRC_FLIGHTREC_SESSION_SIZE];
+
+}   Session;
+
+typedef struct
+{
+    uint32_t  magic;
+    uint32_t  active;         // Index of the session being recorded;
+    Session   session[NUM_SESSIONS];
+
+}   Recorder;
+
+static Recorder Flight_Recorder MCU_SRAM2_NOINIT __attribute__((aligned(8)));
+
+// -----------------------------------------------------------------------------+-
+// Not retained; these are established at each boot.
+// -----------------------------------------------------------------------------+-
+static Session *Active_Session   = NULL;
+static Session *Previous_Session = NULL;
+static uint32_t Previous_End_Reset = 0;
+
+static bool flightrec_sink_write(TRC_Sink *sink, const TRC_Record *record);
+
+TRC_Sink TRC_FlightRec_Sink = {
+    .name      = "sram2",
+    .write     = flightrec_sink_write,
+    .occupancy = NULL,
+    .context   = NULL,
+    .min_level = trcLvlDebug,
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Number of bytes held by the given session; at most one full ring.
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t session_length(const Session *session)
+{
+    return (session->write_count < TRC_FLIGHTREC_SESSION_SIZE) ?
+        session->write_count : TRC_FLIGHTREC_SESSION_SIZE;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Sink write function; the recorder never drops, it overwrites.
+// ---------------------------------------------------------------------------------------------+-
+static bool flightrec_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    if (Active_Session == NULL) return false;
+
+    TRC_FlightRec_Write(record->msg, record->msg_len);
+    return true;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_FlightRec_Init(uint32_t reset_flags)
+{
+    Recorder *rec = &Flight_Recorder;
+    uint32_t  boot_count = 0;
+
+    if (rec->magic == RECORDER_MAGIC && rec->active < NUM_SESSIONS)
+    {
+        Session *prev = &rec->session[rec->active];
+
+        if (prev->magic == SESSION_MAGIC) {
+            Previous_Session   = prev;
+            Previous_End_Reset = reset_flags;
+            boot_count         = prev->boot_count + 1;
+        }
+        rec->active = (rec->active + 1) % NUM_SESSIONS;
+    }
+    else
+    {
+        // Nothing survived; e.g. this is a power-on reset.
+        rec->magic  = RECORDER_MAGIC;
+        rec->active = 0;
+        for (uint32_t idx=0; idx<NUM_SESSIONS; idx++) {
+            rec->session[idx].magic = 0;
+        }
+    }
+
+    Active_Session = &rec->session[rec->active];
+    Active_Session->boot_count  = boot_count;
+    Active_Session->start_reset = reset_flags;
+    Active_Session->fatal_mark  = 0;
+    Active_Session->write_count = 0;
+    Active_Session->magic       = SESSION_MAGIC;
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_FlightRec_Write(const uint8_t *msg, uint32_t msg_len)
+{
+    Session *session = Active_Session;
+    if (session == NULL) return;
+
+    uint32_t write_count = session->write_count;
+    for (uint32_t idx=0; idx<msg_len; idx++)
+    {
+        session->data[write_count % TRC_FLIGHTREC_SESSION_SIZE] = msg[idx];
+        write_count++;
+    }
+    session->write_count = write_count;
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_FlightRec_Mark_Fatal(void)
+{
+    if (Active_Session == NULL) return;
+
+    Active_Session->fatal_mark = FATAL_MARK;
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_FlightRec_Get_Previous(TRC_FlightRec_Info *info_out)
+{
+    const Session *prev = Previous_Session;
+    if (prev == NULL) return false;
+
+    info_out->boot_count = prev->boot_count;
+    info_out->end_reset  = Previous_End_Reset;
+    info_out->fatal      = (prev->fatal_mark == FATAL_MARK);
+    info_out->length     = session_length(prev);
+    info_out->lost       = prev->write_count - info_out->length;
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_FlightRec_Read_Previous(uint32_t offset, uint8_t *buff_out, uint32_t max_len)
+{
+    const Session *prev = Previous_Session;
+    if (prev == NULL) return 0;
+
+    uint32_t length = session_length(prev);
+    if (offset >= length) return 0;
+
+    // The oldest byte still held sits just after the newest one;
+    uint32_t start = prev->write_count - length + offset;
+    uint32_t count = length - offset;
+    if (count > max_len) count = max_len;
+
+    for (uint32_t idx=0; idx<count; idx++)
+    {
+        buff_out[idx] = prev->data[(start + idx) % TRC_FLIGHTREC_SESSION_SIZE];
+    }
+    return count;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_FlightRec_Discard_Previous(void)
+{
+    if (Previous_Session == NULL) return;
+
+    Previous_Session->magic = 0;
+    Previous_Session = NULL;
+    return;
+}
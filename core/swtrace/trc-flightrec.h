@@ -0,0 +1,102 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE FLIGHT RECORDER
+core/swtrace/trc-flightrec.h
+
+Description:
+    A crash-surviving record of the most recent trace messages.
+
+    Every dispatched trace message is also copied into a ring buffer held
+    in a no-init memory section; i.e. one that is neither zeroed nor loaded
+    by the startup code.  On the STM32L4 this section is placed in SRAM2,
+    which retains its content across a system reset, including a watchdog,
+    software, or pin reset. (It does not survive a loss of power.)
+
+    The recorder holds two sessions in ping-pong fashion:
+    the active session records the trace of the current boot, while the
+    previous session holds, untouched, the trace of the boot before it.
+    At startup the roles are swapped so that the trace leading up to the
+    most recent reset is preserved for inspection; see 'trc dump'.
+
+    NOTICE: if SRAM2 parity checking has been enabled via the option bytes,
+    reading SRAM2 before it has been written after power-up can raise a
+    parity error; this module assumes the default, parity disabled.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "trc-sink.h"
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+//
+// The size of each session ring in bytes; the recorder occupies twice this
+// plus a small header in SRAM2, as MCU_SRAM2_NOINIT; see mcu/vtor/sram2.h
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_FLIGHTREC_SESSION_SIZE
+#define TRC_FLIGHTREC_SESSION_SIZE (4096U)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// Information about the previous session;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  boot_count;   // Number of the boot that began the session;
+    uint32_t  end_reset;    // Reset flags latched by the boot that ended it;
+    bool      fatal;        // The session ended with a FATAL trace message;
+    uint32_t  length;       // Number of bytes available to be read;
+    uint32_t  lost;         // Number of older bytes that were overwritten;
+
+}   TRC_FlightRec_Info;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// One-time startup initialization for the module;
+// Preserves the previous session, if any, and begins a new one.
+// The given reset flags, as latched by the MCU for this boot,
+// describe how the previous session ended.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_FlightRec_Init(uint32_t reset_flags);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Record the given message in the active session;
+// The oldest content is overwritten as needed.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_FlightRec_Write(const uint8_t *msg, uint32_t msg_len);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// The flight recorder as a trace sink; named "sram2";
+// Register it with TRC_Sink_Register() after TRC_FlightRec_Init().
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern TRC_Sink TRC_FlightRec_Sink;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Mark the active session as having ended with a FATAL message;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_FlightRec_Mark_Fatal(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Describe the previous session;
+// Returns false if there is none; e.g. after a power-on reset.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_FlightRec_Get_Previous(TRC_FlightRec_Info *info_out);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Copy up to max_len bytes of the previous session, oldest first,
+// starting at the given offset; Returns the number of bytes copied.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t TRC_FlightRec_Read_Previous(uint32_t offset, uint8_t *buff_out, uint32_t max_len);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Discard the previous session;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_FlightRec_Discard_Previous(void);
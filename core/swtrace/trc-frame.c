@@ -0,0 +1,59 @@
+
+/*
+================================================================================================#=
+TRACE BINARY FRAME
+core/swtrace/trc-frame.c
+
+Description:
+    Encodes a trace record as a compact binary frame.
+    See trc-frame.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "trc-frame.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_Frame_Encode(const TRC_Record *record, uint8_t *buff_out, uint32_t buff_size)
+{
+    if (buff_size < TRC_FRAME_OVERHEAD) return 0;
+
+    uint32_t msg_len = record->msg_len;
+    if (msg_len > TRC_FRAME_MAX_MSG_LEN)          msg_len = TRC_FRAME_MAX_MSG_LEN;
+    if (msg_len > buff_size - TRC_FRAME_OVERHEAD) msg_len = buff_size - TRC_FRAME_OVERHEAD;
+
+    uint32_t timestamp   = record->timestamp;
+    uint32_t line_number = (uint32_t)record->line_number;
+
+    buff_out[0] = TRC_FRAME_SYNC;
+    buff_out[1] = (uint8_t)(TRC_FRAME_HEADER_LEN - 2U + msg_len);
+    buff_out[2] = (uint8_t)((record->level & 0x0FU) | ((record->type & 0x0FU) << 4));
+    buff_out[3] = (uint8_t)record->module;
+    buff_out[4] = (uint8_t)(timestamp);
+    buff_out[5] = (uint8_t)(timestamp >> 8);
+    buff_out[6] = (uint8_t)(timestamp >> 16);
+    buff_out[7] = (uint8_t)(timestamp >> 24);
+    buff_out[8] = (uint8_t)(line_number);
+    buff_out[9] = (uint8_t)(line_number >> 8);
+
+    for (uint32_t idx=0; idx<msg_len; idx++) {
+        buff_out[TRC_FRAME_HEADER_LEN + idx] = record->msg[idx];
+    }
+
+    uint8_t  sum = 0;
+    uint32_t end = TRC_FRAME_HEADER_LEN + msg_len;
+    for (uint32_t idx=1; idx<end; idx++) {
+        sum += buff_out[idx];
+    }
+    buff_out[end] = (uint8_t)(0U - sum);
+
+    return end + 1U;
+}
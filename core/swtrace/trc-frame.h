@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE BINARY FRAME
+core/swtrace/trc-frame.h
+
+Description:
+    Encodes a trace record as a compact binary frame, for those sinks
+    that carry trace to a host-side decoder rather than to a terminal;
+    see tools/trc-frame-decode.
+
+    Frame layout; multi-byte fields are little endian:
+
+        offset  size  field
+        0       1     sync, TRC_FRAME_SYNC
+        1       1     length; number of bytes from offset 2 up to the checksum
+        2       1     level in bits 0..3; type in bits 4..7
+        3       1     module
+        4       4     timestamp
+        8       2     line number
+        10      n     message content
+        10+n    1     checksum; the bytes from offset 1 through the checksum sum to zero
+
+    The function name and file name are not carried; the host side
+    can recover the call site from the line number and module.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdint.h>
+
+#include "trc-sink.h"
+
+
+#define TRC_FRAME_SYNC          (0xA5U)
+#define TRC_FRAME_HEADER_LEN    (10U)
+#define TRC_FRAME_OVERHEAD      (TRC_FRAME_HEADER_LEN + 1U)
+
+// Largest message content that can be carried in one frame;
+#define TRC_FRAME_MAX_MSG_LEN   (UINT8_MAX - (TRC_FRAME_HEADER_LEN - 2U))
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Encode the given record into the given buffer;
+// Content that does not fit, in the buffer or in the frame, is truncated.
+// Returns the length of the frame, or zero if the buffer cannot hold
+// even the frame overhead.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t TRC_Frame_Encode(const TRC_Record *record, uint8_t *buff_out, uint32_t buff_size);
@@ -13,6 +13,16 @@ SPDX-License-Identifier: MIT-0
 #include "core/swtrace/trc-led.h"
 
 
+// The event markers rely on the board model placing the four LEDs
+// on consecutive pins, in order; their port is not checked here.
+_Static_assert(
+    SW_DEBUG_EXTERNAL_RED_LED_PIN    == (1UL << (SW_DEBUG_MARKER_SHIFT + 0U)) &&
+    SW_DEBUG_EXTERNAL_GREEN_LED_PIN  == (1UL << (SW_DEBUG_MARKER_SHIFT + 1U)) &&
+    SW_DEBUG_EXTERNAL_BLUE_LED_PIN   == (1UL << (SW_DEBUG_MARKER_SHIFT + 2U)) &&
+    SW_DEBUG_EXTERNAL_YELLOW_LED_PIN == (1UL << (SW_DEBUG_MARKER_SHIFT + 3U)),
+    "The trace LEDs must be consecutive pins for the event markers");
+
+
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 // Initialize the GPIO peripherals and pins for the trace LEDs.
@@ -155,6 +155,40 @@ SPDX-License-Identifier: MIT-0
 
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Event markers for a logic analyzer;
+//
+// Together the four external LEDs show a 4-bit event code: red is bit 0,
+// green bit 1, blue bit 2 and yellow bit 3.  The code is written with one
+// store to the port's BSRR: the low half sets the bits that are set in the
+// code, the high half resets the others.  So all four pins change on the
+// same bus cycle, an analyzer never sees a mix of the old and new codes,
+// and no other pin of the port is disturbed, even by an interrupt.
+//
+// With a constant code the value folds at compile time, and a marker costs
+// the store plus two literal loads; i.e. a few cycles, always the same.
+// A variable code adds a few ALU instructions.
+//
+// Code zero means no event.  Mark on entry to a section of interest and
+// clear on exit, and the analyzer shows how long it ran; a bare pulse lasts
+// only a few cycles and needs a fast analyzer to see it.  Give the codes
+// names as '#define TRC_MARK_<NAME> <code>' in a header, and tools/la-decode
+// can read them from there to name the events in an analyzer capture.
+//
+// The markers drive the same pins as the LED macros above; use one or the other.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+#define TRC_MARK_BITS (0xFUL)
+
+#define Trace_Mark(_code_) WRITE_REG(                                                     \
+    SW_DEBUG_MARKER_PERIPH->BSRR,                                                       \
+    (( (uint32_t)(_code_) & TRC_MARK_BITS) << SW_DEBUG_MARKER_SHIFT) |                  \
+    ((~(uint32_t)(_code_) & TRC_MARK_BITS) << (SW_DEBUG_MARKER_SHIFT + 16U))            \
+)
+
+#define Trace_Mark_Clear() Trace_Mark(0U)
+
+
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 // Do the needful for one-time startup initialization;
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
@@ -0,0 +1,312 @@
+
+/*
+================================================================================================#=
+TRACE STREAM COMPRESSION
+core/swtrace/trc-lz.c
+
+Description:
+    A small streaming LZ77 codec for trace frames.
+    See trc-lz.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "trc-lz.h"
+
+#include <string.h>
+
+#include "trc-frame.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+_Static_assert((TRC_LZ_HISTORY_SIZE & (TRC_LZ_HISTORY_SIZE - 1U)) == 0 &&
+    TRC_LZ_HISTORY_SIZE >= 256U && TRC_LZ_HISTORY_SIZE <= 1024U,
+    "TRC_LZ_HISTORY_SIZE must be a power of two, at least a block, and within the 10 bit distance");
+
+_Static_assert((TRC_LZ_HASH_SIZE & (TRC_LZ_HASH_SIZE - 1U)) == 0,
+    "TRC_LZ_HASH_SIZE must be a power of two");
+
+#define HISTORY_MASK    (TRC_LZ_HISTORY_SIZE - 1U)
+#define MAX_PAYLOAD     (UINT8_MAX)
+
+// Offsets of the frame fields; see trc-frame.h;
+#define FRAME_LENGTH    (1U)
+#define FRAME_LEVEL     (2U)
+#define FRAME_STAMP     (4U)
+#define FRAME_LINE      (8U)
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// The byte of the history at the given position, counted from the last reset;
+// ---------------------------------------------------------------------------------------------+-
+static inline uint8_t history_at(const TRC_LZ_Encoder *encoder, uint32_t position)
+{
+    return encoder->history[position & HISTORY_MASK];
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Hash of the three bytes of the history at the given position;
+// ---------------------------------------------------------------------------------------------+-
+static inline uint32_t hash3(const TRC_LZ_Encoder *encoder, uint32_t position)
+{
+    uint32_t value = history_at(encoder, position)
+                   | ((uint32_t)history_at(encoder, position + 1U) << 8)
+                   | ((uint32_t)history_at(encoder, position + 2U) << 16);
+
+    return (value * 2654435761U) >> (32U - __builtin_ctz(TRC_LZ_HASH_SIZE));
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The length of the match, up to the given limit, between the history from
+// the given position on, and from the given distance back;  zero if that
+// distance reaches outside what is left of the history.
+// ---------------------------------------------------------------------------------------------+-
+static inline uint32_t match_length(
+    const TRC_LZ_Encoder *encoder,
+    uint32_t              here,
+    uint32_t              distance,
+    uint32_t              oldest,
+    uint32_t              end,
+    uint32_t              limit )
+{
+    uint32_t length = 0;
+
+    if (distance < 1 || distance > here - oldest) return 0;
+    if (limit > end - here) limit = end - here;
+
+    while (length < limit &&
+           history_at(encoder, here - distance + length) == history_at(encoder, here + length))
+    {
+        length++;
+    }
+    return length;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Append the given bytes to the history;
+// ---------------------------------------------------------------------------------------------+-
+static void history_put(TRC_LZ_Encoder *encoder, uint32_t *position, const uint8_t *bytes, uint32_t count)
+{
+    for (uint32_t idx=0; idx<count; idx++) {
+        encoder->history[(*position)++ & HISTORY_MASK] = bytes[idx];
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Emit the given run of the history as literals, in pieces of at most
+// TRC_LZ_MAX_LITERALS; returns the new length of the payload.
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t put_literals(
+    const TRC_LZ_Encoder *encoder,
+    uint8_t              *payload,
+    uint32_t              used,
+    uint32_t              position,
+    uint32_t              count )
+{
+    while (count > 0)
+    {
+        uint32_t run = (count > TRC_LZ_MAX_LITERALS) ? TRC_LZ_MAX_LITERALS : count;
+
+        payload[used++] = (uint8_t)(run - 1U);
+        for (uint32_t idx=0; idx<run; idx++) {
+            payload[used++] = history_at(encoder, position++);
+        }
+        count -= run;
+    }
+    return used;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Fill in the header and checksum around the payload; returns the block length.
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t finish_block(uint8_t *buff_out, uint32_t payload_len, uint8_t flags)
+{
+    buff_out[0] = TRC_LZ_SYNC;
+    buff_out[1] = (uint8_t)payload_len;
+    buff_out[2] = flags;
+
+    uint8_t  sum = 0;
+    uint32_t end = TRC_LZ_HEADER_LEN + payload_len;
+    for (uint32_t idx=1; idx<end; idx++) {
+        sum += buff_out[idx];
+    }
+    buff_out[end] = (uint8_t)(0U - sum);
+
+    return end + 1U;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Returns true if the given bytes are one whole frame, as made by TRC_Frame_Encode().
+// ---------------------------------------------------------------------------------------------+-
+static bool is_frame(const uint8_t *frame, uint32_t frame_len)
+{
+    return frame_len >= TRC_FRAME_OVERHEAD
+        && frame[0] == TRC_FRAME_SYNC
+        && frame[FRAME_LENGTH] == frame_len - 3U;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_LZ_Init(TRC_LZ_Encoder *encoder)
+{
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->reset_pending = true;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The payload fields are first appended to the history, and then parsed
+// greedily: at each position, the most recent earlier occurrence of the next
+// three bytes, if any, is taken from the hash table and extended as far as
+// it matches; as is the occurrence at the distance of the last match, which
+// is cheaper to send.  Positions inside a match are hashed too, so that the
+// next frame can refer to them.  A match reaches back no further than the
+// fields just appended have left of the history.
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_LZ_Encode(
+    TRC_LZ_Encoder *encoder,
+    const uint8_t  *frame,
+    uint32_t        frame_len,
+    uint8_t        *buff_out,
+    uint32_t        buff_size )
+{
+    if (!is_frame(frame, frame_len)) return 0;
+    if (buff_size < TRC_LZ_BLOCK_MAX(frame_len)) return 0;
+    if (TRC_LZ_BLOCK_MAX(frame_len) - TRC_LZ_OVERHEAD > MAX_PAYLOAD) return 0;
+
+    uint8_t flags = 0;
+
+    if (encoder->reset_pending || encoder->blocks >= TRC_LZ_RESET_INTERVAL)
+    {
+        memset(encoder->hash, 0, sizeof(encoder->hash));
+        encoder->position      = 0;
+        encoder->blocks        = 0;
+        encoder->timestamp     = 0;
+        encoder->distance      = 0;
+        encoder->reset_pending = false;
+        flags |= TRC_LZ_FLAG_RESET;
+    }
+
+    // The timestamp delta, little endian, in as few bytes as it takes;
+    uint32_t timestamp  = frame[FRAME_STAMP]
+                        | ((uint32_t)frame[FRAME_STAMP + 1U] << 8)
+                        | ((uint32_t)frame[FRAME_STAMP + 2U] << 16)
+                        | ((uint32_t)frame[FRAME_STAMP + 3U] << 24);
+    uint32_t delta      = timestamp - encoder->timestamp;
+    uint32_t stamp_size = (delta >> 24) ? 4U : (delta >> 16) ? 3U : (delta >> 8) ? 2U : 1U;
+    uint8_t  stamp[4]   = {
+        (uint8_t)delta, (uint8_t)(delta >> 8), (uint8_t)(delta >> 16), (uint8_t)(delta >> 24)
+    };
+
+    // The fields, in payload order;
+    uint32_t base = encoder->position;
+    uint32_t end  = base;
+    history_put(encoder, &end, &frame[FRAME_LEVEL], 2U);
+    history_put(encoder, &end, &frame[FRAME_LINE],  2U);
+    history_put(encoder, &end, &frame[TRC_FRAME_HEADER_LEN], frame_len - TRC_FRAME_OVERHEAD);
+    history_put(encoder, &end, stamp, stamp_size);
+
+    uint8_t *payload = &buff_out[TRC_LZ_HEADER_LEN];
+    uint32_t used    = 0;
+    uint32_t literal = base;    // Start of the pending literals;
+    uint32_t here    = base;
+    uint32_t oldest  = (end > TRC_LZ_HISTORY_SIZE) ? end - TRC_LZ_HISTORY_SIZE : 0;
+
+    while (here + TRC_LZ_MIN_REPEAT <= end)
+    {
+        uint32_t repeat_len = match_length(encoder, here, encoder->distance, oldest, end, TRC_LZ_MAX_REPEAT);
+        uint32_t match_len  = 0;
+        uint32_t distance   = 0;
+
+        if (here + TRC_LZ_MIN_MATCH <= end)
+        {
+            uint32_t slot = hash3(encoder, here);
+
+            distance  = (uint16_t)(here - encoder->hash[slot]);
+            match_len = match_length(encoder, here, distance, oldest, end, TRC_LZ_MAX_MATCH);
+            encoder->hash[slot] = (uint16_t)here;
+        }
+
+        // A repeat costs one byte, a match two;
+        if (repeat_len >= TRC_LZ_MIN_REPEAT && repeat_len + 1U >= match_len)
+        {
+            used = put_literals(encoder, payload, used, literal, here - literal);
+            payload[used++] = (uint8_t)(0x40U | (repeat_len - TRC_LZ_MIN_REPEAT));
+            match_len = repeat_len;
+        }
+        else if (match_len >= TRC_LZ_MIN_MATCH)
+        {
+            uint32_t len_code  = match_len - TRC_LZ_MIN_MATCH;
+            uint32_t dist_code = distance - 1U;
+
+            used = put_literals(encoder, payload, used, literal, here - literal);
+            payload[used++] = (uint8_t)(0x80U | (len_code << 2) | (dist_code >> 8));
+            payload[used++] = (uint8_t)dist_code;
+            encoder->distance = distance;
+        }
+        else
+        {
+            here++;
+            continue;
+        }
+
+        for (uint32_t next=here+1U; next<here+match_len && next+TRC_LZ_MIN_MATCH<=end; next++) {
+            encoder->hash[hash3(encoder, next)] = (uint16_t)next;
+        }
+
+        here   += match_len;
+        literal = here;
+    }
+
+    used = put_literals(encoder, payload, used, literal, end - literal);
+
+    encoder->position  = end;
+    encoder->timestamp = timestamp;
+    encoder->blocks++;
+
+    flags |= (uint8_t)((stamp_size - 1U) << TRC_LZ_STAMP_SIZE_SHIFT);
+    flags |= encoder->sequence & TRC_LZ_FLAG_SEQUENCE;
+    encoder->sequence++;
+
+    return finish_block(buff_out, used, flags);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_LZ_Discard(TRC_LZ_Encoder *encoder)
+{
+    encoder->reset_pending = true;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_LZ_Encode_Stored(
+    const uint8_t  *frame,
+    uint32_t        frame_len,
+    uint8_t        *buff_out,
+    uint32_t        buff_size )
+{
+    if (!is_frame(frame, frame_len)) return 0;
+    if (buff_size < TRC_LZ_BLOCK_MAX(frame_len)) return 0;
+
+    // Without the sync and checksum;
+    memcpy(&buff_out[TRC_LZ_HEADER_LEN], &frame[1], frame_len - 2U);
+    return finish_block(buff_out, frame_len - 2U, TRC_LZ_FLAG_STORED);
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE STREAM COMPRESSION
+core/swtrace/trc-lz.h
+
+Description:
+    A small streaming LZ77 codec for trace frames, for links whose bit rate
+    cannot be raised; see the 'usart-lz' sink in trc-adapt-default.c and
+    tools/trc-lz-decode.
+
+    Trace is highly repetitive: the same format strings, modules and line
+    numbers recur record after record.  Each frame is therefore compressed
+    against the frames sent before it, held in a small history window,
+    and sent as one block.  The encoder needs no more than the history
+    and a hash table of recent positions; about 1 KB with the defaults.
+    The decoder needs no configuration; it keeps all it has decoded.
+
+    Block layout:
+
+        offset  size  field
+        0       1     sync, TRC_LZ_SYNC
+        1       1     length; number of bytes of payload
+        2       1     flags; see below
+        3       n     payload
+        3+n     1     checksum; the bytes from offset 1 through the checksum sum to zero
+
+        flags   bits 0..3   sequence
+                bits 4..5   size of the timestamp delta, less one
+                bit 6       TRC_LZ_FLAG_STORED
+                bit 7       TRC_LZ_FLAG_RESET
+
+    The payload holds the fields of one frame (see trc-frame.h), reordered
+    so that those that repeat for a call site are adjacent; the timestamp
+    is replaced by its change since the last block, in as few bytes as
+    it takes, and the sync, length and checksum bytes are implied:
+
+        level and type, module, line number, message, timestamp delta
+
+    These are compressed as a sequence of tokens:
+
+        00LLLLLL                    L+1 literal bytes follow
+        01LLLLLL                    copy L+2 bytes from as far back as the last copy
+        1LLLLLDD DDDDDDDD           copy L+3 bytes from D+1 bytes back
+
+    A copy may overlap the bytes it produces.  The distance of the last
+    copy carries over from block to block, and is zero after a reset.
+
+    A stored block is not compressed; its payload is the frame without
+    its sync and checksum bytes.  It is neither part of, nor counted in,
+    the history; it suits frames that may overtake others on the link.
+
+    Recovery:
+    A lost block would leave the decoder's history behind the encoder's,
+    so the sequence of each block follows on from the one before.
+    The encoder starts afresh, and marks the block TRC_LZ_FLAG_RESET, when
+    told a block was not sent, and every TRC_LZ_RESET_INTERVAL blocks; the
+    first timestamp delta after a reset is from zero.  The decoder skips
+    blocks from a gap in the sequence up to the next reset.
+
+    The encoder is not thread safe; one encoder serves one stream.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+//
+// The history window, in bytes; a power of two from 256 to 1024.
+// The hash table of recent positions, in entries of two bytes each.
+// The number of blocks after which the encoder starts afresh; this bounds
+// how long a host that attaches to a running stream waits to sync.
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_LZ_HISTORY_SIZE
+#define TRC_LZ_HISTORY_SIZE (512U)
+#endif
+
+#ifndef TRC_LZ_HASH_SIZE
+#define TRC_LZ_HASH_SIZE (256U)
+#endif
+
+#ifndef TRC_LZ_RESET_INTERVAL
+#define TRC_LZ_RESET_INTERVAL (256U)
+#endif
+
+
+#define TRC_LZ_SYNC             (0x5AU)
+#define TRC_LZ_HEADER_LEN       (3U)
+#define TRC_LZ_OVERHEAD         (TRC_LZ_HEADER_LEN + 1U)
+
+#define TRC_LZ_FLAG_SEQUENCE    (0x0FU)
+#define TRC_LZ_FLAG_STAMP_SIZE  (0x30U)
+#define TRC_LZ_STAMP_SIZE_SHIFT (4U)
+#define TRC_LZ_FLAG_STORED      (0x40U)
+#define TRC_LZ_FLAG_RESET       (0x80U)
+
+#define TRC_LZ_MIN_MATCH        (3U)
+#define TRC_LZ_MAX_MATCH        (34U)
+#define TRC_LZ_MIN_REPEAT       (2U)
+#define TRC_LZ_MAX_REPEAT       (65U)
+#define TRC_LZ_MAX_LITERALS     (64U)
+
+// The largest block a frame of the given length can make;
+// i.e. its payload, all literals, plus the block overhead.
+#define TRC_LZ_BLOCK_MAX(_frame_len_) \
+    ((_frame_len_) + ((_frame_len_) + TRC_LZ_MAX_LITERALS - 1U) / TRC_LZ_MAX_LITERALS + TRC_LZ_OVERHEAD)
+
+
+// -----------------------------------------------------------------------------+-
+// State of one encoder; allocated by the client.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint8_t     history[TRC_LZ_HISTORY_SIZE];
+    uint16_t    hash[TRC_LZ_HASH_SIZE];     // Low bits of the last position of each hash;
+    uint32_t    position;                   // Bytes into the history since the last reset;
+    uint32_t    blocks;                     // Blocks since the last reset;
+    uint32_t    timestamp;                  // Of the last block;
+    uint32_t    distance;                   // Of the last copy;
+    uint8_t     sequence;
+    bool        reset_pending;
+
+}   TRC_LZ_Encoder;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Initialize the given encoder; its first block is a reset.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_LZ_Init(TRC_LZ_Encoder *encoder);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Compress the given frame, as made by TRC_Frame_Encode(), into one block
+// in the given buffer;
+// Returns the length of the block, or zero if the buffer is smaller than
+// TRC_LZ_BLOCK_MAX(frame_len), or the frame is malformed or too long
+// for a block to hold.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t TRC_LZ_Encode(
+    TRC_LZ_Encoder *encoder,
+    const uint8_t  *frame,
+    uint32_t        frame_len,
+    uint8_t        *buff_out,
+    uint32_t        buff_size );
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Tell the encoder that its last block was not sent;
+// The next block starts afresh.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_LZ_Discard(TRC_LZ_Encoder *encoder);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Wrap the given frame, uncompressed, in a stored block;
+// Needs no encoder.  Returns as for TRC_LZ_Encode().
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t TRC_LZ_Encode_Stored(
+    const uint8_t  *frame,
+    uint32_t        frame_len,
+    uint8_t        *buff_out,
+    uint32_t        buff_size );
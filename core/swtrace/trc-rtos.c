@@ -0,0 +1,311 @@
+
+/*
+================================================================================================#=
+TRACE RTOS EVENTS
+core/swtrace/trc-rtos.c
+
+Description:
+    Records the FreeRTOS scheduler timeline and flushes it to the binary
+    trace sinks.  See trc-rtos.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <string.h>
+
+#include "trc.h"
+#include "trc-rtos.h"
+#include "trc-sink.h"
+#include "trc-frame.h"
+#include "trc-adaptation.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+_Static_assert((TRC_RTOS_RING_SIZE & (TRC_RTOS_RING_SIZE - 1)) == 0,
+    "TRC_RTOS_RING_SIZE must be a power of two");
+_Static_assert(sizeof(trcRtosEvent) == 8, "trcRtosEvent must pack into eight bytes");
+_Static_assert(TRC_RTOS_MAX_NAMES <= 32, "name pending flags are held in 32 bits");
+
+// Events per record; as many as fit in one binary frame;
+#define EVENTS_PER_RECORD (TRC_FRAME_MAX_MSG_LEN / sizeof(trcRtosEvent))
+
+volatile bool TRC_RTOS_Enabled     = false;
+volatile bool TRC_RTOS_Isr_Enabled = false;
+
+// -----------------------------------------------------------------------------+-
+// The ring;
+// Written by the kernel, at any priority, with interrupts masked;
+// read only by TRC_RTOS_Flush(), which advances the tail.
+// -----------------------------------------------------------------------------+-
+static trcRtosEvent      Ring[TRC_RTOS_RING_SIZE];
+static volatile uint32_t Head     = 0;
+static volatile uint32_t Tail     = 0;
+static volatile uint32_t Recorded = 0;
+static volatile uint32_t Lost     = 0;
+static uint32_t          Lost_Reported = 0;
+static uint32_t          Flushed  = 0;
+
+// -----------------------------------------------------------------------------+-
+// Names, indexed by task or queue number, and those yet to be sent;
+// The task names point into the TCBs, the queue names into the registry.
+// -----------------------------------------------------------------------------+-
+static const char       *Task_Names[TRC_RTOS_MAX_NAMES];
+static const char       *Queue_Names[TRC_RTOS_MAX_NAMES];
+static volatile uint32_t Task_Names_Pending  = 0;
+static volatile uint32_t Queue_Names_Pending = 0;
+static uint32_t          Queue_Count = 0;
+
+// Send at most this many characters of a queue name;
+#define MAX_NAME_LEN (16U)
+
+static trcRtosEvent Record_Buffer[EVENTS_PER_RECORD];
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Interrupt masking;
+// PRIMASK rather than BASEPRI so that events may be recorded from any priority.
+// ---------------------------------------------------------------------------------------------+-
+static inline uint32_t mask_interrupts(void)
+{
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask \n cpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void restore_interrupts(uint32_t primask)
+{
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Append the events naming one task or queue to the record buffer;
+// Returns the new count, or zero if the name does not fit.
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t put_name(uint32_t count, trcRtosEvt event, uint32_t number, const char *name)
+{
+    uint32_t len = strnlen(name, MAX_NAME_LEN);
+    uint32_t needed = (len / 2U) + 1U;  // Always sends a terminating NUL;
+
+    if (count + needed > EVENTS_PER_RECORD) return 0;
+
+    for (uint32_t idx=0; idx<=len; idx+=2)
+    {
+        uint8_t first  = (idx     < len) ? (uint8_t)name[idx]     : 0;
+        uint8_t second = (idx + 1 < len) ? (uint8_t)name[idx + 1] : 0;
+
+        Record_Buffer[count++] = (trcRtosEvent){
+            .cycles = TRC_SPAN_CYCLES(),
+            .event  = (uint8_t)event,
+            .arg8   = (uint8_t)number,
+            .arg16  = (uint16_t)(first | (second << 8)),
+        };
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Append pending names to the record buffer, as many as fit;
+// ---------------------------------------------------------------------------------------------+-
+static uint32_t put_pending_names(uint32_t count, trcRtosEvt event, const char **names, volatile uint32_t *pending)
+{
+    for (uint32_t number=0; number<TRC_RTOS_MAX_NAMES && *pending; number++)
+    {
+        if ((*pending & (1UL << number)) == 0) continue;
+
+        if (names[number] != NULL)
+        {
+            uint32_t new_count = put_name(count, event, number, names[number]);
+            if (new_count == 0) break;
+            count = new_count;
+        }
+
+        uint32_t primask = mask_interrupts();
+        *pending &= ~(1UL << number);
+        restore_interrupts(primask);
+    }
+    return count;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Record(trcRtosEvt event, uint32_t arg8, uint32_t arg16)
+{
+    uint32_t primask = mask_interrupts();
+    uint32_t head    = Head;
+
+    if (head - Tail >= TRC_RTOS_RING_SIZE) {
+        Lost++;
+    }
+    else {
+        trcRtosEvent *slot = &Ring[head & (TRC_RTOS_RING_SIZE - 1U)];
+        slot->cycles = TRC_SPAN_CYCLES();
+        slot->event  = (uint8_t)event;
+        slot->arg8   = (uint8_t)arg8;
+        slot->arg16  = (uint16_t)arg16;
+        Head = head + 1U;
+        Recorded++;
+    }
+
+    restore_interrupts(primask);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Isr(trcRtosEvt event)
+{
+    uint32_t ipsr;
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+
+    TRC_RTOS_Record(event, ipsr & 0xFFU, 0);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Task_Create(uint32_t task, uint32_t priority, const char *name)
+{
+    if (task < TRC_RTOS_MAX_NAMES)
+    {
+        uint32_t primask = mask_interrupts();
+        Task_Names[task]    = name;
+        Task_Names_Pending |= (1UL << task);
+        restore_interrupts(primask);
+    }
+    if (TRC_RTOS_Enabled) TRC_RTOS_Record(trcRtosEvtTaskCreate, task, priority);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Task_Delete(uint32_t task)
+{
+    if (task < TRC_RTOS_MAX_NAMES)
+    {
+        uint32_t primask = mask_interrupts();
+        Task_Names[task]    = NULL;
+        Task_Names_Pending &= ~(1UL << task);
+        restore_interrupts(primask);
+    }
+    if (TRC_RTOS_Enabled) TRC_RTOS_Record(trcRtosEvtTaskDelete, task, 0);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Queues are numbered from one; zero is the kernel's default.
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_RTOS_Queue_Create(uint32_t length)
+{
+    uint32_t primask = mask_interrupts();
+    uint32_t queue   = ++Queue_Count;
+    restore_interrupts(primask);
+
+    if (TRC_RTOS_Enabled) TRC_RTOS_Record(trcRtosEvtQueueCreate, queue, length);
+    return queue;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Queue_Name(uint32_t queue, const char *name)
+{
+    if (queue >= TRC_RTOS_MAX_NAMES || name == NULL) return;
+
+    uint32_t primask = mask_interrupts();
+    Queue_Names[queue]   = name;
+    Queue_Names_Pending |= (1UL << queue);
+    restore_interrupts(primask);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Enable(bool enable, bool isr_enable)
+{
+    if (enable && !TRC_RTOS_Enabled)
+    {
+        uint32_t primask = mask_interrupts();
+        Task_Names_Pending  = 0;
+        Queue_Names_Pending = 0;
+        for (uint32_t number=0; number<TRC_RTOS_MAX_NAMES; number++)
+        {
+            if (Task_Names[number]  != NULL) Task_Names_Pending  |= (1UL << number);
+            if (Queue_Names[number] != NULL) Queue_Names_Pending |= (1UL << number);
+        }
+        restore_interrupts(primask);
+    }
+    TRC_RTOS_Enabled     = enable;
+    TRC_RTOS_Isr_Enabled = enable && isr_enable;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The names go first, so that the host can label the events that follow;
+// then any loss is reported, then the events themselves.  The tail is
+// advanced only once the record has been dispatched.
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Flush(void)
+{
+    uint32_t count = 0;
+
+    count = put_pending_names(count, trcRtosEvtTaskName,  Task_Names,  &Task_Names_Pending);
+    count = put_pending_names(count, trcRtosEvtQueueName, Queue_Names, &Queue_Names_Pending);
+
+    uint32_t lost = Lost;
+    if (lost != Lost_Reported && count < EVENTS_PER_RECORD)
+    {
+        uint32_t lost_now = lost - Lost_Reported;
+        Record_Buffer[count++] = (trcRtosEvent){
+            .cycles = TRC_SPAN_CYCLES(),
+            .event  = trcRtosEvtLost,
+            .arg8   = 0,
+            .arg16  = (uint16_t)(lost_now > UINT16_MAX ? UINT16_MAX : lost_now),
+        };
+        Lost_Reported = lost;
+    }
+
+    uint32_t tail = Tail;
+    uint32_t head = Head;
+    while (tail != head && count < EVENTS_PER_RECORD) {
+        Record_Buffer[count++] = Ring[tail++ & (TRC_RTOS_RING_SIZE - 1U)];
+    }
+
+    if (count == 0) return;
+
+    TRC_Record record = {
+        .type          = trcTypeEvent,
+        .level         = trcLvlDebug,
+        .module        = trcModRtos,
+        .file_name     = NULL,
+        .function_name = NULL,
+        .line_number   = 0,
+        .timestamp     = TRC_Adapt_Timestamp(),
+        .msg           = (const uint8_t *)Record_Buffer,
+        .msg_len       = count * sizeof(trcRtosEvent),
+    };
+    TRC_Sink_Dispatch(&record);
+
+    Tail = tail;
+    Flushed += count;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_RTOS_Get_Stats(TRC_RTOS_Stats *stats_out)
+{
+    stats_out->enabled     = TRC_RTOS_Enabled;
+    stats_out->isr_enabled = TRC_RTOS_Isr_Enabled;
+    stats_out->recorded = Recorded;
+    stats_out->lost     = Lost;
+    stats_out->flushed  = Flushed;
+    stats_out->pending  = Head - Tail;
+}
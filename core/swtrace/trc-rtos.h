@@ -0,0 +1,251 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE RTOS EVENTS
+core/swtrace/trc-rtos.h
+
+Description:
+    Implements the FreeRTOS trace macros to record a timeline of scheduler
+    activity: context switches, tasks made ready, delays, priority changes,
+    queue sends and receives, blocking on queues, and interrupt entry and exit.
+
+    This file is included at the end of FreeRTOSConfig.h, so that the macros
+    are expanded within the kernel sources; they refer to kernel internals,
+    e.g. pxCurrentTCB and the TCB and queue members, and therefore must not
+    be used anywhere else.
+
+    Each event is eight bytes: the DWT cycle count, the event ID, an 8-bit
+    argument, typically a task or queue number, and a 16-bit argument.
+    Events are written into a RAM ring with interrupts briefly masked;
+    nothing is formatted in the kernel's critical paths.  The ring is emptied
+    by TRC_RTOS_Flush(), called from the idle hook, which packs the events
+    into records of type trcTypeEvent, module trcModRtos, at debug level,
+    and dispatches them to the binary trace sinks; see trc-sink.h.
+    tools/trc-rtos-chrome converts a capture into a Chrome trace for viewing
+    in chrome://tracing or the Perfetto UI.
+
+    Tasks and queues are identified by number; the kernel numbers tasks,
+    and queues are numbered here as they are created.  Their names are sent
+    as events too, each time recording is started and as they are created.
+
+    Recording is off at startup; start it with 'trc rtos on'.  A capture needs
+    a binary sink as well; e.g. 'trc sink usart-bin debug'.
+
+    Interrupt entry and exit are recorded only by 'trc rtos isr', and only for
+    handlers that use trcRtosIsrEnter() and trcRtosIsrExit().  When the trace
+    is carried by the USART, its interrupt fires for every byte sent, each
+    adding two events; capture interrupts over SWO, with the 'itm-bin' sink.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_ENABLE_RTOS
+#define TRC_ENABLE_RTOS 1
+#endif
+
+// Number of events held by the ring; MUST be a power of two.
+#ifndef TRC_RTOS_RING_SIZE
+#define TRC_RTOS_RING_SIZE (256U)
+#endif
+
+// Number of task and queue names kept; tasks and queues numbered
+// beyond this are recorded, but their names are not sent.
+#ifndef TRC_RTOS_MAX_NAMES
+#define TRC_RTOS_MAX_NAMES (16U)
+#endif
+
+// The port's SysTick handler enters and exits at the tick rate;
+// recording it multiplies the event rate, so it is opt-in.
+#ifndef TRC_RTOS_TRACE_TICK
+#define TRC_RTOS_TRACE_TICK 0
+#endif
+
+// Further work to do as each task is switched in and out, whether or not
+// recording is enabled; e.g. the idle time of core/prof/cpu-load.h.
+// Define these before this file is included; they expand within tasks.c.
+#ifndef TRC_RTOS_SWITCHED_IN_HOOK
+#define TRC_RTOS_SWITCHED_IN_HOOK() do{} while(0)
+#endif
+#ifndef TRC_RTOS_SWITCHED_OUT_HOOK
+#define TRC_RTOS_SWITCHED_OUT_HOOK() do{} while(0)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// Event IDs;
+// Keep these in sync with tools/trc-rtos-chrome.
+// -----------------------------------------------------------------------------+-
+typedef enum
+{
+    trcRtosEvtNone = 0,
+    trcRtosEvtTaskIn,           // task;
+    trcRtosEvtTaskOut,          // task;
+    trcRtosEvtTaskReady,        // task;
+    trcRtosEvtTaskDelay,        // task; wake time, low 16 bits, or 0;
+    trcRtosEvtTaskCreate,       // task; priority;
+    trcRtosEvtTaskDelete,       // task;
+    trcRtosEvtTaskPriority,     // task; new priority;
+    trcRtosEvtTaskName,         // task; two characters of the name;
+    trcRtosEvtQueueCreate,      // queue; length;
+    trcRtosEvtQueueName,        // queue; two characters of the name;
+    trcRtosEvtQueueSend,        // queue; messages waiting before;
+    trcRtosEvtQueueSendFailed,  // queue; messages waiting;
+    trcRtosEvtQueueReceive,     // queue; messages waiting before;
+    trcRtosEvtQueueReceiveFailed,
+    trcRtosEvtQueueBlockSend,   // queue;
+    trcRtosEvtQueueBlockReceive,
+    trcRtosEvtQueueSendIsr,     // queue; messages waiting before;
+    trcRtosEvtQueueReceiveIsr,  // queue; messages waiting before;
+    trcRtosEvtIsrEnter,         // exception number;
+    trcRtosEvtIsrExit,          // exception number;
+    trcRtosEvtLost,             // -; number of events lost, saturated;
+    trcRtosEvtNumOf,
+}   trcRtosEvt;
+
+typedef struct
+{
+    uint32_t  cycles;
+    uint8_t   event;
+    uint8_t   arg8;
+    uint16_t  arg16;
+
+}   trcRtosEvent;
+
+typedef struct
+{
+    bool      enabled;
+    bool      isr_enabled;
+    uint32_t  recorded;
+    uint32_t  lost;
+    uint32_t  flushed;
+    uint32_t  pending;
+
+}   TRC_RTOS_Stats;
+
+extern volatile bool TRC_RTOS_Enabled;
+extern volatile bool TRC_RTOS_Isr_Enabled;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Record one event; called by the macros below.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_RTOS_Record(trcRtosEvt event, uint32_t arg8, uint32_t arg16);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Note the creation of a task or queue, and keep its name;
+// The queue function returns the number assigned to the queue.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void     TRC_RTOS_Task_Create(uint32_t task, uint32_t priority, const char *name);
+extern void     TRC_RTOS_Task_Delete(uint32_t task);
+extern uint32_t TRC_RTOS_Queue_Create(uint32_t length);
+extern void     TRC_RTOS_Queue_Name(uint32_t queue, const char *name);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Record interrupt entry and exit, by exception number;
+// For use in application interrupt handlers.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_RTOS_Isr(trcRtosEvt event);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Start or stop recording, with or without interrupts;
+// Starting queues the known names to be sent.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_RTOS_Enable(bool enable, bool isr_enable);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Send up to one record's worth of events to the trace sinks;
+// Call from the idle hook, or another low priority task; not from an ISR.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_RTOS_Flush(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Report the recording statistics;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_RTOS_Get_Stats(TRC_RTOS_Stats *stats_out);
+
+
+// -----------------------------------------------------------------------------+-
+// FreeRTOS Trace Macros
+// -----------------------------------------------------------------------------+-
+#if TRC_ENABLE_RTOS == 1
+
+#define TRC_RTOS_EVENT(_event_, _arg8_, _arg16_) do { \
+    if (TRC_RTOS_Enabled) TRC_RTOS_Record((_event_), (uint32_t)(_arg8_), (uint32_t)(_arg16_)); \
+} while(0)
+
+#define trcRtosIsrEnter() do { if (TRC_RTOS_Isr_Enabled) TRC_RTOS_Isr(trcRtosEvtIsrEnter); } while(0)
+#define trcRtosIsrExit()  do { if (TRC_RTOS_Isr_Enabled) TRC_RTOS_Isr(trcRtosEvtIsrExit);  } while(0)
+
+// tasks.c
+#define traceTASK_SWITCHED_IN() do { \
+    TRC_RTOS_SWITCHED_IN_HOOK(); \
+    TRC_RTOS_EVENT(trcRtosEvtTaskIn, pxCurrentTCB->uxTCBNumber, 0); \
+} while(0)
+#define traceTASK_SWITCHED_OUT() do { \
+    TRC_RTOS_EVENT(trcRtosEvtTaskOut, pxCurrentTCB->uxTCBNumber, 0); \
+    TRC_RTOS_SWITCHED_OUT_HOOK(); \
+} while(0)
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) \
+    TRC_RTOS_EVENT(trcRtosEvtTaskReady, (pxTCB)->uxTCBNumber, 0)
+#define traceTASK_DELAY() \
+    TRC_RTOS_EVENT(trcRtosEvtTaskDelay, pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_DELAY_UNTIL(xTimeToWake) \
+    TRC_RTOS_EVENT(trcRtosEvtTaskDelay, pxCurrentTCB->uxTCBNumber, (xTimeToWake) & 0xFFFFU)
+#define traceTASK_PRIORITY_SET(pxTask, uxNewPriority) \
+    TRC_RTOS_EVENT(trcRtosEvtTaskPriority, (pxTask)->uxTCBNumber, (uxNewPriority))
+#define traceTASK_PRIORITY_INHERIT(pxTCBOfMutexHolder, uxInheritedPriority) \
+    TRC_RTOS_EVENT(trcRtosEvtTaskPriority, (pxTCBOfMutexHolder)->uxTCBNumber, (uxInheritedPriority))
+#define traceTASK_PRIORITY_DISINHERIT(pxTCBOfMutexHolder, uxOriginalPriority) \
+    TRC_RTOS_EVENT(trcRtosEvtTaskPriority, (pxTCBOfMutexHolder)->uxTCBNumber, (uxOriginalPriority))
+#define traceTASK_CREATE(pxNewTCB) \
+    TRC_RTOS_Task_Create((pxNewTCB)->uxTCBNumber, (pxNewTCB)->uxPriority, (pxNewTCB)->pcTaskName)
+#define traceTASK_DELETE(pxTCB) \
+    TRC_RTOS_Task_Delete((pxTCB)->uxTCBNumber)
+
+// queue.c
+#define traceQUEUE_CREATE(pxNewQueue) \
+    (pxNewQueue)->uxQueueNumber = TRC_RTOS_Queue_Create((pxNewQueue)->uxLength)
+#define traceQUEUE_REGISTRY_ADD(xQueue, pcQueueName) \
+    TRC_RTOS_Queue_Name((xQueue)->uxQueueNumber, (pcQueueName))
+#define traceQUEUE_SEND(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueSend, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FAILED(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueSendFailed, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueReceive, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueReceiveFailed, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueBlockSend, (pxQueue)->uxQueueNumber, 0)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueBlockReceive, (pxQueue)->uxQueueNumber, 0)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueSendIsr, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) \
+    TRC_RTOS_EVENT(trcRtosEvtQueueReceiveIsr, (pxQueue)->uxQueueNumber, (pxQueue)->uxMessagesWaiting)
+
+// port.c; the SysTick handler, where the port calls them;
+#if TRC_RTOS_TRACE_TICK == 1
+#define traceISR_ENTER()              trcRtosIsrEnter()
+#define traceISR_EXIT()               trcRtosIsrExit()
+#define traceISR_EXIT_TO_SCHEDULER()  trcRtosIsrExit()
+#endif
+
+#else
+
+#define trcRtosIsrEnter() do{} while(0)
+#define trcRtosIsrExit()  do{} while(0)
+
+#define traceTASK_SWITCHED_IN()  TRC_RTOS_SWITCHED_IN_HOOK()
+#define traceTASK_SWITCHED_OUT() TRC_RTOS_SWITCHED_OUT_HOOK()
+
+#endif
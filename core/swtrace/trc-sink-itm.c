@@ -0,0 +1,179 @@
+
+/*
+================================================================================================#=
+TRACE ITM SINK
+core/swtrace/trc-sink-itm.c
+
+Description:
+    Trace sinks that write to the ITM stimulus ports.
+    See trc-sink-itm.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "trc-sink-itm.h"
+#include "trc-frame.h"
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+#define ITM_LOCK_ACCESS_KEY (0xC5ACCE55U)
+#define TPIU_PROTOCOL_NRZ   (2U)
+
+static uint8_t Frame_Buffer[UINT8_MAX];
+
+// The SWO bit rate, once configured; kept for a change of core clock;
+static uint32_t Swo_Bit_Rate = 0;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Returns true if the ITM, and the given stimulus port, are enabled;
+// ---------------------------------------------------------------------------------------------+-
+static bool itm_port_is_enabled(uint32_t port)
+{
+    if ((CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) == 0) return false;
+    if ((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0)                return false;
+    if ((ITM->TER & (1UL << port)) == 0)                      return false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Wait, for a bounded time, until the given stimulus port can accept a write;
+// Reading a stimulus port returns non-zero when its FIFO has room.
+// ---------------------------------------------------------------------------------------------+-
+static bool itm_port_wait_ready(uint32_t port)
+{
+    for (uint32_t spin=0; spin<TRC_ITM_SPIN_LIMIT; spin++)
+    {
+        if (ITM->PORT[port].u32 != 0) return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Write the given bytes to the given stimulus port;
+// Whole words are written as such, since each write costs one SWO packet
+// header whatever its size; any remaining bytes are written one at a time.
+// Returns false if the FIFO stayed full and the rest was dropped.
+// ---------------------------------------------------------------------------------------------+-
+static bool itm_port_write(uint32_t port, const uint8_t *buff, uint32_t len)
+{
+    if (!itm_port_is_enabled(port)) return false;
+
+    uint32_t idx = 0;
+    while (len - idx >= 4)
+    {
+        if (!itm_port_wait_ready(port)) return false;
+
+        ITM->PORT[port].u32 =
+            ((uint32_t)buff[idx])           | ((uint32_t)buff[idx+1] << 8) |
+            ((uint32_t)buff[idx+2] << 16)   | ((uint32_t)buff[idx+3] << 24);
+        idx += 4;
+    }
+    while (idx < len)
+    {
+        if (!itm_port_wait_ready(port)) return false;
+
+        ITM->PORT[port].u8 = buff[idx];
+        idx++;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Sink write functions;
+// ---------------------------------------------------------------------------------------------+-
+static bool itm_text_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    if (record->level >= trcLvlNone) return false;
+
+    return itm_port_write(TRC_ITM_TEXT_PORT_BASE + record->level, record->msg, record->msg_len);
+}
+
+static bool itm_binary_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    uint32_t frame_len = TRC_Frame_Encode(record, Frame_Buffer, sizeof(Frame_Buffer));
+    if (frame_len == 0) return false;
+
+    return itm_port_write(TRC_ITM_BINARY_PORT, Frame_Buffer, frame_len);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Data and Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+TRC_Sink TRC_Sink_ITM_Text = {
+    .name      = "itm",
+    .write     = itm_text_sink_write,
+    .occupancy = NULL,
+    .context   = NULL,
+    .min_level = trcLvlNone,
+};
+
+TRC_Sink TRC_Sink_ITM_Binary = {
+    .name      = "itm-bin",
+    .write     = itm_binary_sink_write,
+    .occupancy = NULL,
+    .context   = NULL,
+    .min_level = trcLvlNone,
+    .binary    = true,
+};
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_Sink_ITM_Configure_SWO(uint32_t core_clock_hz, uint32_t swo_bit_rate)
+{
+    // C_DEBUGEN rather than TRCENA, which the DWT cycle counter sets too;
+    if ((CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) == 0) return false;
+    if (swo_bit_rate == 0 || swo_bit_rate > core_clock_hz)       return false;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    // Route the trace clock and the SWO pin; asynchronous mode.
+    DBGMCU->CR |= DBGMCU_CR_TRACE_IOEN;
+    DBGMCU->CR &= ~DBGMCU_CR_TRACE_MODE;
+
+    // TPIU: NRZ encoding at the requested bit rate; no formatter.
+    TPI->SPPR = TPIU_PROTOCOL_NRZ;
+    TPI->ACPR = (core_clock_hz / swo_bit_rate) - 1U;
+    TPI->FFCR = 0x100U;
+    Swo_Bit_Rate = swo_bit_rate;
+
+    // ITM: unlock, enable, and enable the stimulus ports used by the sinks.
+    ITM->LAR  = ITM_LOCK_ACCESS_KEY;
+    ITM->TCR  = ITM_TCR_ITMENA_Msk | ITM_TCR_SYNCENA_Msk | (1UL << ITM_TCR_TraceBusID_Pos);
+    ITM->TPR  = 0;
+    ITM->TER |= (0x0FUL << TRC_ITM_TEXT_PORT_BASE) | (1UL << TRC_ITM_BINARY_PORT);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The ITM is disabled while the core clock is too slow for the bit rate,
+// rather than let it send at a rate the probe cannot read.
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Sink_ITM_Core_Clock_Changed(uint32_t core_clock_hz)
+{
+    if (Swo_Bit_Rate == 0) return;
+
+    if (Swo_Bit_Rate > core_clock_hz) {
+        ITM->TCR &= ~ITM_TCR_ITMENA_Msk;
+        return;
+    }
+
+    TPI->ACPR = (core_clock_hz / Swo_Bit_Rate) - 1U;
+    ITM->TCR |= ITM_TCR_ITMENA_Msk;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE ITM SINK
+core/swtrace/trc-sink-itm.h
+
+Description:
+    Trace sinks that write to the Instrumentation Trace Macrocell (ITM)
+    of a Cortex-M3/M4/M7 core, from where the debug probe collects the trace
+    via the Serial Wire Output (SWO) pin; see tools/swo-decode.
+
+    Writing to the ITM costs a few core cycles per word and neither uses
+    a USART nor raises interrupts; it can therefore carry far more trace
+    than the CLI USART, and it keeps working in an ISR or with interrupts
+    disabled.
+
+    Records are channelized over the ITM stimulus ports:
+        text sink "itm"        port TRC_ITM_TEXT_PORT_BASE + level
+        binary sink "itm-bin"  port TRC_ITM_BINARY_PORT; see trc-frame.h
+
+    Backpressure:
+    The ITM FIFO accepts a new word only when the previous one has been
+    taken; the sink waits for it for at most TRC_ITM_SPIN_LIMIT polls.
+    When the wait times out, the rest of the record is dropped and counted
+    as dropped; a truncated binary frame fails its checksum on the host.
+    When no debug probe has enabled the ITM and the stimulus port,
+    records are dropped at once, at the cost of a couple of loads.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdint.h>
+
+#include "trc-sink.h"
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_ITM_TEXT_PORT_BASE
+#define TRC_ITM_TEXT_PORT_BASE (0U)    // Ports 0..3 for DEBUG..FATAL;
+#endif
+
+#ifndef TRC_ITM_BINARY_PORT
+#define TRC_ITM_BINARY_PORT (8U)
+#endif
+
+#ifndef TRC_ITM_SPIN_LIMIT
+#define TRC_ITM_SPIN_LIMIT (1000U)
+#endif
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// The ITM text and binary sinks; named "itm" and "itm-bin";
+// Both are off, i.e. at level trcLvlNone, until enabled by the owner.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern TRC_Sink TRC_Sink_ITM_Text;
+extern TRC_Sink TRC_Sink_ITM_Binary;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Configure the ITM, and the TPIU for asynchronous SWO output in NRZ (UART)
+// encoding at the given bit rate, and enable the stimulus ports used here.
+//
+// This is optional: a debug probe typically does the same when asked to
+// capture SWO trace, e.g. OpenOCD's 'tpiu config' or 'swo create'.
+// Returns false, having claimed neither the SWO pin nor the TPIU, if no
+// debugger is attached, i.e. DHCSR C_DEBUGEN is clear.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_Sink_ITM_Configure_SWO(uint32_t core_clock_hz, uint32_t swo_bit_rate);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Call when the core clock changes, e.g. from a clock profile subscriber;
+// The TPIU prescaler is recomputed so that the SWO bit rate is kept.
+// Does nothing unless TRC_Sink_ITM_Configure_SWO() configured it.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Sink_ITM_Core_Clock_Changed(uint32_t core_clock_hz);
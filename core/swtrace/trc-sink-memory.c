@@ -0,0 +1,78 @@
+
+/*
+================================================================================================#=
+TRACE MEMORY SINK
+core/swtrace/trc-sink-memory.c
+
+Description:
+    A trace sink that captures records in a linear memory buffer.
+    See trc-sink-memory.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "trc-sink-memory.h"
+
+#include <string.h>
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Sink write function;
+// ---------------------------------------------------------------------------------------------+-
+static bool memory_sink_write(TRC_Sink *sink, const TRC_Record *record)
+{
+    TRC_Sink_Memory *memory = (TRC_Sink_Memory *)sink->context;
+
+    if (record->msg_len > memory->size - memory->used) return false;
+
+    uint8_t *content = &memory->buff[memory->used];
+    memcpy(content, record->msg, record->msg_len);
+
+    memory->used += record->msg_len;
+    memory->records++;
+
+    memory->last     = *record;
+    memory->last.msg = content;
+    return true;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Sink_Memory_Init(
+    TRC_Sink *sink, TRC_Sink_Memory *memory, const char *name, trcLvl min_level,
+    uint8_t *buff, uint32_t buff_size)
+{
+    memory->buff = buff;
+    memory->size = buff_size;
+    TRC_Sink_Memory_Clear(memory);
+
+    sink->name      = name;
+    sink->write     = memory_sink_write;
+    sink->occupancy = NULL;
+    sink->context   = memory;
+    sink->min_level = min_level;
+    sink->binary    = false;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Sink_Memory_Clear(TRC_Sink_Memory *memory)
+{
+    memory->used    = 0;
+    memory->records = 0;
+    memset(&memory->last, 0, sizeof(memory->last));
+    return;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE MEMORY SINK
+core/swtrace/trc-sink-memory.h
+
+Description:
+    A trace sink that appends the content of each record to a linear
+    buffer in memory; once the buffer is full, further records are dropped.
+
+    This sink has no hardware dependencies; it is intended for host-side
+    testing of trace clients and of the trace core itself, and for
+    capturing the trace of a short sequence for later inspection.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdint.h>
+
+#include "trc-sink.h"
+
+
+// -----------------------------------------------------------------------------+-
+// State of one memory sink; allocated by the client.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint8_t    *buff;
+    uint32_t    size;
+    uint32_t    used;       // Bytes of content held in the buffer;
+    uint32_t    records;    // Records held in the buffer;
+    TRC_Record  last;       // The most recent record; its content points into the buffer;
+
+}   TRC_Sink_Memory;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Set up the given sink to write into the given buffer;
+// The sink is named and given a minimum level, but not registered;
+// the caller does so with TRC_Sink_Register().
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Sink_Memory_Init(
+    TRC_Sink        *sink,
+    TRC_Sink_Memory *memory,
+    const char      *name,
+    trcLvl           min_level,
+    uint8_t         *buff,
+    uint32_t         buff_size );
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Discard the content of the given memory sink;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Sink_Memory_Clear(TRC_Sink_Memory *memory);
@@ -0,0 +1,133 @@
+
+/*
+================================================================================================#=
+TRACE SINK REGISTRY
+core/swtrace/trc-sink.c
+
+Description:
+    Fans trace records out to the registered sinks.
+    See trc-sink.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stddef.h>
+#include <string.h>
+
+#define TRC_MODULE trcModTrace
+#include "trc-sink.h"
+#include "trc-adaptation.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+static TRC_Sink *Sink_Table[TRC_SINK_MAX_SINKS];
+static uint32_t  Sink_Count = 0;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_Sink_Register(TRC_Sink *given_sink)
+{
+    if (given_sink == NULL || given_sink->write == NULL) return false;
+    if (Sink_Count >= TRC_SINK_MAX_SINKS) return false;
+
+    given_sink->delivered = 0;
+    given_sink->dropped   = 0;
+
+    Sink_Table[Sink_Count++] = given_sink;
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_Sink_Dispatch(const TRC_Record *record)
+{
+    bool accepted = false;
+
+    for (uint32_t idx=0; idx<Sink_Count; idx++)
+    {
+        TRC_Sink *sink = Sink_Table[idx];
+        if (record->level < sink->min_level) continue;
+        if (record->type == trcTypeEvent && !sink->binary) continue;
+
+        if (sink->write(sink, record)) {
+            sink->delivered++;
+            accepted = true;
+        }
+        else {
+            sink->dropped++;
+        }
+    }
+    return accepted;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_Sink_Dispatch_Text(trcLvl level, const char *text, uint32_t text_len)
+{
+    TRC_Record record = {
+        .type          = trcTypeRaw,
+        .level         = level,
+        .module        = trcModTrace,
+        .file_name     = NULL,
+        .function_name = NULL,
+        .line_number   = 0,
+        .timestamp     = TRC_Adapt_Timestamp(),
+        .msg           = (const uint8_t *)text,
+        .msg_len       = text_len,
+    };
+    return TRC_Sink_Dispatch(&record);
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_Sink_Occupancy_Percent(trcLvl level)
+{
+    uint32_t highest = 0;
+
+    for (uint32_t idx=0; idx<Sink_Count; idx++)
+    {
+        TRC_Sink *sink = Sink_Table[idx];
+        if (sink->occupancy == NULL || level < sink->min_level) continue;
+
+        uint32_t occupancy = sink->occupancy(sink, level);
+        if (occupancy > highest) highest = occupancy;
+    }
+    return highest;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_Sink_Count(void)
+{
+    return Sink_Count;
+}
+
+TRC_Sink *TRC_Sink_Get(uint32_t index)
+{
+    if (index >= Sink_Count) return NULL;
+
+    return Sink_Table[index];
+}
+
+TRC_Sink *TRC_Sink_Find(const char *given_name)
+{
+    for (uint32_t idx=0; idx<Sink_Count; idx++)
+    {
+        if (strcmp(given_name, Sink_Table[idx]->name) == 0) return Sink_Table[idx];
+    }
+    return NULL;
+}
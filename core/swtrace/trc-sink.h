@@ -0,0 +1,130 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE SINK REGISTRY
+core/swtrace/trc-sink.h
+
+Description:
+    Defines the API by which trace records are fanned out to one or more sinks.
+
+    A sink is a backend that consumes trace records; e.g. the USART CLI,
+    the SRAM2 flight recorder, or an in-memory buffer for host testing.
+    Sinks are registered with the trace core at startup, typically by
+    the trace adaptation, and every dispatched record is offered to each
+    registered sink in turn.
+
+    The trace core formats each message exactly once; every sink is given
+    a pointer to the same record, and hence to the same formatted content.
+    A sink that needs to keep the content must copy it before returning.
+
+    Each sink has its own minimum level, independent of the module levels,
+    and its own counts of records delivered and dropped.
+
+    Records of type trcTypeEvent hold binary content, not text; they are
+    offered only to the sinks that declare themselves binary, i.e. those
+    that encode each record as a frame; see trc-frame.h.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "trc.h"
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_SINK_MAX_SINKS
+#define TRC_SINK_MAX_SINKS (8U)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// Trace Record
+//
+// Describes one trace message; shared, read-only, by every sink.
+// The file and function names are NULL for messages generated
+// by the trace facility itself.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    trcType         type;
+    trcLvl          level;
+    trcMod          module;
+    const char     *file_name;
+    const char     *function_name;
+    int             line_number;
+    uint32_t        timestamp;      // See TRC_Adapt_Timestamp();
+    const uint8_t  *msg;            // Formatted content; not NUL terminated;
+    uint32_t        msg_len;
+
+}   TRC_Record;
+
+
+// -----------------------------------------------------------------------------+-
+// Trace Sink
+//
+// The owner of the sink allocates the structure, typically as a static,
+// fills in the name, functions, context, and initial minimum level,
+// and then registers it; the structure must remain valid thereafter.
+//
+// The write function returns false if the record was dropped.
+// The occupancy function is optional; when given, it returns how full
+// the sink's queue for records of the given level is, in percent,
+// and is used by the trace throttle; see trc-throttle.h.
+// -----------------------------------------------------------------------------+-
+typedef struct TRC_Sink_Struct TRC_Sink;
+
+typedef bool     (*TRC_Sink_Write_Func)(TRC_Sink *sink, const TRC_Record *record);
+typedef uint32_t (*TRC_Sink_Occupancy_Func)(TRC_Sink *sink, trcLvl level);
+
+struct TRC_Sink_Struct
+{
+    const char              *name;
+    TRC_Sink_Write_Func      write;
+    TRC_Sink_Occupancy_Func  occupancy;   // Optional;
+    void                    *context;     // For use by the sink;
+    volatile trcLvl          min_level;
+    bool                     binary;      // Accepts trcTypeEvent records;
+
+    // Maintained by the registry;
+    uint32_t                 delivered;
+    uint32_t                 dropped;
+};
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Register the given sink;
+// Returns false if the registry is full.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_Sink_Register(TRC_Sink *given_sink);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Offer the given record to every sink whose minimum level it meets;
+// Returns true if at least one sink accepted it.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_Sink_Dispatch(const TRC_Record *record);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Convenience for messages generated by the trace facility itself;
+// Wraps the given pre-formatted text in a record and dispatches it.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_Sink_Dispatch_Text(trcLvl level, const char *text, uint32_t text_len);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the highest occupancy, in percent, among the sinks
+// that would accept a record of the given level.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t TRC_Sink_Occupancy_Percent(trcLvl level);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Access the registered sinks, by index or by name;
+// These return NULL when there is no such sink.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t  TRC_Sink_Count(void);
+extern TRC_Sink *TRC_Sink_Get(uint32_t index);
+extern TRC_Sink *TRC_Sink_Find(const char *given_name);
@@ -0,0 +1,132 @@
+
+/*
+================================================================================================#=
+TRACE SPANS
+core/swtrace/trc-span.c
+
+Description:
+    Holds the span ring written by the span macros in trc.h,
+    and implements the API in trc-span.h to inspect it.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "trc-span.h"
+
+#include <string.h>
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+_Static_assert((TRC_SPAN_RING_SIZE & (TRC_SPAN_RING_SIZE - 1)) == 0,
+    "TRC_SPAN_RING_SIZE must be a power of two");
+
+// -----------------------------------------------------------------------------+-
+// Written by the span macros; see trc.h.
+// The count runs freely; the ring index is the count modulo the size.
+// -----------------------------------------------------------------------------+-
+trcSpanEvent TRC_Span_Ring[TRC_SPAN_RING_SIZE];
+uint32_t     TRC_Span_Count = 0;
+
+static trcSpanEvent Snapshot[TRC_SPAN_RING_SIZE];
+static uint32_t     Snapshot_Len = 0;
+
+// -----------------------------------------------------------------------------+-
+// Printable names for each span;
+// Keep these in sync with the enum in trc.h.
+// -----------------------------------------------------------------------------+-
+static const char* SpanNames[trcSpanNumOf] = {
+    [trcSpanUsartTdrEmpty]  = "usart_tdr_empty",
+    [trcSpanUsartInputChar] = "process_input_char",
+    [trcSpanCliCommand]     = "cli_command",
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+uint32_t TRC_Span_Take_Snapshot(void)
+{
+    uint32_t count = TRC_Span_Count;
+    uint32_t len   = (count < TRC_SPAN_RING_SIZE) ? count : TRC_SPAN_RING_SIZE;
+    uint32_t start = count - len;
+
+    for (uint32_t idx=0; idx<len; idx++)
+    {
+        Snapshot[idx] = TRC_Span_Ring[(start + idx) & (TRC_SPAN_RING_SIZE - 1U)];
+    }
+    Snapshot_Len = len;
+    return len;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_Span_Get_Event(uint32_t index, trcSpanEvent *event_out)
+{
+    if (index >= Snapshot_Len) return false;
+
+    *event_out = Snapshot[index];
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Span_Summarize(TRC_Span_Stats *stats_out)
+{
+    uint32_t begin_cycles[trcSpanNumOf];
+    bool     begin_seen[trcSpanNumOf];
+
+    memset(stats_out,  0, sizeof(TRC_Span_Stats) * trcSpanNumOf);
+    memset(begin_seen, 0, sizeof(begin_seen));
+
+    for (uint32_t idx=0; idx<Snapshot_Len; idx++)
+    {
+        uint32_t span = Snapshot[idx].tag & ~TRC_SPAN_END_FLAG;
+        if (span >= trcSpanNumOf) continue;
+
+        if ((Snapshot[idx].tag & TRC_SPAN_END_FLAG) == 0)
+        {
+            begin_cycles[span] = Snapshot[idx].cycles;
+            begin_seen[span]   = true;
+            continue;
+        }
+        if (!begin_seen[span]) continue;
+        begin_seen[span] = false;
+
+        // Unsigned subtraction copes with the counter wrapping;
+        uint32_t cycles = Snapshot[idx].cycles - begin_cycles[span];
+
+        TRC_Span_Stats *stats = &stats_out[span];
+        if (stats->count == 0 || cycles < stats->min_cycles) stats->min_cycles = cycles;
+        if (cycles > stats->max_cycles)                       stats->max_cycles = cycles;
+        stats->total_cycles += cycles;
+        stats->count++;
+    }
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Span_Clear(void)
+{
+    TRC_Span_Count = 0;
+    Snapshot_Len   = 0;
+    return;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+const char *TRC_Span_Get_Name(trcSpan given_span)
+{
+    if (given_span >= trcSpanNumOf) return "?";
+
+    return SpanNames[given_span];
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE SPANS
+core/swtrace/trc-span.h
+
+Description:
+    Defines the API to inspect the span ring; see "Software Trace Spans" in trc.h.
+
+    The ring is written continuously by the span macros; to get a consistent view,
+    a snapshot of the ring is taken first and the other functions work on that.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "trc.h"
+
+
+// -----------------------------------------------------------------------------+-
+// Per span statistics, in cycles, over the snapshot;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  count;
+    uint32_t  min_cycles;
+    uint32_t  max_cycles;
+    uint64_t  total_cycles;
+
+}   TRC_Span_Stats;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Copy the current content of the ring, oldest first, into the snapshot;
+// Returns the number of events in the snapshot.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern uint32_t TRC_Span_Take_Snapshot(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Get one event from the snapshot; Returns false if out of range.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_Span_Get_Event(uint32_t index, trcSpanEvent *event_out);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Pair the begin and end events in the snapshot and compute
+// the statistics of each span; stats_out holds trcSpanNumOf entries.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Span_Summarize(TRC_Span_Stats *stats_out);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Discard the content of the ring;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Span_Clear(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Printable name of the given span;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern const char *TRC_Span_Get_Name(trcSpan given_span);
@@ -0,0 +1,255 @@
+
+/*
+================================================================================================#=
+TRACE THROTTLE
+core/swtrace/trc-throttle.c
+
+Description:
+    Adaptive throttling of trace messages driven by backend occupancy.
+    See trc-throttle.h for details.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdio.h>
+
+#define TRC_MODULE trcModTrace
+#include "trc-throttle.h"
+#include "trc-sink.h"
+#include "trc-adaptation.h"
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// -----------------------------------------------------------------------------+-
+// Messages below this level are throttled;
+// trcLvlDebug means that nothing is being throttled.
+// -----------------------------------------------------------------------------+-
+static trcLvl Throttle_Level = trcLvlDebug;
+
+// -----------------------------------------------------------------------------+-
+// Recently seen call sites, while under pressure;
+// A call site is identified by its function name and line number;
+// its budget is renewed at the start of each interval, in timestamp ticks.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    const char *function_name;
+    int         line_number;
+    uint32_t    interval_start;
+    uint32_t    admitted;       // Messages sent in this interval;
+    uint32_t    repeats;        // Messages over the budget, since the last report;
+
+}   Call_Site;
+
+static Call_Site Call_Sites[TRC_THROTTLE_CALL_SITES];
+static uint32_t  Next_Call_Site = 0;
+
+// -----------------------------------------------------------------------------+-
+// Counts suppressed since the last in-band report;
+// Repeats_Evicted holds the repeats of call sites that were pushed out
+// of the table by newer call sites before they could be reported.
+// -----------------------------------------------------------------------------+-
+static uint32_t Pending_Suppressed[trcLvlError];
+static uint32_t Repeats_Evicted = 0;
+static bool     Report_Pending  = false;
+
+// -----------------------------------------------------------------------------+-
+// Running totals;
+// -----------------------------------------------------------------------------+-
+static uint32_t Total_Suppressed[trcLvlError];
+static uint32_t Total_Repeats = 0;
+
+#ifndef REPORT_BUFFER_SIZE
+#define REPORT_BUFFER_SIZE (80U)
+#endif
+static char Report_Buffer[REPORT_BUFFER_SIZE];
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Raise or lower the throttle level based on the given backend occupancy;
+// The hysteresis keeps the throttle from chattering around a threshold.
+// ---------------------------------------------------------------------------------------------+-
+static void update_throttle_level(uint32_t occupancy_pct)
+{
+    const uint32_t occ_plus_hyst = occupancy_pct + TRC_THROTTLE_HYSTERESIS_PCT;
+
+    if (occupancy_pct >= TRC_THROTTLE_INFO_PCT)
+    {
+        Throttle_Level = trcLvlError;
+    }
+    else if (occupancy_pct >= TRC_THROTTLE_DEBUG_PCT)
+    {
+        if (Throttle_Level != trcLvlError || occ_plus_hyst < TRC_THROTTLE_INFO_PCT) {
+            Throttle_Level = trcLvlInfo;
+        }
+    }
+    else if (occ_plus_hyst < TRC_THROTTLE_DEBUG_PCT)
+    {
+        Throttle_Level = trcLvlDebug;
+    }
+    else if (Throttle_Level == trcLvlError && occ_plus_hyst < TRC_THROTTLE_INFO_PCT)
+    {
+        Throttle_Level = trcLvlInfo;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Returns true if the given call site has spent its budget for this interval;
+// A call site not yet tracked is remembered, possibly evicting the oldest one.
+// ---------------------------------------------------------------------------------------------+-
+static bool is_over_budget(const char *function_name, int line_number)
+{
+    uint32_t now      = TRC_Adapt_Timestamp();
+    uint32_t interval = (TRC_Adapt_Timestamp_Hz() / 1000U) * TRC_THROTTLE_SITE_INTERVAL_MS;
+
+    for (uint32_t idx=0; idx<TRC_THROTTLE_CALL_SITES; idx++)
+    {
+        Call_Site *site = &Call_Sites[idx];
+        if (site->function_name != function_name || site->line_number != line_number) continue;
+
+        if (now - site->interval_start >= interval) {
+            site->interval_start = now;
+            site->admitted       = 0;
+        }
+        if (site->admitted < TRC_THROTTLE_SITE_BUDGET) {
+            site->admitted++;
+            return false;
+        }
+        site->repeats++;
+        return true;
+    }
+
+    Call_Site *site = &Call_Sites[Next_Call_Site];
+    Next_Call_Site = (Next_Call_Site + 1) % TRC_THROTTLE_CALL_SITES;
+
+    Repeats_Evicted += site->repeats;
+
+    site->function_name  = function_name;
+    site->line_number    = line_number;
+    site->interval_start = now;
+    site->admitted       = 1;
+    site->repeats        = 0;
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Dispatch one report line at INFO level; Returns false if the backend has no room.
+// ---------------------------------------------------------------------------------------------+-
+static bool dispatch_report(int report_len)
+{
+    if (report_len <= 0) return true;
+    if (report_len >= REPORT_BUFFER_SIZE) report_len = REPORT_BUFFER_SIZE-1;
+
+    return TRC_Sink_Dispatch_Text(trcLvlInfo, Report_Buffer, report_len);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The pressure has subsided; report what was suppressed while it lasted.
+// Anything that cannot be reported now remains pending until next time.
+// ---------------------------------------------------------------------------------------------+-
+static void report_suppressed(void)
+{
+    for (uint32_t idx=0; idx<TRC_THROTTLE_CALL_SITES; idx++)
+    {
+        Call_Site *site = &Call_Sites[idx];
+        if (site->repeats > 0)
+        {
+            int report_len = snprintf(Report_Buffer, REPORT_BUFFER_SIZE,
+                "trc: %s:%d repeated %lu times\n",
+                site->function_name, site->line_number, (unsigned long)site->repeats
+            );
+            if (!dispatch_report(report_len)) return;
+        }
+        site->function_name = NULL;
+        site->line_number   = 0;
+        site->admitted      = 0;
+        site->repeats       = 0;
+    }
+
+    if (Pending_Suppressed[trcLvlDebug] || Pending_Suppressed[trcLvlInfo] || Repeats_Evicted)
+    {
+        int report_len = snprintf(Report_Buffer, REPORT_BUFFER_SIZE,
+            "trc: throttled %lu debug, %lu info, %lu other repeats\n",
+            (unsigned long)Pending_Suppressed[trcLvlDebug],
+            (unsigned long)Pending_Suppressed[trcLvlInfo],
+            (unsigned long)Repeats_Evicted
+        );
+        if (!dispatch_report(report_len)) return;
+    }
+
+    Pending_Suppressed[trcLvlDebug] = 0;
+    Pending_Suppressed[trcLvlInfo]  = 0;
+    Repeats_Evicted = 0;
+    Report_Pending  = false;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Public API Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+bool TRC_Throttle_Admit(trcLvl trace_level, const char *function_name, int line_number)
+{
+    if (trace_level >= trcLvlError) return true;
+
+    update_throttle_level(TRC_Sink_Occupancy_Percent(trace_level));
+
+    if (Throttle_Level == trcLvlDebug)
+    {
+        if (Report_Pending) report_suppressed();
+        return true;
+    }
+    Report_Pending = true;
+
+    if (trace_level < Throttle_Level)
+    {
+        Pending_Suppressed[trace_level]++;
+        Total_Suppressed[trace_level]++;
+        return false;
+    }
+
+    if (is_over_budget(function_name, line_number))
+    {
+        Total_Repeats++;
+        return false;
+    }
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// The occupancy is that of the sinks taking INFO, the level of the report.
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Throttle_Flush(void)
+{
+    if (!Report_Pending) return;
+
+    update_throttle_level(TRC_Sink_Occupancy_Percent(trcLvlInfo));
+    if (Throttle_Level == trcLvlDebug) report_suppressed();
+    return;
+}
+
+
+// ---------------------------------------------------------------------------------------------+-
+// ---------------------------------------------------------------------------------------------+-
+void TRC_Throttle_Get_Stats(TRC_Throttle_Stats *stats_out)
+{
+    stats_out->throttle_level            = Throttle_Level;
+    stats_out->suppressed[trcLvlDebug]   = Total_Suppressed[trcLvlDebug];
+    stats_out->suppressed[trcLvlInfo]    = Total_Suppressed[trcLvlInfo];
+    stats_out->repeats                   = Total_Repeats;
+    return;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+================================================================================================#=
+TRACE THROTTLE
+core/swtrace/trc-throttle.h
+
+Description:
+    Defines the API into the trace throttle sub-module.
+
+    The throttle watches the occupancy of the trace backend and, as the backend
+    fills up, automatically raises the effective minimum trace level above
+    the levels configured for each module.  While the backend is under pressure,
+    each call site is also rate limited: it may send TRC_THROTTLE_SITE_BUDGET
+    messages per TRC_THROTTLE_SITE_INTERVAL_MS, and the rest are counted as
+    repeats; so a busy call site stays visible through a storm.
+
+    The throttle makes its decision before the trace core formats the message,
+    so throttled messages cost neither formatting nor backend cycles.
+    Once the pressure subsides, the suppressed counts are reported in-band;
+    by the next message admitted, or by TRC_Throttle_Flush(), whichever
+    comes first.  Call the latter from idle, so that the report is not held
+    back when the trace stops along with the storm.
+
+    ERROR and FATAL messages are never throttled.
+
+    This sub-module is internal to the trace core; clients need include
+    this file only to call TRC_Throttle_Flush().
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "trc.h"
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+//
+// Backend occupancy, in percent, at or above which
+// DEBUG, and then also INFO, messages are throttled.
+// The throttle is released once the occupancy falls below
+// the threshold by at least the hysteresis amount.
+//
+// The number of distinct call sites tracked for repeat suppression,
+// and the messages each may send per interval while under pressure.
+// -----------------------------------------------------------------------------+-
+#ifndef TRC_THROTTLE_DEBUG_PCT
+#define TRC_THROTTLE_DEBUG_PCT (50U)
+#endif
+
+#ifndef TRC_THROTTLE_INFO_PCT
+#define TRC_THROTTLE_INFO_PCT (75U)
+#endif
+
+#ifndef TRC_THROTTLE_HYSTERESIS_PCT
+#define TRC_THROTTLE_HYSTERESIS_PCT (20U)
+#endif
+
+#ifndef TRC_THROTTLE_CALL_SITES
+#define TRC_THROTTLE_CALL_SITES (8U)
+#endif
+
+#ifndef TRC_THROTTLE_SITE_BUDGET
+#define TRC_THROTTLE_SITE_BUDGET (4U)
+#endif
+
+#ifndef TRC_THROTTLE_SITE_INTERVAL_MS
+#define TRC_THROTTLE_SITE_INTERVAL_MS (1000U)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// Running totals since startup;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    trcLvl    throttle_level;             // Current effective minimum level;
+    uint32_t  suppressed[trcLvlError];    // Throttled by level; DEBUG and INFO only;
+    uint32_t  repeats;                    // Suppressed as repeats from a call site;
+
+}   TRC_Throttle_Stats;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Decide whether the given message should be formatted and dispatched;
+// Returns false if the message is to be suppressed.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern bool TRC_Throttle_Admit(
+    trcLvl      trace_level,
+    const char *function_name,
+    int         line_number );
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Report the suppressed counts, if the pressure has subsided since;
+// Call from idle, e.g. the idle hook; cheap when there is nothing to report.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Throttle_Flush(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Copy the running totals into the given structure.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+extern void TRC_Throttle_Get_Stats(TRC_Throttle_Stats *stats_out);
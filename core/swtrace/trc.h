@@ -20,6 +20,8 @@ SPDX-License-Identifier: MIT-0
 ================================================================================================#=
 */
 
+#include <stdint.h>
+
 
 /*
 ------------------------------------------------------------------------------------------------+-
@@ -65,15 +67,52 @@ typedef enum
 ------------------------------------------------------------------------------------------------+-
 Software Trace Types
 ------------------------------------------------------------------------------------------------+-
+Event records carry packed binary events rather than text, and are only
+offered to the binary sinks; see trc-rtos.h.
+------------------------------------------------------------------------------------------------+-
 */
 typedef enum
 {
     trcTypeRaw = 0,
     trcTypeHex,
     trcTypeCom,
+    trcTypeEvent,
 }   trcType;
 
 
+/*
+------------------------------------------------------------------------------------------------+-
+Software Trace Modules
+------------------------------------------------------------------------------------------------+-
+Each source file that generates trace messages belongs to exactly one trace module.
+The minimum logging level is held per module in a table so that the level of
+one subsystem can be changed at run time without affecting any of the others.
+
+A source file identifies its module at build time by defining TRC_MODULE
+before including this file, for example:
+
+    #define TRC_MODULE trcModUsart
+    #include "core/swtrace/trc.h"
+
+Source files that do not define TRC_MODULE belong to the application module.
+When adding a new module, be sure to also add its name to the table in trc-core.c.
+------------------------------------------------------------------------------------------------+-
+*/
+typedef enum
+{
+    trcModApp = 0,
+    trcModTrace,
+    trcModCli,
+    trcModUsart,
+    trcModRtos,
+    trcModNumOf,
+}   trcMod;
+
+#ifndef TRC_MODULE
+#define TRC_MODULE trcModApp
+#endif
+
+
 // -----------------------------------------------------------------------------+-
 // BUILD-TIME CONFIGURATION
 //
@@ -91,35 +130,67 @@ typedef enum
 #define TRC_ENABLE_LVL_INFO 1
 #endif
 
+// Debug is left out by default; an application that builds it in, e.g.
+// freertos-l4, can then turn it on for one module at run time.
 #ifndef TRC_ENABLE_LVL_DEBUG
 #define TRC_ENABLE_LVL_DEBUG 0
 #endif
 
 
+// -----------------------------------------------------------------------------+-
+// RUN-TIME LEVEL FILTERING
+//
+// This table holds the minimum level to be dispatched for each module;
+// It is owned by the trace core and is changed via TRC_SetLogLevel() and friends.
+//
+// The trace macros below check the level of the caller's module inline so that
+// a filtered-out message costs only a load and a branch at the call site;
+// neither the call to the trace core nor the marshalling of its arguments
+// takes place unless the message will actually be dispatched.
+// -----------------------------------------------------------------------------+-
+extern volatile uint8_t TRC_Module_Level[trcModNumOf];
+
+#define TRC_LEVEL_IS_ENABLED(_level_) \
+    ((uint8_t)(_level_) >= TRC_Module_Level[TRC_MODULE])
+
+
 // -----------------------------------------------------------------------------+-
 // This is the core function that maps the API trace log functions
-// into a platform specific backend to handle the given trace message.
-// A typical handler would write the information to a serial port.
+// onto the platform specific backends that handle the given trace message.
+// The message is formatted once, into a trace record that is then
+// offered to every registered trace sink; see trc-sink.h.
 // -----------------------------------------------------------------------------+-
-extern void TRC_Core( trcType traceType,
+extern void TRC_Core( trcType traceType, trcMod traceModule,
         const char *fileName, const char *functionName, int lineNumber,
         trcLvl traceLevel, const char *formatStr, ...);
 
+// -----------------------------------------------------------------------------+-
+// The same for a hex dump of the given bytes; see trcHexDump() below.
+// -----------------------------------------------------------------------------+-
+extern void TRC_Core_Hex( trcMod traceModule,
+        const char *fileName, const char *functionName, int lineNumber,
+        trcLvl traceLevel, const void *data, uint32_t dataLen, uint32_t options);
+
 
 
 // -----------------------------------------------------------------------------+-
 // trcASSERT - a conditional FATAL
 // -----------------------------------------------------------------------------+-
 #define trcAssert(_condition_, formatStr, ...) if(!(_condition_)) { TRC_Core( \
-    trcTypeCom, __BASE_FILE__, __FUNCTION__, __LINE__, \
+    trcTypeCom, TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
     trcLvlFatal, formatStr, ##__VA_ARGS__ ); }
 
 
 // -----------------------------------------------------------------------------+-
 // trcFATAL
+//
+// FATAL (and hence trcAssert) is never filtered by the run-time module levels.
+// Once the message has been dispatched, the trace adaptation is told about
+// the fatal event; the default adaptation records it in the flight recorder
+// and resets the MCU.  See trc-adaptation.h and trc-flightrec.h.
 // -----------------------------------------------------------------------------+-
 #define trcFatal(formatStr, ...) TRC_Core( \
-    trcTypeCom, __BASE_FILE__, __FUNCTION__, __LINE__, \
+    trcTypeCom, TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
     trcLvlFatal, formatStr, ##__VA_ARGS__ )
 
 
@@ -129,9 +200,11 @@ extern void TRC_Core( trcType traceType,
 // -----------------------------------------------------------------------------+-
 #if TRC_ENABLE_LVL_ERROR == 1
 
-#define trcError(formatStr, ...) TRC_Core( \
-    trcTypeCom, __BASE_FILE__, __FUNCTION__, __LINE__, \
-    trcLvlError, formatStr, ##__VA_ARGS__ )
+#define trcError(formatStr, ...) do { \
+    if(TRC_LEVEL_IS_ENABLED(trcLvlError)) TRC_Core( \
+        trcTypeCom, TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
+        trcLvlError, formatStr, ##__VA_ARGS__ ); \
+} while(0)
 #else
 #define trcError(formatStr, ...) do{} while(0)
 #endif
@@ -143,9 +216,11 @@ extern void TRC_Core( trcType traceType,
 // -----------------------------------------------------------------------------+-
 #if TRC_ENABLE_LVL_INFO == 1
 
-#define trcInfo(formatStr, ...) TRC_Core( \
-    trcTypeCom, __BASE_FILE__, __FUNCTION__, __LINE__, \
-    trcLvlInfo, formatStr, ##__VA_ARGS__ )
+#define trcInfo(formatStr, ...) do { \
+    if(TRC_LEVEL_IS_ENABLED(trcLvlInfo)) TRC_Core( \
+        trcTypeCom, TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
+        trcLvlInfo, formatStr, ##__VA_ARGS__ ); \
+} while(0)
 #else
 #define trcInfo(formatStr, ...) do{} while(0)
 #endif
@@ -157,9 +232,11 @@ extern void TRC_Core( trcType traceType,
 // -----------------------------------------------------------------------------+-
 #if TRC_ENABLE_LVL_DEBUG == 1
 
-#define trcDebug(formatStr, ...)  TRC_Core( \
-    trcTypeCom, __BASE_FILE__, __FUNCTION__, __LINE__, \
-    trcLvlDebug, formatStr, ##__VA_ARGS__ )
+#define trcDebug(formatStr, ...) do { \
+    if(TRC_LEVEL_IS_ENABLED(trcLvlDebug)) TRC_Core( \
+        trcTypeCom, TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
+        trcLvlDebug, formatStr, ##__VA_ARGS__ ); \
+} while(0)
 #else
 #define trcDebug(formatStr, ...) do{} while(0)
 #endif
@@ -173,26 +250,132 @@ extern void TRC_Core( trcType traceType,
 // -----------------------------------------------------------------------------+-
 #if TRC_ENABLE_LVL_DEBUG == 1
 
-#define trcRaw(msgStr, ...)  TRC_Core( \
-    trcTypeRaw, __BASE_FILE__, __FUNCTION__, __LINE__, \
-    trcLvlDebug, msgStr, ##__VA_ARGS__ )
+#define trcRaw(msgStr, ...) do { \
+    if(TRC_LEVEL_IS_ENABLED(trcLvlDebug)) TRC_Core( \
+        trcTypeRaw, TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
+        trcLvlDebug, msgStr, ##__VA_ARGS__ ); \
+} while(0)
 #else
 #define trcRaw(formatStr, ...) do{} while(0)
 #endif
 
 
 // -----------------------------------------------------------------------------+-
-// trcHex
+// trcHex, trcHexDump
+//
+// Trace functions to dump the given bytes as hex values, sixteen to a line;
+// each line is one trace record, of type trcTypeHex, at debug level.
+// The digits are looked up in a table rather than formatted by printf.
+//
+// trcHexDump() takes options to prefix each line with the offset of its
+// first byte, and to follow it with the bytes as ASCII, e.g.
+//
+//     trcHexDump(frame, frame_len, TRC_HEX_OFFSET | TRC_HEX_ASCII);
+//
+//     0010: 48 65 6c 6c 6f 0d 0a                            |Hello..|
 //
-// Trace function to format the given byte string as hex values.
+// Dumps longer than TRC_HEX_MAX_LINES lines are cut short, with a last
+// line giving the number of bytes left out.
 // -----------------------------------------------------------------------------+-
+#define TRC_HEX_OFFSET (1U << 0)
+#define TRC_HEX_ASCII  (1U << 1)
+
+#ifndef TRC_HEX_BYTES_PER_LINE
+#define TRC_HEX_BYTES_PER_LINE (16U)
+#endif
+
+#ifndef TRC_HEX_MAX_LINES
+#define TRC_HEX_MAX_LINES (64U)
+#endif
+
 #if TRC_ENABLE_LVL_DEBUG == 1
 
-#define trcHex(byteStr, ...)  TRC_Core( \
-    trcTypeHex, __BASE_FILE__, __FUNCTION__, __LINE__, \
-    trcLvlDebug, byteStr, ##__VA_ARGS__ )
+#define trcHexDump(_data_, _len_, _options_) do { \
+    if(TRC_LEVEL_IS_ENABLED(trcLvlDebug)) TRC_Core_Hex( \
+        TRC_MODULE, __BASE_FILE__, __FUNCTION__, __LINE__, \
+        trcLvlDebug, (_data_), (_len_), (_options_) ); \
+} while(0)
 #else
-#define trcHex(formatStr, ...) do{} while(0)
+#define trcHexDump(_data_, _len_, _options_) do{} while(0)
+#endif
+
+#define trcHex(_data_, _len_) trcHexDump((_data_), (_len_), 0U)
+
+
+
+
+
+/*
+------------------------------------------------------------------------------------------------+-
+Software Trace Spans
+------------------------------------------------------------------------------------------------+-
+A span measures the time taken by a stretch of code; e.g. a function or an ISR:
+
+    trcSpanBegin(trcSpanUsartTdrEmpty);
+    ...
+    trcSpanEnd(trcSpanUsartTdrEmpty);
+
+Each begin and end records the DWT cycle counter, along with the span ID and edge,
+into a small binary ring; nothing is formatted and no sink is involved, so the cost
+is one counter read, one index update, and two stores per call.
+The ring is summarized by 'trc span' and dumped by 'trc span dump' for analysis
+on the host; see tools/trc-span-stats.
+
+Recording is not protected against preemption: if an interrupt records a span
+between the index update and the stores of the code it interrupted, one of the
+two events may be lost.  The summary, and the host tool, skip unpaired events.
+
+Spans are compiled out unless the application builds with TRC_ENABLE_SPANS=1,
+and adds trc-span.c; the ISRs they instrument are shared by every application.
+The DWT cycle counter is started by the trace adaptation; see TRC_Adapt_Init().
+When adding a new span ID, be sure to also add its name to the table in trc-span.c.
+------------------------------------------------------------------------------------------------+-
+*/
+typedef enum
+{
+    trcSpanUsartTdrEmpty = 0,
+    trcSpanUsartInputChar,
+    trcSpanCliCommand,
+    trcSpanNumOf,
+}   trcSpan;
+
+#ifndef TRC_ENABLE_SPANS
+#define TRC_ENABLE_SPANS 0
+#endif
+
+// Number of events held by the ring; MUST be a power of two.
+#ifndef TRC_SPAN_RING_SIZE
+#define TRC_SPAN_RING_SIZE (128U)
+#endif
+
+// The cycle counter; DWT->CYCCNT on the Cortex-M3/M4/M7;
+#ifndef TRC_SPAN_CYCLES
+#define TRC_SPAN_CYCLES() (*(volatile uint32_t *)0xE0001004UL)
 #endif
 
+#define TRC_SPAN_END_FLAG (0x80000000UL)
 
+typedef struct
+{
+    uint32_t  cycles;
+    uint32_t  tag;      // Span ID, with TRC_SPAN_END_FLAG set for an end;
+
+}   trcSpanEvent;
+
+extern trcSpanEvent TRC_Span_Ring[TRC_SPAN_RING_SIZE];
+extern uint32_t     TRC_Span_Count;
+
+#define TRC_SPAN_RECORD(_tag_) do { \
+    uint32_t _cycles_ = TRC_SPAN_CYCLES(); \
+    uint32_t _idx_    = TRC_Span_Count++ & (TRC_SPAN_RING_SIZE - 1U); \
+    TRC_Span_Ring[_idx_].cycles = _cycles_; \
+    TRC_Span_Ring[_idx_].tag    = (_tag_); \
+} while(0)
+
+#if TRC_ENABLE_SPANS == 1
+#define trcSpanBegin(_span_id_) TRC_SPAN_RECORD((uint32_t)(_span_id_))
+#define trcSpanEnd(_span_id_)   TRC_SPAN_RECORD((uint32_t)(_span_id_) | TRC_SPAN_END_FLAG)
+#else
+#define trcSpanBegin(_span_id_) do{} while(0)
+#define trcSpanEnd(_span_id_)   do{} while(0)
+#endif
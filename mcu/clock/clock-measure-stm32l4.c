@@ -0,0 +1,144 @@
+
+/*
+================================================================================================#=
+CLOCK MEASURE
+mcu/clock/clock-measure-stm32l4.c
+
+Description:
+    The STM32L4 implementation of clock-measure.h;
+    see that file for a description of this module.
+
+    See the TIM16 option register, TIM16_OR1, in the RM0351 Reference
+    Manual; TI1_RMP 10 connects the LSE to the channel 1 input.
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/clock-measure.h"
+#include "mcu/clock/clock-tree-info.h"
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+// STM32 Low Level Drivers
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_bus.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_rcc.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_tim.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+#define LSE_HZ              (32768ULL)
+
+// The input capture prescaler; one capture per this many LSE edges;
+#define EDGES_PER_CAPTURE   (8U)
+
+// The counter wraps this many times with no capture, and the LSE is deemed stopped;
+#define MAX_WRAPS           (2U)
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// Wait for the next capture, and return it; or -1 if the LSE stopped,
+// or one was missed, i.e. overcaptured.
+// ---------------------------------------------------------------------+-
+static int32_t next_capture(void)
+{
+    uint32_t wraps = 0;
+
+    while ((TIM16->SR & TIM_SR_CC1IF) == 0)
+    {
+        if (TIM16->SR & TIM_SR_UIF) {
+            TIM16->SR = ~TIM_SR_UIF;
+            if (++wraps > MAX_WRAPS) return -1;
+        }
+    }
+
+    // Reading the capture clears its flag;
+    int32_t capture = (int32_t)(TIM16->CCR1 & 0xFFFFU);
+
+    if (TIM16->SR & TIM_SR_CC1OF) return -1;
+    return capture;
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// Each capture interval must be shorter than a counter round; i.e. the
+// timer clock below 65536 * 32768 / 8 Hz, some 268MHz.
+// ---------------------------------------------------------------------+-
+bool MCU_Clock_Measure_Against_LSE(uint32_t lse_cycles, MCU_Clock_Measurement *result)
+{
+    if (!LL_RCC_LSE_IsReady()) return false;
+
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+
+    uint32_t captures = (lse_cycles + EDGES_PER_CAPTURE - 1U) / EDGES_PER_CAPTURE;
+    if (captures == 0) captures = 1;
+
+    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM16);
+
+    LL_TIM_DisableCounter(TIM16);
+    LL_TIM_SetPrescaler(TIM16, 0);
+    LL_TIM_SetAutoReload(TIM16, 0xFFFFU);
+    LL_TIM_SetRemap(TIM16, LL_TIM_TIM16_TI1_RMP_LSE);
+
+    LL_TIM_IC_SetActiveInput(TIM16, LL_TIM_CHANNEL_CH1, LL_TIM_ACTIVEINPUT_DIRECTTI);
+    LL_TIM_IC_SetPrescaler(TIM16, LL_TIM_CHANNEL_CH1, LL_TIM_ICPSC_DIV8);
+    LL_TIM_IC_SetFilter(TIM16, LL_TIM_CHANNEL_CH1, LL_TIM_IC_FILTER_FDIV1);
+    LL_TIM_IC_SetPolarity(TIM16, LL_TIM_CHANNEL_CH1, LL_TIM_IC_POLARITY_RISING);
+    LL_TIM_CC_EnableChannel(TIM16, LL_TIM_CHANNEL_CH1);
+
+    LL_TIM_GenerateEvent_UPDATE(TIM16);
+    TIM16->SR = 0;
+    LL_TIM_EnableCounter(TIM16);
+
+    // The first capture starts the measurement;
+    uint64_t counts = 0;
+    int32_t  last   = next_capture();
+    bool     ok     = (last >= 0);
+
+    for (uint32_t idx=0; ok && idx<captures; idx++)
+    {
+        int32_t capture = next_capture();
+        if (capture < 0) {
+            ok = false;
+            break;
+        }
+        counts += (uint32_t)(capture - last) & 0xFFFFU;
+        last    = capture;
+    }
+
+    LL_TIM_DisableCounter(TIM16);
+    LL_TIM_CC_DisableChannel(TIM16, LL_TIM_CHANNEL_CH1);
+    LL_APB2_GRP1_DisableClock(LL_APB2_GRP1_PERIPH_TIM16);
+
+    if (!ok) return false;
+
+    uint64_t lse_total = (uint64_t)captures * EDGES_PER_CAPTURE;
+    uint64_t measured  = ((counts * LSE_HZ) + (lse_total / 2U)) / lse_total;
+
+    result->lse_cycles   = (uint32_t)lse_total;
+    result->nominal_hz   = info.timpclk2_hz;
+    result->measured_hz  = (uint32_t)measured;
+    result->error_ppm    = (info.timpclk2_hz == 0) ? 0 :
+        (int32_t)((((int64_t)measured - (int64_t)info.timpclk2_hz) * 1000000LL) / (int64_t)info.timpclk2_hz);
+    result->msi_pll_mode = (RCC->CR & RCC_CR_MSIPLLEN) != 0;
+    return true;
+};
+
@@ -0,0 +1,59 @@
+/*
+================================================================================================#=
+CLOCK MEASURE
+mcu/clock/clock-measure.h
+
+Description:
+    Measures the actual frequency of the clock tree against the LSE, the
+    32768Hz crystal; e.g. to check the MSI, and the PLL on it, with and
+    without MSI PLL-mode (see clock-tree-default-config.h), before pushing
+    a USART to a baud rate that tolerates little error.
+
+    TIM16 counts at its timer clock, the TIMPCLK2, which shares the source,
+    and so the error, of the SYSCLK; channel 1 captures every eighth LSE
+    edge, internally, through the TI1 remap of TIM16_OR1.  The timer counts
+    between the captures add up to the timer clock over the measurement.
+    The counter is 16 bits, and the captures are polled; an interrupt that
+    holds off the polling long enough to miss a capture spoils the
+    measurement, which then fails rather than report a wrong frequency.
+
+    The resolution is one timer count over the measurement; at 80MHz,
+    over 1024 LSE cycles, i.e. some 31ms, about half a ppm.  The accuracy
+    is that of the LSE crystal, typically some 20ppm.
+
+DEPENDENCIES:
+    mcu/clock/clock-tree-info.h
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU; see clock-measure-stm32l4.c
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// A measurement;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  lse_cycles;           // The LSE cycles measured over;
+    uint32_t  nominal_hz;           // The timer clock, per the RCC registers;
+    uint32_t  measured_hz;          // The timer clock, per the LSE;
+    int32_t   error_ppm;            // Measured against nominal;
+    bool      msi_pll_mode;         // Whether the MSI is locked to the LSE;
+
+}   MCU_Clock_Measurement;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Measure the timer clock over, at least, the given LSE cycles; a busy-wait.
+// Returns false if the LSE is not running, or a capture was missed.
+// TIM16 is taken over for the duration, and turned off again.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Clock_Measure_Against_LSE(uint32_t lse_cycles, MCU_Clock_Measurement *result);
+
@@ -0,0 +1,75 @@
+
+/*
+================================================================================================#=
+Clock Profile CLI
+
+See clock-profile-cli.h for a description of this module.
+================================================================================================#=
+*/
+
+#include "mcu/clock/clock-profile-cli.h"
+#include "mcu/clock/clock-profile.h"
+
+#include "platform/cli/cli-cmd.h"
+
+
+// -----------------------------------------------------------------------------+-
+// clock
+// -----------------------------------------------------------------------------+-
+static void clock_show(void)
+{
+    MCU_Clock_Frequencies clocks = MCU_Clock_Get_Frequencies();
+    const char           *name   = MCU_Clock_Profile_Name(MCU_Clock_Get_Profile());
+
+    CLI_CMD_Printf("clock: %s; HCLK %lu Hz, PCLK1 %lu Hz, PCLK2 %lu Hz\n",
+        name ? name : "reset",
+        (unsigned long)clocks.hclk_hz,
+        (unsigned long)clocks.pclk1_hz,
+        (unsigned long)clocks.pclk2_hz
+    );
+}
+
+// -----------------------------------------------------------------------------+-
+// clock [profile]
+// -----------------------------------------------------------------------------+-
+static void clock_cmd(int argc, char *argv[])
+{
+    if (argc == 1) {
+        clock_show();
+        return;
+    }
+
+    if (argc == 2)
+    {
+        MCU_Clock_Profile profile = MCU_Clock_Profile_By_Name(argv[1]);
+
+        if (MCU_Clock_Set_Profile(profile)) {
+            clock_show();
+            return;
+        }
+    }
+
+    CLI_CMD_Printf("usage: clock [profile]; one of:");
+    for (uint32_t idx=0; idx<MCU_CLOCK_PROFILE_NumOf; idx++) {
+        CLI_CMD_Printf(" %s", MCU_Clock_Profile_Name((MCU_Clock_Profile)idx));
+    }
+    CLI_CMD_Printf("\n");
+}
+
+static const CLI_CMD_Descriptor Clock_Cmd = {
+    .name    = "clock",
+    .help    = "show or switch the clock profile",
+    .handler = clock_cmd,
+};
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void MCU_Clock_Profile_CLI_Init(void)
+{
+    CLI_CMD_Register(&Clock_Cmd);
+}
@@ -0,0 +1,19 @@
+/*
+================================================================================================#=
+Clock Profile CLI
+
+Provides the 'clock' command to show and switch the clock profile of
+clock-profile.h from the command line interface.
+
+    clock            show the profile and the bus clock frequencies in effect
+    clock <profile>  switch to the given profile: pll, msi-48, hsi-16 or lprun-2
+
+The command line itself runs on the USART; at 2MHz, its baud rate is about
+2% off 115200, which most terminals still tolerate.
+================================================================================================#=
+*/
+
+#pragma once
+
+// Register the 'clock' command with the CLI;
+void MCU_Clock_Profile_CLI_Init(void);
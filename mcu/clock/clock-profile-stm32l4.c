@@ -0,0 +1,358 @@
+
+/*
+================================================================================================#=
+CLOCK PROFILES
+mcu/clock/clock-profile-stm32l4.c
+
+Description:
+    The STM32L4 implementation of clock-profile.h;
+    see that file for a description of this module.
+
+    You must have a picture of the clock tree in front of you if you expect
+    to understand this code; see Figure 15 of the RM0351 Reference Manual.
+    The voltage ranges and the low-power run mode are described in
+    section 5.1.8, Dynamic voltage scaling management, and 5.3.2,
+    Low-power run mode (LP run).
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/clock-profile.h"
+#include "mcu/clock/clock-tree-info.h"
+#include "mcu/clock/flash-latency.h"
+#include "mcu/clock/pll-solver.h"
+
+#include <string.h>
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+// STM32 Low Level Drivers
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_bus.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_pwr.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_rcc.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_utils.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+typedef enum
+{
+    SOURCE_PLL,
+    SOURCE_MSI,
+    SOURCE_HSI,
+
+}   Sysclk_Source;
+
+// -----------------------------------------------------+-
+// The definition of each profile;
+// For the PLL, the MSI range is that of its input, if the MSI is its
+// source; otherwise, and for the HSI16, that the MSI idles at.
+// -----------------------------------------------------+-
+typedef struct
+{
+    const char                *name;
+    uint32_t                   hclk_hz;
+    Sysclk_Source              source;
+    uint32_t                   msi_range;
+    MCU_Flash_Voltage_Range    range;
+    bool                       low_power_run;
+
+}   Profile_Def;
+
+#if MCU_PLL_SOURCE == MCU_PLL_SOURCE_MSI
+#define PLL_MSI_RANGE  MCU_PLL_LL_MSIRANGE
+#else
+#define PLL_MSI_RANGE  LL_RCC_MSIRANGE_6
+#endif
+
+static const Profile_Def Profiles[MCU_CLOCK_PROFILE_NumOf] = {
+    [MCU_CLOCK_PROFILE_PLL]        = { "pll",     MCU_PLL_SYSCLK_HZ, SOURCE_PLL, PLL_MSI_RANGE, MCU_FLASH_RANGE_1, false },
+    [MCU_CLOCK_PROFILE_MSI_48MHZ]  = { "msi-48",  48000000UL,       SOURCE_MSI, LL_RCC_MSIRANGE_11, MCU_FLASH_RANGE_1, false },
+    [MCU_CLOCK_PROFILE_HSI_16MHZ]  = { "hsi-16",  16000000UL,       SOURCE_HSI, LL_RCC_MSIRANGE_6,  MCU_FLASH_RANGE_2, false },
+    [MCU_CLOCK_PROFILE_LPRUN_2MHZ] = { "lprun-2",  2000000UL,       SOURCE_MSI, LL_RCC_MSIRANGE_5,  MCU_FLASH_RANGE_2, true  },
+};
+
+// -----------------------------------------------------+-
+// The profile and the frequencies in effect;
+// None until the first switch; the clocks are then read from the
+// RCC registers, as a bootloader may have left them.
+// -----------------------------------------------------+-
+static MCU_Clock_Profile     Current_Profile = MCU_CLOCK_PROFILE_NumOf;
+static MCU_Clock_Frequencies Current_Clocks;
+
+static MCU_Clock_Subscriber  Subscribers[MCU_CLOCK_MAX_SUBSCRIBERS];
+static uint32_t              Subscriber_Count = 0;
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+static void notify(MCU_Clock_Change_Event event, const MCU_Clock_Frequencies *clocks)
+{
+    for (uint32_t idx=0; idx<Subscriber_Count; idx++) {
+        Subscribers[idx](event, clocks);
+    }
+}
+
+// ---------------------------------------------------------------------+-
+// Switch the SYSCLK to the given source, which must be ready;
+// ---------------------------------------------------------------------+-
+static void switch_sysclk(uint32_t source, uint32_t status)
+{
+    LL_RCC_SetSysClkSource(source);
+    while(LL_RCC_GetSysClkSource() != status) {};
+}
+
+// ---------------------------------------------------------------------+-
+// Set the MSI to the given range, as selected by MSIRANGE in RCC_CR;
+// The range may only change while the MSI is ready, and must not while
+// it feeds the PLL.
+// ---------------------------------------------------------------------+-
+static void set_msi_range(uint32_t msi_range)
+{
+    while(1 != LL_RCC_MSI_IsReady()) {};
+
+    LL_RCC_MSI_EnableRangeSelection();
+    if (LL_RCC_MSI_GetRange() != msi_range) {
+        LL_RCC_MSI_SetRange(msi_range);
+        while(1 != LL_RCC_MSI_IsReady()) {};
+    }
+}
+
+// ---------------------------------------------------------------------+-
+// Turn off the PLL, which must not be the SYSCLK;
+// ---------------------------------------------------------------------+-
+static void pll_off(void)
+{
+    LL_RCC_PLL_Disable();
+    while(LL_RCC_PLL_IsReady() != 0) {};
+}
+
+// ---------------------------------------------------------------------+-
+// Switch the SYSCLK to the PLL, with the dividers of pll-solver.h;
+// By default, PLLCLK = (4MHz MSI * (40/1)) / 2 = 80MHz.
+// The MSI goes to the given range, its own input range if it is the
+// PLL source.  An HSE, once started, is left running.
+// ---------------------------------------------------------------------+-
+static void sysclk_to_pll(uint32_t msi_range)
+{
+    if (LL_RCC_GetSysClkSource() == LL_RCC_SYS_CLKSOURCE_STATUS_PLL) return;
+
+    set_msi_range(msi_range);
+
+#if   MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI
+    LL_RCC_HSI_Enable();
+    while(LL_RCC_HSI_IsReady() != 1) {};
+#elif MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSE
+    LL_RCC_HSE_Enable();
+    while(LL_RCC_HSE_IsReady() != 1) {};
+#endif
+
+    LL_RCC_PLL_ConfigDomain_SYS(
+        MCU_PLL_LL_SOURCE,
+        MCU_PLL_LL_M,
+        MCU_PLL_LL_N,
+        MCU_PLL_LL_R
+    );
+#if MCU_PLL_Q_HZ != 0
+    LL_RCC_PLL_ConfigDomain_48M(MCU_PLL_LL_SOURCE, MCU_PLL_LL_M, MCU_PLL_LL_N, MCU_PLL_LL_Q);
+    LL_RCC_PLL_EnableDomain_48M();
+#endif
+#if MCU_PLL_P_HZ != 0
+    LL_RCC_PLL_ConfigDomain_SAI(MCU_PLL_LL_SOURCE, MCU_PLL_LL_M, MCU_PLL_LL_N, MCU_PLL_LL_P);
+    LL_RCC_PLL_EnableDomain_SAI();
+#endif
+    LL_RCC_PLL_Enable();
+    LL_RCC_PLL_EnableDomain_SYS();
+    while(LL_RCC_PLL_IsReady() != 1) {};
+
+    switch_sysclk(LL_RCC_SYS_CLKSOURCE_PLL, LL_RCC_SYS_CLKSOURCE_STATUS_PLL);
+}
+
+// ---------------------------------------------------------------------+-
+// Switch the SYSCLK to the MSI, at the given range;
+// From the PLL, the SYSCLK first drops to the PLL input; only then may
+// the PLL stop and the MSI range change.
+// ---------------------------------------------------------------------+-
+static void sysclk_to_msi(uint32_t msi_range)
+{
+    if (LL_RCC_GetSysClkSource() != LL_RCC_SYS_CLKSOURCE_STATUS_MSI) {
+        switch_sysclk(LL_RCC_SYS_CLKSOURCE_MSI, LL_RCC_SYS_CLKSOURCE_STATUS_MSI);
+    }
+    pll_off();
+    set_msi_range(msi_range);
+}
+
+// ---------------------------------------------------------------------+-
+// Switch the SYSCLK to the HSI16;
+// The MSI goes back to the given range, so that a later switch to the MSI
+// or the PLL never passes through a faster clock than it was left at.
+// ---------------------------------------------------------------------+-
+static void sysclk_to_hsi(uint32_t msi_range)
+{
+    LL_RCC_HSI_Enable();
+    while(LL_RCC_HSI_IsReady() != 1) {};
+
+    switch_sysclk(LL_RCC_SYS_CLKSOURCE_HSI, LL_RCC_SYS_CLKSOURCE_STATUS_HSI);
+    pll_off();
+    set_msi_range(msi_range);
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+bool MCU_Clock_Subscribe(MCU_Clock_Subscriber subscriber)
+{
+    if (subscriber == NULL || Subscriber_Count >= MCU_CLOCK_MAX_SUBSCRIBERS) return false;
+
+    Subscribers[Subscriber_Count++] = subscriber;
+    return true;
+};
+
+// ---------------------------------------------------------------------+-
+// The order of the steps matters:
+//     leave low-power run before any clock rises;
+//     raise the voltage range, then the wait states, before the HCLK rises;
+//     lower them only once it has fallen;
+//     enter low-power run only once the HCLK is at most 2MHz.
+// ---------------------------------------------------------------------+-
+bool MCU_Clock_Set_Profile(MCU_Clock_Profile profile)
+{
+    if (profile >= MCU_CLOCK_PROFILE_NumOf) return false;
+    if (profile == Current_Profile) return true;
+
+    const Profile_Def    *def     = &Profiles[profile];
+    MCU_Clock_Frequencies clocks  = { def->hclk_hz, def->hclk_hz, def->hclk_hz };
+    uint32_t              primask = __get_PRIMASK();
+
+    __disable_irq();
+    notify(MCU_CLOCK_CHANGE_BEGIN, &clocks);
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_PWR);
+
+    if (LL_PWR_IsEnabledLowPowerRunMode()) {
+        LL_PWR_ExitLowPowerRunMode();
+        while(LL_PWR_IsActiveFlag_REGLPF()) {};
+    }
+
+    if (def->range == MCU_FLASH_RANGE_1 &&
+        LL_PWR_GetRegulVoltageScaling() != LL_PWR_REGU_VOLTAGE_SCALE1)
+    {
+        LL_PWR_SetRegulVoltageScaling(LL_PWR_REGU_VOLTAGE_SCALE1);
+        while(LL_PWR_IsActiveFlag_VOS()) {};
+    }
+
+    // For the HCLK to come; the MSI at 4MHz, the most passed on the way, needs none;
+    MCU_Flash_Before_HCLK_Change(def->hclk_hz, def->range);
+
+    switch (def->source)
+    {
+        case SOURCE_PLL: sysclk_to_pll(def->msi_range); break;
+        case SOURCE_MSI: sysclk_to_msi(def->msi_range); break;
+        case SOURCE_HSI: sysclk_to_hsi(def->msi_range); break;
+    }
+
+    // Unless in use, as the SYSCLK or as the PLL input;
+    if (def->source != SOURCE_HSI &&
+        !(def->source == SOURCE_PLL && MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI))
+    {
+        LL_RCC_HSI_Disable();
+    }
+
+    if (def->range == MCU_FLASH_RANGE_2) {
+        LL_PWR_SetRegulVoltageScaling(LL_PWR_REGU_VOLTAGE_SCALE2);
+    }
+
+    if (def->low_power_run) {
+        LL_PWR_EnableLowPowerRunMode();
+        while(!LL_PWR_IsActiveFlag_REGLPF()) {};
+    }
+
+    MCU_Flash_After_HCLK_Change(def->hclk_hz, def->range);
+
+    Current_Profile = profile;
+    Current_Clocks  = clocks;
+    LL_SetSystemCoreClock(clocks.hclk_hz);
+
+    notify(MCU_CLOCK_CHANGE_END, &clocks);
+    __set_PRIMASK(primask);
+    return true;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+MCU_Clock_Profile MCU_Clock_Get_Profile(void)
+{
+    return Current_Profile;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+MCU_Clock_Frequencies MCU_Clock_Get_Frequencies(void)
+{
+    if (Current_Profile == MCU_CLOCK_PROFILE_NumOf)
+    {
+        MCU_Clock_Tree_Info info;
+        MCU_Clock_Tree_Read(&info);
+
+        MCU_Clock_Frequencies clocks = { info.hclk_hz, info.pclk1_hz, info.pclk2_hz };
+        return clocks;
+    }
+    return Current_Clocks;
+};
+
+// ---------------------------------------------------------------------+-
+// Before any switch, the MSI is the reset SYSCLK, and the wake-up clock.
+// ---------------------------------------------------------------------+-
+void MCU_Clock_Prepare_Stop(void)
+{
+    if (Current_Profile < MCU_CLOCK_PROFILE_NumOf && Profiles[Current_Profile].source == SOURCE_HSI) {
+        LL_RCC_SetClkAfterWakeFromStop(LL_RCC_STOP_WAKEUPCLOCK_HSI);
+    }
+    else {
+        LL_RCC_SetClkAfterWakeFromStop(LL_RCC_STOP_WAKEUPCLOCK_MSI);
+    }
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Clock_Resume_From_Stop(void)
+{
+    if (Current_Profile < MCU_CLOCK_PROFILE_NumOf && Profiles[Current_Profile].source == SOURCE_PLL) {
+        sysclk_to_pll(Profiles[Current_Profile].msi_range);
+    }
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+const char *MCU_Clock_Profile_Name(MCU_Clock_Profile profile)
+{
+    if (profile >= MCU_CLOCK_PROFILE_NumOf) return NULL;
+    return Profiles[profile].name;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+MCU_Clock_Profile MCU_Clock_Profile_By_Name(const char *name)
+{
+    for (uint32_t idx=0; idx<MCU_CLOCK_PROFILE_NumOf; idx++) {
+        if (strcmp(name, Profiles[idx].name) == 0) return (MCU_Clock_Profile)idx;
+    }
+    return MCU_CLOCK_PROFILE_NumOf;
+};
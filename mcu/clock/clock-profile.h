@@ -0,0 +1,155 @@
+/*
+================================================================================================#=
+CLOCK PROFILES
+mcu/clock/clock-profile.h
+
+Description:
+    Switches the clock tree between a few performance profiles at runtime,
+    so that the MCU runs at full speed only when there is work to do:
+
+        profile                         SYSCLK          voltage range   flash
+        MCU_CLOCK_PROFILE_PLL           PLL             1               4 WS at 80MHz
+        MCU_CLOCK_PROFILE_MSI_48MHZ     MSI             1               2 WS
+        MCU_CLOCK_PROFILE_HSI_16MHZ     HSI16           2               2 WS
+        MCU_CLOCK_PROFILE_LPRUN_2MHZ    MSI             2, low-power    0 WS
+                                                        run regulator
+
+    The PLL source, and the SYSCLK it makes, are those of pll-solver.h;
+    by default, the MSI at 4MHz and 80MHz.
+
+    The AHB and APB prescalers stay at 1, so HCLK, PCLK1 and PCLK2 all run
+    at the SYSCLK frequency.  Each switch puts the regulator voltage range
+    and the flash wait states in order around the clock change; i.e. it
+    raises them before the HCLK rises, and lowers them after it falls.
+    See flash-latency.h.  The PLL, and the HSI16, are off when not in use;
+    the MSI stays on, as the PLL input when not the SYSCLK; an HSE, once
+    started, stays on.
+
+    SUBSCRIBERS
+    Peripherals clocked from the HCLK or a PCLK must be re-programmed when
+    it changes; e.g. the USART baud rate register (BRR) and the SysTick
+    reload value, which is also the FreeRTOS tick.  Each subscriber is
+    called twice, with the event:
+
+        MCU_CLOCK_CHANGE_BEGIN  before the change; the clocks are those to come.
+                                E.g. wait for the USART to finish the current byte.
+        MCU_CLOCK_CHANGE_END    after the change; the clocks are those now in effect.
+                                E.g. re-program the BRR for the new PCLK.
+
+    The whole of a switch, both calls to every subscriber included, runs
+    with interrupts disabled; no interrupt handler ever sees a peripheral
+    clocked for one profile but programmed for another.  Subscribers must
+    therefore be quick and must not call FreeRTOS.  A switch to or from the
+    PLL takes the longest, as it waits for the PLL to lock.
+
+    MCU_Clock_Tree_Default_Config() selects MCU_CLOCK_PROFILE_PLL,
+    and subscribes the SysTick; see clock-tree-default-config.h.
+
+    Counts of DWT cycles, e.g. the trace timestamps, the CPU load and the
+    run time statistics, are in cycles of whatever HCLK was in effect.
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU; see clock-profile-stm32l4.c
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// The most subscribers that may be registered; freertos-l4 registers five:
+// the SysTick, the TIM2 timebase, the TPIU, the profiler's TIM6 and the USART.
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_CLOCK_MAX_SUBSCRIBERS
+#define MCU_CLOCK_MAX_SUBSCRIBERS (8U)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// The performance profiles; see above.
+// -----------------------------------------------------------------------------+-
+typedef enum
+{
+    MCU_CLOCK_PROFILE_PLL,
+    MCU_CLOCK_PROFILE_MSI_48MHZ,
+    MCU_CLOCK_PROFILE_HSI_16MHZ,
+    MCU_CLOCK_PROFILE_LPRUN_2MHZ,
+    MCU_CLOCK_PROFILE_NumOf,
+
+}   MCU_Clock_Profile;
+
+// -----------------------------------------------------------------------------+-
+// The bus clock frequencies of a profile;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  hclk_hz;
+    uint32_t  pclk1_hz;
+    uint32_t  pclk2_hz;
+
+}   MCU_Clock_Frequencies;
+
+// -----------------------------------------------------------------------------+-
+// Subscriber callback function pointer type; see above.
+// -----------------------------------------------------------------------------+-
+typedef enum
+{
+    MCU_CLOCK_CHANGE_BEGIN,
+    MCU_CLOCK_CHANGE_END,
+
+}   MCU_Clock_Change_Event;
+
+typedef void (*MCU_Clock_Subscriber)(MCU_Clock_Change_Event event, const MCU_Clock_Frequencies *clocks);
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Register the given subscriber; it is called on every switch from now on,
+// in the order registered.
+// Returns false if MCU_CLOCK_MAX_SUBSCRIBERS are already registered.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Clock_Subscribe(MCU_Clock_Subscriber subscriber);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Switch to the given profile; does nothing if it is already in effect.
+// May be called from a task or an interrupt handler.
+// Returns false, having changed nothing, if the profile is not valid.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Clock_Set_Profile(MCU_Clock_Profile profile);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the profile in effect, or MCU_CLOCK_PROFILE_NumOf if none has
+// been set since reset; i.e. the MSI at 4MHz, or whatever a bootloader left.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+MCU_Clock_Profile MCU_Clock_Get_Profile(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the bus clock frequencies now in effect;
+// Before the first switch, as read from the RCC registers; see clock-tree-info.h
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+MCU_Clock_Frequencies MCU_Clock_Get_Frequencies(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Around Stop mode; see mcu/power/tickless-idle.h
+// The MCU wakes from Stop on the HSI16 in its own profile, else on the MSI,
+// at the range it was left at; Prepare selects which, before the WFI.
+// Resume then starts the PLL again, if the profile uses it; the regulator
+// voltage range and the flash wait states are kept through Stop.
+// The frequencies are those of the profile again once it returns; the
+// subscribers are not called.  Both are to be called with interrupts masked.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Clock_Prepare_Stop(void);
+void MCU_Clock_Resume_From_Stop(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the short name of the given profile, e.g. "pll", or NULL;
+// and the profile of the given name, or MCU_CLOCK_PROFILE_NumOf.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+const char *MCU_Clock_Profile_Name(MCU_Clock_Profile profile);
+MCU_Clock_Profile MCU_Clock_Profile_By_Name(const char *name);
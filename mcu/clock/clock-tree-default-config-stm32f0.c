@@ -28,11 +28,14 @@ SPDX-License-Identifier: MIT-0
 */
 
 #include "mcu/clock/clock-tree-default-config.h"
+#include "mcu/clock/clock-tree-info.h"
+#include "mcu/clock/pll-solver.h"
 
 #include "CMSIS/Device/ST/STM32F0xx/Include/stm32f091xc.h"
 
 // STM32 Low Level Drivers
 #include "STM32F0xx_HAL_Driver/Inc/stm32f0xx_ll_rcc.h"
+#include "STM32F0xx_HAL_Driver/Inc/stm32f0xx_ll_system.h"
 #include "STM32F0xx_HAL_Driver/Inc/stm32f0xx_ll_utils.h"
 
 
@@ -41,20 +44,19 @@ SPDX-License-Identifier: MIT-0
 // =============================================================================================#=
 
 // -----------------------------------------------------+-
-// Frequency of the HCLK in Hz;
-// Set by the clock tree configuration code below;
-// TODO: REFACTOR - move to cmsis-clock?
+// Frequency of the SysTick Timer in ticks-per-second;
+// The HCLK is a compile-time constant; see mcu/clock/pll-solver.h
 // -----------------------------------------------------+-
-static uint32_t HCLK_Frequency_Hz;
+#define TICKS_PER_SECOND  (1000U)
+
+_Static_assert((MCU_CLOCK_HCLK_HZ / TICKS_PER_SECOND) - 1U <= SysTick_LOAD_RELOAD_Msk,
+    "SysTick reload out of range");
 
 // -----------------------------------------------------+-
-// Frequency of the SysTick Timer in ticks-per-second;
-// Set by the clock tree configuration code below;
-// @@@ or is it really??? @@@
-// TODO: REFACTOR
-// TODO: REFACTOR - move to cmsis-clock?
+// Flash wait states; RM0091, 3.5.1:
+// zero up to 24MHz, one above.
 // -----------------------------------------------------+-
-static uint32_t TicksPerSecond;
+#define FLASH_LATENCY  ((MCU_CLOCK_HCLK_HZ > 24000000UL) ? LL_FLASH_LATENCY_1 : LL_FLASH_LATENCY_0)
 
 
 
@@ -72,30 +74,48 @@ MCU Clock-Tree Default Config()
 ----------------------------------------------------------------+-
 CLOCK-TREE CONFIGURATION
 ----------------------------------------------------------------+-
-Upon completion, this function configures the tree like so:
-    MSI(4MHz) ==> PLL
-    PLLCLK:       ??MHz
-    SYSCLK:       ??MHz
-    HCLK:         ??MHz
-    PCLK1:        ??MHz
-    PCLK2:        ??MHz
+Upon completion, this function configures the tree like so;
+with the default PLL source and SYSCLK of mcu/clock/pll-solver.h:
+    HSI(8MHz) ==> PLL (PREDIV 1, PLLMUL 6)
+    PLLCLK:       48MHz
+    SYSCLK:       48MHz
+    HCLK:         48MHz
+    PCLK:         48MHz
+    FLASH:        1 wait state
+    SysTick:      1000 ticks per second; no exception
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 */
 void MCU_Clock_Tree_Default_Config(void)
 {
+    // ---------------------------------------------------------------------+-
+    // Start the PLL source, unless it is the HSI, which runs from reset.
+#if   MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSE
+    RCC->CR    |=  (RCC_CR_HSEON);
+    while (!(RCC->CR & RCC_CR_HSERDY)) {};
+#elif MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI48
+    RCC->CR2   |=  (RCC_CR2_HSI48ON);
+    while (!(RCC->CR2 & RCC_CR2_HSI48RDY)) {};
+#endif
+
     // ---------------------------------------------------------------------+-
     // Configure and enable the PLL as follows:
     //
-    // Configure the PLL to (HSI / 2) * 12 = 48MHz.
-    // Use a PLLMUL of 0xA for *12, and keep PLLSRC at 0
-    // to use (HSI / PREDIV) as the core source. HSI = 8MHz.
+    // PLLCLK = (source / PREDIV) * PLLMUL; by default (8MHz HSI / 1) * 6 = 48MHz.
+    // The dividers are solved for at compile time; see mcu/clock/pll-solver.h
+    RCC->CFGR2 &= ~(RCC_CFGR2_PREDIV);
+    RCC->CFGR2 |=  (MCU_PLL_CFGR2_PREDIV);
     RCC->CFGR  &= ~(RCC_CFGR_PLLMUL |
                     RCC_CFGR_PLLSRC);
-    RCC->CFGR  |=  (RCC_CFGR_PLLSRC_HSI_DIV2 |
-                    RCC_CFGR_PLLMUL12);
+    RCC->CFGR  |=  (MCU_PLL_CFGR_PLLSRC |
+                    MCU_PLL_CFGR_PLLMUL);
     // Turn the PLL on and wait for it to be ready.
     RCC->CR    |=  (RCC_CR_PLLON);
     while (!(RCC->CR & RCC_CR_PLLRDY)) {};
+    // ---------------------------------------------------------------------+-
+    // Set the flash wait states for the HCLK to come, before it rises;
+    LL_FLASH_SetLatency(FLASH_LATENCY);
+    while (LL_FLASH_GetLatency() != FLASH_LATENCY) {};
+
     // ---------------------------------------------------------------------+-
     // Set System Clock Source to PLL
     RCC->CFGR  &= ~(RCC_CFGR_SW);
@@ -105,19 +125,38 @@ void MCU_Clock_Tree_Default_Config(void)
     // ---------------------------------------------------------------------+-
     // Set the global clock frequency variable.
     // Record the freq of the HCLK to keep the CMSIS dependencies happy;
-    HCLK_Frequency_Hz = 48000000;
-    LL_SetSystemCoreClock(HCLK_Frequency_Hz);
+    LL_SetSystemCoreClock(MCU_CLOCK_HCLK_HZ);
 
-    // ?????? TODO ??????
-    // What's going on here?
+    // ---------------------------------------------------------------------+-
     // Configure the Cortex-M SysTick source for 1000 ticks per second given the HCLK frequency;
-    // Sets RELOAD register value to (HCLKFrequency / TicksPerSecond) - 1;
+    // Sets RELOAD register value to (HCLKFrequency / TicksPerSecond) - 1,
+    // which folds to a constant;
     // Clears the counter value;
     // Sets CSR:Clock source to use processor clock rather than external clock;
-    // Leaves CSR:TickInt unchanged (zero?) so assume no SysTick exception? But then why set it?
-    // Sets CSR:Enable to enable the counter
-    // TicksPerSecond = 1000U;
-    LL_InitTick(HCLK_Frequency_Hz, TicksPerSecond);
+    // Sets CSR:Enable to enable the counter, but not CSR:TickInt; there is no
+    // SysTick exception, the COUNTFLAG alone marks each tick, e.g. for LL_mDelay().
+    LL_InitTick(MCU_CLOCK_HCLK_HZ, TICKS_PER_SECOND);
+};
+
+
+// ---------------------------------------------------------------------+-
+// Read from the RCC registers, rather than assumed; see clock-tree-info.h
+// The F0 has a single APB; both return its PCLK.
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Clock_Get_PCLK1_Frequency_Hz(void)
+{
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+    return info.pclk1_hz;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Clock_Get_PCLK2_Frequency_Hz(void)
+{
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+    return info.pclk2_hz;
 };
 
 
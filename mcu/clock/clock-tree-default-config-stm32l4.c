@@ -28,10 +28,16 @@ SPDX-License-Identifier: MIT-0
 */
 
 #include "mcu/clock/clock-tree-default-config.h"
+#include "mcu/clock/clock-profile.h"
+#include "mcu/clock/clock-tree-info.h"
+#include "mcu/clock/flash-latency.h"
+#include "mcu/clock/pll-solver.h"
 
 #include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
 
 // STM32 Low Level Drivers
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_bus.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_pwr.h"
 #include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_rcc.h"
 #include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_utils.h"
 
@@ -41,27 +47,49 @@ SPDX-License-Identifier: MIT-0
 // =============================================================================================#=
 
 // -----------------------------------------------------+-
-// Frequency of the HCLK in Hz;
+// Frequency of the SysTick Timer in ticks-per-second;
 // Set by the clock tree configuration code below;
-// TODO: REFACTOR - move to cmsis-clock?
+// @@@ Perhaps move this to CMSIS-Clock?
 // -----------------------------------------------------+-
-static uint32_t HCLK_Frequency_Hz;
+static uint32_t SysTick_Frequency_Hz;
 
 // -----------------------------------------------------+-
-// Frequency of the APB1 PCLK1 in Hz;
-// Frequency of the APB2 PCLK1 in Hz;
-// Set by the clock tree configuration code below;
-// TODO: REFACTOR - move to cmsis-clock?
+// The initial SysTick rate, and its reload value at the HCLK of the
+// PLL profile; the SysTick counter is 24 bits.
 // -----------------------------------------------------+-
-static uint32_t PCLK1_Frequency_Hz;
-static uint32_t PCLK2_Frequency_Hz;
+#define SYSTICK_FREQUENCY_HZ  (1000UL)
+#define SYSTICK_RELOAD        ((uint32_t)((MCU_CLOCK_HCLK_HZ / SYSTICK_FREQUENCY_HZ) - 1UL))
+
+_Static_assert(SYSTICK_RELOAD <= SysTick_LOAD_RELOAD_Msk, "SysTick reload out of range");
 
 // -----------------------------------------------------+-
-// Frequency of the SysTick Timer in ticks-per-second;
-// Set by the clock tree configuration code below;
-// @@@ Perhaps move this to CMSIS-Clock?
+// The LSE may take up to 2 seconds to start, at the
+// lowest drive; see AN2867.
 // -----------------------------------------------------+-
-static uint32_t SysTick_Frequency_Hz;
+#define LSE_START_TIMEOUT_MS  (2500UL)
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// Clock profile subscriber: keep the SysTick at the rate it runs;
+// That rate is taken from the reload value before the change, so it
+// holds whether the SysTick was last set up here or by the RTOS,
+// e.g. for the FreeRTOS tick at configTICK_RATE_HZ.
+// ---------------------------------------------------------------------+-
+static void systick_clock_changed(MCU_Clock_Change_Event event, const MCU_Clock_Frequencies *clocks)
+{
+    if (event == MCU_CLOCK_CHANGE_BEGIN) {
+        SysTick_Frequency_Hz = SystemCoreClock / (SysTick->LOAD + 1UL);
+        return;
+    }
+
+    SysTick->LOAD = (uint32_t)((clocks->hclk_hz / SysTick_Frequency_Hz) - 1UL);
+    SysTick->VAL  = 0UL;
+}
 
 
 
@@ -113,13 +141,15 @@ MCO  - Microcontroller Clock Output
 ----------------------------------------------------------------+-
 CLOCK-TREE CONFIGURATION
 ----------------------------------------------------------------+-
-Upon completion, this function configures the tree like so:
+Upon completion, this function configures the tree like so;
+with the default PLL source and SYSCLK of mcu/clock/pll-solver.h:
     MSI(4MHz) ==> PLL
     PLLCLK:       80MHz
     SYSCLK:       80MHz
     HCLK:         80MHz
     PCLK1:        80MHz
     PCLK2:        80MHz
+    FLASH:        4 wait states; instruction and data caches on
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 */
 void MCU_Clock_Tree_Default_Config(void)
@@ -143,59 +173,29 @@ void MCU_Clock_Tree_Default_Config(void)
     while(1 != LL_RCC_MSI_IsReady()) {};
 
     // ---------------------------------------------------------------------+-
-    // Configure and enable the PLL as follows:
-    //
-    //     Input: MSI
-    //     PLLM:    1
-    //     PLLN:   40
-    //     PLLR:    2
-    //
-    // This yields: PLLCLK = (4MHz * (40/1)) / 2 = 80MHz
-    // ---------------------------------------------------------------------+-
-    uint32_t plln = 40;
-    LL_RCC_PLL_ConfigDomain_SYS(
-        LL_RCC_PLLSOURCE_MSI,
-        LL_RCC_PLLM_DIV_1,
-        plln,
-        LL_RCC_PLLR_DIV_2
-    );
-
-    // Set PLLON in RCC Clock Control register
-    LL_RCC_PLL_Enable();
-
-    // ---------------------------------------------------------------------+-
-    // Enable the PLLR output "mapped on SYSCLK domain";
-    // Set PLLREN Main PLLCLK Output Enable;
-    // And wait until PLLRDY is true in RCC Clock Control register
+    // Set the AHB, APB1 and APB2 prescalers to 1, as they are from reset;
+    // HCLK = PCLK1 = PCLK2 = SYSCLK, in every clock profile.
     // ---------------------------------------------------------------------+-
-    LL_RCC_PLL_EnableDomain_SYS();
-    while(LL_RCC_PLL_IsReady() != 1) {};
-
-    // ---------------------------------------------------------------------+-
-    // Set System Clock Source to PLL
-    // SYSCLK = PLLCLK = 80MHz
-    // Wait until System Clock Switch Status indicates PLL is the source.
-    // ---------------------------------------------------------------------+-
-    LL_RCC_SetSysClkSource(LL_RCC_SYS_CLKSOURCE_PLL);
-    while(LL_RCC_GetSysClkSource() != LL_RCC_SYS_CLKSOURCE_STATUS_PLL) {};
+    LL_RCC_SetAHBPrescaler(LL_RCC_SYSCLK_DIV_1);
+    LL_RCC_SetAPB1Prescaler(LL_RCC_APB1_DIV_1);
+    LL_RCC_SetAPB2Prescaler(LL_RCC_APB2_DIV_1);
 
     // ---------------------------------------------------------------------+-
-    // Set AHB Prescaler to 1;
-    // HCLK = SYSCLK(80MHz)/1;
-    // Record the freq of the HCLK to keep the CMSIS dependencies happy;
+    // Switch to the PLL profile; by default:
+    //
+    //     MSI(4MHz) ==> PLL (PLLM 1, PLLN 40, PLLR 2) ==> SYSCLK(80MHz)
+    //
+    // The dividers are solved for at compile time; see mcu/clock/pll-solver.h
+    // This raises the flash wait states before the switch, and records
+    // the freq of the HCLK to keep the CMSIS dependencies happy;
+    // See mcu/clock/clock-profile.h
     // ---------------------------------------------------------------------+-
-    LL_RCC_SetAHBPrescaler(LL_RCC_SYSCLK_DIV_1);
-    HCLK_Frequency_Hz = 80000000UL;
-    LL_SetSystemCoreClock(HCLK_Frequency_Hz);
+    MCU_Clock_Set_Profile(MCU_CLOCK_PROFILE_PLL);
 
     // ---------------------------------------------------------------------+-
-    // Set APB1 and APB2 prescalers to HCLK(80MHz) / 1
+    // Enable the instruction and data caches of the ART accelerator.
     // ---------------------------------------------------------------------+-
-    LL_RCC_SetAPB1Prescaler(LL_RCC_APB1_DIV_1);
-    PCLK1_Frequency_Hz = HCLK_Frequency_Hz;
-
-    LL_RCC_SetAPB2Prescaler(LL_RCC_APB2_DIV_1);
-    PCLK2_Frequency_Hz = HCLK_Frequency_Hz;
+    MCU_Flash_Set_ART(MCU_FLASH_ART_DEFAULT);
 
     // -----------------------------------------------------------------------------+-
     // Configure the Cortex-M SysTick source for 1msec tick.
@@ -207,18 +207,19 @@ void MCU_Clock_Tree_Default_Config(void)
     //     HCLK/1 (CLKSOURCE Bit = 1)
     //     HCLK/8 (CLKSOURCE Bit = 0)
     //
-    // HCLK is set for 80Mhz (see above);
+    // HCLK is set for MCU_CLOCK_HCLK_HZ, 80Mhz by default (see above);
     // We configure the SysTick counter to be
     // driven at this clock freq directly.
     //
     // We desire a 1kHz SysTick frequency:
     // Equation:    80Mhz/ReloadValue = 1kHz
     // Solving:     ReloadValue = 80Mhz/1kHz
-    // Generalize:  ReloadValue = HCLK_Frequency_Hz / SysTick_Frequency_Hz
+    // Generalize:  ReloadValue = MCU_CLOCK_HCLK_HZ / SysTick_Frequency_Hz
     // We subtract one to account for zero based counting;
+    // Both are constants, so the reload folds to one at compile time.
     // -----------------------------------------------------------------------------+-
-    SysTick_Frequency_Hz = 1000UL; // 1 tick every 1 milli-second;
-    SysTick->LOAD  = (uint32_t)((HCLK_Frequency_Hz / SysTick_Frequency_Hz) - 1UL);
+    SysTick_Frequency_Hz = SYSTICK_FREQUENCY_HZ; // 1 tick every 1 milli-second;
+    SysTick->LOAD  = SYSTICK_RELOAD;
 
     // Load the initial SysTick Counter Value;
     SysTick->VAL   = 0UL;
@@ -233,21 +234,63 @@ void MCU_Clock_Tree_Default_Config(void)
     SysTick->CTRL |= SysTick_CTRL_CLKSOURCE_Msk;
     SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
     SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    // Follow any later change of clock profile;
+    MCU_Clock_Subscribe(systick_clock_changed);
+
+#if MCU_CLOCK_MSI_PLL_MODE
+    // ---------------------------------------------------------------------+-
+    // Lock the MSI to the LSE; MSI PLL-mode.
+    // The MSI hardware then trims itself, continuously, against the LSE;
+    // and so does the PLL, which runs on the MSI.  This needs the SysTick,
+    // to time the start of the LSE; hence last.
+    // ---------------------------------------------------------------------+-
+    if (MCU_Clock_LSE_Start()) {
+        LL_RCC_MSI_EnablePLLMode();
+    }
+#endif
+};
+
+// ---------------------------------------------------------------------+-
+// The LSE is in the backup domain, whose writes must first be enabled.
+// The SysTick counts the milliseconds; see LL_mDelay().
+// ---------------------------------------------------------------------+-
+bool MCU_Clock_LSE_Start(void)
+{
+    if (LL_RCC_LSE_IsReady()) return true;
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_PWR);
+    LL_PWR_EnableBkUpAccess();
+    LL_RCC_LSE_SetDriveCapability(LL_RCC_LSEDRIVE_LOW);
+    LL_RCC_LSE_Enable();
+
+    for (uint32_t ms = 0; ms < LSE_START_TIMEOUT_MS; ms++) {
+        if (LL_RCC_LSE_IsReady()) return true;
+        LL_mDelay(1);
+    }
+
+    LL_RCC_LSE_Disable();
+    return false;
 };
 
 
 // ---------------------------------------------------------------------+-
+// Read from the RCC registers, rather than assumed; see clock-tree-info.h
 // ---------------------------------------------------------------------+-
 uint32_t MCU_Clock_Get_PCLK1_Frequency_Hz(void)
 {
-    return PCLK1_Frequency_Hz;
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+    return info.pclk1_hz;
 };
 
 // ---------------------------------------------------------------------+-
 // ---------------------------------------------------------------------+-
 uint32_t MCU_Clock_Get_PCLK2_Frequency_Hz(void)
 {
-    return PCLK2_Frequency_Hz;
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+    return info.pclk2_hz;
 };
 
 
@@ -10,14 +10,40 @@ SPDX-License-Identifier: MIT-0
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION (L4)
+// MCU_CLOCK_MSI_PLL_MODE
+//     When 1, the default configuration starts the LSE and locks the MSI to
+//     it (MSIPLLEN); the MSI, and the PLL on it, are then as accurate as the
+//     32768Hz crystal, rather than as the factory trim of the MSI, which
+//     drifts with temperature and supply.  Needed for high baud rates.
+//     Without an LSE, the MSI runs untrimmed, as before.
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_CLOCK_MSI_PLL_MODE
+#define MCU_CLOCK_MSI_PLL_MODE (0)
+#endif
+
+
 // -----------------------------------------------------------------------------+-
 // Set Clock Tree Default Configuration
+// On the L4, this selects the 80MHz clock profile, and subscribes the SysTick
+// to any later change of profile; see clock-profile.h
+// With MCU_CLOCK_MSI_PLL_MODE, it waits for the LSE to start; see below.
 // -----------------------------------------------------------------------------+-
 void MCU_Clock_Tree_Default_Config(void);
 
+// -----------------------------------------------------------------------------+-
+// Start the LSE, the 32768Hz crystal oscillator, unless it runs already (L4);
+// It may take up to 2 seconds to start.  Returns false, having turned it off
+// again, if it does not; e.g. for want of a crystal.
+// Call it after MCU_Clock_Tree_Default_Config(), whose 1ms SysTick it counts.
+// -----------------------------------------------------------------------------+-
+bool MCU_Clock_LSE_Start(void);
+
 
 // -----------------------------------------------------------------------------+-
 // Getters for key clock-tree configuration values;
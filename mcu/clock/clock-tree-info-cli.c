@@ -0,0 +1,95 @@
+
+/*
+================================================================================================#=
+Clock Tree Info CLI
+
+See clock-tree-info-cli.h for a description of this module.
+================================================================================================#=
+*/
+
+#include "mcu/clock/clock-tree-info-cli.h"
+#include "mcu/clock/clock-tree-info.h"
+#include "mcu/clock/clock-measure.h"
+#include "mcu/clock/cmsis-clock.h"
+
+#include <string.h>
+
+#include "platform/cli/cli-cmd.h"
+
+
+// The LSE cycles to measure over; some 31ms;
+#define MEASURE_LSE_CYCLES  (1024U)
+
+
+// -----------------------------------------------------------------------------+-
+// clocks measure
+// -----------------------------------------------------------------------------+-
+static void clocks_measure(void)
+{
+    MCU_Clock_Measurement m;
+
+    if (!MCU_Clock_Measure_Against_LSE(MEASURE_LSE_CYCLES, &m)) {
+        CLI_CMD_Printf("clocks: no measurement; the LSE is not running, or a capture was missed\n");
+        return;
+    }
+
+    CLI_CMD_Printf("TIMPCLK2 %10lu Hz  measured %lu Hz over %lu LSE cycles\n",
+        (unsigned long)m.nominal_hz, (unsigned long)m.measured_hz, (unsigned long)m.lse_cycles);
+    CLI_CMD_Printf("error    %+ld ppm; MSI PLL-mode %s\n",
+        (long)m.error_ppm, m.msi_pll_mode ? "on" : "off");
+}
+
+// -----------------------------------------------------------------------------+-
+// clocks [measure]
+// -----------------------------------------------------------------------------+-
+static void clocks_cmd(int argc, char *argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "measure") == 0) {
+        clocks_measure();
+        return;
+    }
+
+    if (argc != 1) {
+        CLI_CMD_Printf("usage: clocks [measure]\n");
+        return;
+    }
+
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+
+    CLI_CMD_Printf("SYSCLK   %10lu Hz  from %s; PLLCLK %lu Hz\n",
+        (unsigned long)info.sysclk_hz, info.sysclk_source, (unsigned long)info.pllclk_hz);
+    CLI_CMD_Printf("HCLK     %10lu Hz  SystemCoreClock %lu Hz\n",
+        (unsigned long)info.hclk_hz, (unsigned long)SystemCoreClock);
+    CLI_CMD_Printf("PCLK1    %10lu Hz  timers %lu Hz\n",
+        (unsigned long)info.pclk1_hz, (unsigned long)info.timpclk1_hz);
+    CLI_CMD_Printf("PCLK2    %10lu Hz  timers %lu Hz\n",
+        (unsigned long)info.pclk2_hz, (unsigned long)info.timpclk2_hz);
+
+    for (uint32_t idx=0; idx<MCU_CLOCK_KERNEL_NumOf; idx++)
+    {
+        const char *source = "";
+        uint32_t    hz     = MCU_Clock_Tree_Kernel_Hz((MCU_Clock_Kernel)idx, &source);
+
+        CLI_CMD_Printf("  %-8s %10lu Hz  from %s\n",
+            MCU_Clock_Tree_Kernel_Name((MCU_Clock_Kernel)idx), (unsigned long)hz, source);
+    }
+}
+
+static const CLI_CMD_Descriptor Clocks_Cmd = {
+    .name    = "clocks",
+    .help    = "show the clock tree, as read from the RCC registers, or measure it",
+    .handler = clocks_cmd,
+};
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void MCU_Clock_Tree_Info_CLI_Init(void)
+{
+    CLI_CMD_Register(&Clocks_Cmd);
+}
@@ -0,0 +1,21 @@
+/*
+================================================================================================#=
+Clock Tree Info CLI
+
+Provides the 'clocks' command to show the clock tree, as clock-tree-info.h
+reconstructs it from the RCC registers, from the command line interface.
+
+    clocks           show the SYSCLK source, the bus and timer clocks, and each kernel clock
+    clocks measure   measure the timer clock against the LSE, and show its error; see clock-measure.h
+
+Where the 'clock' command of clock-profile-cli.h shows what the clock profile
+module believes, this shows what the hardware is actually doing; the two
+should always agree.  The measurement shows how close the hardware is to
+what the registers say; e.g. with and without MSI PLL-mode.
+================================================================================================#=
+*/
+
+#pragma once
+
+// Register the 'clocks' command with the CLI;
+void MCU_Clock_Tree_Info_CLI_Init(void);
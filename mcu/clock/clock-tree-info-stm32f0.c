@@ -0,0 +1,179 @@
+
+/*
+================================================================================================#=
+CLOCK TREE INFO
+mcu/clock/clock-tree-info-stm32f0.c
+
+Description:
+    The STM32F0 implementation of clock-tree-info.h;
+    see that file for a description of this module.
+
+    See Figure 12 of the RM0091 Reference Manual for the clock tree of the
+    STM32F091, and section 6.4 for the RCC registers read here: RCC_CR,
+    RCC_CR2, RCC_CFGR, RCC_CFGR2, RCC_CFGR3 and RCC_BDCR.
+
+DEPENDENCIES:
+    CMSIS device headers;
+    STM32F0 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/clock-tree-info.h"
+#include "mcu/clock/cmsis-clock.h"
+#include "mcu/clock/pll-solver.h"
+
+#include <stddef.h>
+
+#include "CMSIS/Device/ST/STM32F0xx/Include/stm32f091xc.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+#ifndef MCU_CLOCK_HSE_HZ
+#if MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSE
+#define MCU_CLOCK_HSE_HZ  (MCU_PLL_SOURCE_HZ)
+#else
+#define MCU_CLOCK_HSE_HZ  (8000000UL)
+#endif
+#endif
+
+#define HSI_HZ    (8000000UL)
+#define HSI48_HZ  (48000000UL)
+#define LSE_HZ    (32768UL)
+
+static const char *const Kernel_Names[MCU_CLOCK_KERNEL_NumOf] = {
+    [MCU_CLOCK_KERNEL_USART1] = "usart1",
+    [MCU_CLOCK_KERNEL_USART2] = "usart2",
+    [MCU_CLOCK_KERNEL_USART3] = "usart3",
+    [MCU_CLOCK_KERNEL_I2C1]   = "i2c1",
+};
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// The PLL output, if ready;
+// PLLCLK = (source / PREDIV) * PLLMUL, but HSI / 2 for PLLSRC 00.
+// PLLMUL encodes 2..16 as 0..14; 15 is 16 as well.
+// ---------------------------------------------------------------------+-
+static uint32_t pll_hz(void)
+{
+    if (!(RCC->CR & RCC_CR_PLLRDY)) return 0;
+
+    uint32_t cfgr   = RCC->CFGR;
+    uint32_t prediv = ((RCC->CFGR2 & RCC_CFGR2_PREDIV) >> RCC_CFGR2_PREDIV_Pos) + 1U;
+    uint32_t mul    = ((cfgr & RCC_CFGR_PLLMUL) >> RCC_CFGR_PLLMUL_Pos) + 2U;
+    uint32_t in_hz;
+
+    if (mul > 16U) mul = 16U;
+
+    switch ((cfgr & RCC_CFGR_PLLSRC) >> RCC_CFGR_PLLSRC_Pos)
+    {
+        case 0:  in_hz = HSI_HZ / 2U;                  break;
+        case 1:  in_hz = HSI_HZ / prediv;              break;
+        case 2:  in_hz = MCU_CLOCK_HSE_HZ / prediv;    break;
+        default: in_hz = HSI48_HZ / prediv;            break;
+    }
+
+    return in_hz * mul;
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Clock_Tree_Read(MCU_Clock_Tree_Info *info)
+{
+    uint32_t cfgr = RCC->CFGR;
+    uint32_t hpre = (cfgr & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos;
+    uint32_t ppre = (cfgr & RCC_CFGR_PPRE) >> RCC_CFGR_PPRE_Pos;
+
+    info->pllclk_hz = pll_hz();
+
+    switch ((cfgr & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos)
+    {
+        case 0:  info->sysclk_source = "HSI";   info->sysclk_hz = HSI_HZ;           break;
+        case 1:  info->sysclk_source = "HSE";   info->sysclk_hz = MCU_CLOCK_HSE_HZ; break;
+        case 2:  info->sysclk_source = "PLL";   info->sysclk_hz = info->pllclk_hz;  break;
+        default: info->sysclk_source = "HSI48"; info->sysclk_hz = HSI48_HZ;         break;
+    }
+
+    info->hclk_hz     = info->sysclk_hz >> AHBPrescTable[hpre];
+    info->pclk1_hz    = info->hclk_hz   >> APBPrescTable[ppre];
+    info->pclk2_hz    = info->pclk1_hz;
+    info->timpclk1_hz = (APBPrescTable[ppre] == 0) ? info->pclk1_hz : (info->pclk1_hz * 2U);
+    info->timpclk2_hz = info->timpclk1_hz;
+};
+
+// ---------------------------------------------------------------------+-
+// The USARTxSW selections are 00 PCLK, 01 SYSCLK, 10 LSE, 11 HSI;
+// I2C1SW is 0 HSI, 1 SYSCLK.
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Clock_Tree_Kernel_Hz(MCU_Clock_Kernel kernel, const char **source)
+{
+    static const char *const Usart_Sources[4] = { "PCLK", "SYSCLK", "LSE", "HSI" };
+
+    uint32_t cfgr3 = RCC->CFGR3;
+    uint32_t sel;
+
+    MCU_Clock_Tree_Info info;
+
+    switch (kernel)
+    {
+        case MCU_CLOCK_KERNEL_USART1: sel = (cfgr3 & RCC_CFGR3_USART1SW) >> RCC_CFGR3_USART1SW_Pos; break;
+        case MCU_CLOCK_KERNEL_USART2: sel = (cfgr3 & RCC_CFGR3_USART2SW) >> RCC_CFGR3_USART2SW_Pos; break;
+        case MCU_CLOCK_KERNEL_USART3: sel = (cfgr3 & RCC_CFGR3_USART3SW) >> RCC_CFGR3_USART3SW_Pos; break;
+
+        case MCU_CLOCK_KERNEL_I2C1:
+            if (cfgr3 & RCC_CFGR3_I2C1SW) {
+                if (source != NULL) *source = "SYSCLK";
+                MCU_Clock_Tree_Read(&info);
+                return info.sysclk_hz;
+            }
+            if (source != NULL) *source = "HSI";
+            return (RCC->CR & RCC_CR_HSIRDY) ? HSI_HZ : 0;
+
+        default:
+            return 0;
+    }
+
+    if (source != NULL) *source = Usart_Sources[sel];
+
+    switch (sel)
+    {
+        case 0:  MCU_Clock_Tree_Read(&info); return info.pclk1_hz;
+        case 1:  MCU_Clock_Tree_Read(&info); return info.sysclk_hz;
+        case 2:  return (RCC->BDCR & RCC_BDCR_LSERDY) ? LSE_HZ : 0;
+        default: return (RCC->CR   & RCC_CR_HSIRDY)   ? HSI_HZ : 0;
+    }
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+const char *MCU_Clock_Tree_Kernel_Name(MCU_Clock_Kernel kernel)
+{
+    if (kernel >= MCU_CLOCK_KERNEL_NumOf) return NULL;
+    return Kernel_Names[kernel];
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Clock_Tree_Update_System_Core_Clock(void)
+{
+    MCU_Clock_Tree_Info info;
+
+    MCU_Clock_Tree_Read(&info);
+    SystemCoreClock = info.hclk_hz;
+    return info.hclk_hz;
+};
@@ -0,0 +1,303 @@
+
+/*
+================================================================================================#=
+CLOCK TREE INFO
+mcu/clock/clock-tree-info-stm32l4.c
+
+Description:
+    The STM32L4 implementation of clock-tree-info.h;
+    see that file for a description of this module.
+
+    See Figure 15 of the RM0351 Reference Manual for the clock tree, and
+    section 6.4 for the RCC registers read here: RCC_CR, RCC_CFGR,
+    RCC_PLLCFGR, RCC_PLLSAI1CFGR, RCC_PLLSAI2CFGR, RCC_CCIPR, RCC_BDCR and RCC_CSR.
+
+DEPENDENCIES:
+    CMSIS device headers;
+    STM32L4 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/clock-tree-info.h"
+#include "mcu/clock/cmsis-clock.h"
+#include "mcu/clock/pll-solver.h"
+
+#include <stddef.h>
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+#ifndef MCU_CLOCK_HSE_HZ
+#if MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSE
+#define MCU_CLOCK_HSE_HZ  (MCU_PLL_SOURCE_HZ)
+#else
+#define MCU_CLOCK_HSE_HZ  (8000000UL)
+#endif
+#endif
+
+#define HSI16_HZ  (16000000UL)
+#define LSE_HZ    (32768UL)
+#define LSI_HZ    (32000UL)
+
+// -----------------------------------------------------+-
+// The kernel clocks, and where their selection lives in RCC_CCIPR;
+// Each selection is two bits; the four sources are listed in the
+// order of its values, NULL for none.
+// -----------------------------------------------------+-
+typedef enum
+{
+    SRC_NONE,
+    SRC_SYSCLK,
+    SRC_PCLK1,
+    SRC_PCLK2,
+    SRC_HSI16,
+    SRC_MSI,
+    SRC_LSE,
+    SRC_LSI,
+    SRC_PLL_Q,
+    SRC_PLLSAI1_Q,
+    SRC_PLLSAI1_R,
+    SRC_PLLSAI2_R,
+    SRC_NumOf,
+
+}   Source;
+
+static const char *const Source_Names[SRC_NumOf] = {
+    [SRC_NONE]      = "none",
+    [SRC_SYSCLK]    = "SYSCLK",
+    [SRC_PCLK1]     = "PCLK1",
+    [SRC_PCLK2]     = "PCLK2",
+    [SRC_HSI16]     = "HSI16",
+    [SRC_MSI]       = "MSI",
+    [SRC_LSE]       = "LSE",
+    [SRC_LSI]       = "LSI",
+    [SRC_PLL_Q]     = "PLL Q",
+    [SRC_PLLSAI1_Q] = "PLLSAI1 Q",
+    [SRC_PLLSAI1_R] = "PLLSAI1 R",
+    [SRC_PLLSAI2_R] = "PLLSAI2 R",
+};
+
+typedef struct
+{
+    const char *name;
+    uint32_t    sel_pos;
+    Source      sel[4];
+
+}   Kernel_Def;
+
+static const Kernel_Def Kernels[MCU_CLOCK_KERNEL_NumOf] = {
+    [MCU_CLOCK_KERNEL_USART1]  = { "usart1",  RCC_CCIPR_USART1SEL_Pos,  { SRC_PCLK2, SRC_SYSCLK,    SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_USART2]  = { "usart2",  RCC_CCIPR_USART2SEL_Pos,  { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_USART3]  = { "usart3",  RCC_CCIPR_USART3SEL_Pos,  { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_UART4]   = { "uart4",   RCC_CCIPR_UART4SEL_Pos,   { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_UART5]   = { "uart5",   RCC_CCIPR_UART5SEL_Pos,   { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_LPUART1] = { "lpuart1", RCC_CCIPR_LPUART1SEL_Pos, { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_I2C1]    = { "i2c1",    RCC_CCIPR_I2C1SEL_Pos,    { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_NONE   } },
+    [MCU_CLOCK_KERNEL_I2C2]    = { "i2c2",    RCC_CCIPR_I2C2SEL_Pos,    { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_NONE   } },
+    [MCU_CLOCK_KERNEL_I2C3]    = { "i2c3",    RCC_CCIPR_I2C3SEL_Pos,    { SRC_PCLK1, SRC_SYSCLK,    SRC_HSI16,     SRC_NONE   } },
+    [MCU_CLOCK_KERNEL_LPTIM1]  = { "lptim1",  RCC_CCIPR_LPTIM1SEL_Pos,  { SRC_PCLK1, SRC_LSI,       SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_LPTIM2]  = { "lptim2",  RCC_CCIPR_LPTIM2SEL_Pos,  { SRC_PCLK1, SRC_LSI,       SRC_HSI16,     SRC_LSE    } },
+    [MCU_CLOCK_KERNEL_CLK48]   = { "clk48",   RCC_CCIPR_CLK48SEL_Pos,   { SRC_NONE,  SRC_PLLSAI1_Q, SRC_PLL_Q,     SRC_MSI    } },
+    [MCU_CLOCK_KERNEL_ADC]     = { "adc",     RCC_CCIPR_ADCSEL_Pos,     { SRC_NONE,  SRC_PLLSAI1_R, SRC_PLLSAI2_R, SRC_SYSCLK } },
+};
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// The MSI frequency;
+// From MSIRANGE in RCC_CR once MSIRGSEL is set, else from MSISRANGE in
+// RCC_CSR, as after reset or Standby; both index the same table.
+// ---------------------------------------------------------------------+-
+static uint32_t msi_hz(void)
+{
+    if (!(RCC->CR & RCC_CR_MSIRDY)) return 0;
+
+    uint32_t range = (RCC->CR & RCC_CR_MSIRGSEL)
+        ? ((RCC->CR  & RCC_CR_MSIRANGE)   >> RCC_CR_MSIRANGE_Pos)
+        : ((RCC->CSR & RCC_CSR_MSISRANGE) >> RCC_CSR_MSISRANGE_Pos);
+
+    return (range < 12U) ? MSIRangeTable[range] : 0;
+}
+
+// ---------------------------------------------------------------------+-
+// The input to all three PLLs, as selected by PLLSRC in RCC_PLLCFGR;
+// the PLLM divider is shared, too, on the STM32L476.
+// ---------------------------------------------------------------------+-
+static uint32_t pll_input_hz(void)
+{
+    uint32_t src_hz;
+
+    switch ((RCC->PLLCFGR & RCC_PLLCFGR_PLLSRC) >> RCC_PLLCFGR_PLLSRC_Pos)
+    {
+        case 1:  src_hz = msi_hz(); break;
+        case 2:  src_hz = (RCC->CR & RCC_CR_HSIRDY) ? HSI16_HZ : 0; break;
+        case 3:  src_hz = (RCC->CR & RCC_CR_HSERDY) ? MCU_CLOCK_HSE_HZ : 0; break;
+        default: src_hz = 0; break;
+    }
+
+    return src_hz / (((RCC->PLLCFGR & RCC_PLLCFGR_PLLM) >> RCC_PLLCFGR_PLLM_Pos) + 1U);
+}
+
+// ---------------------------------------------------------------------+-
+// A PLL output: the VCO of the given N, over the given divider;
+// zero unless both the PLL is ready and the output is enabled.
+// ---------------------------------------------------------------------+-
+static uint32_t pll_output_hz(uint32_t ready, uint32_t enabled, uint32_t n, uint32_t div)
+{
+    if (!ready || !enabled || div == 0) return 0;
+    return (uint32_t)(((uint64_t)pll_input_hz() * n) / div);
+}
+
+// PLLR and PLLQ, and their PLLSAI kin, encode 2, 4, 6 or 8 as 0..3;
+#define DIV_2468(_reg_, _pos_, _msk_)  (((((_reg_) & (_msk_)) >> (_pos_)) + 1U) * 2U)
+
+static uint32_t pll_r_hz(void)
+{
+    return pll_output_hz(
+        RCC->CR & RCC_CR_PLLRDY,
+        RCC->PLLCFGR & RCC_PLLCFGR_PLLREN,
+        (RCC->PLLCFGR & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos,
+        DIV_2468(RCC->PLLCFGR, RCC_PLLCFGR_PLLR_Pos, RCC_PLLCFGR_PLLR)
+    );
+}
+
+static uint32_t pll_q_hz(void)
+{
+    return pll_output_hz(
+        RCC->CR & RCC_CR_PLLRDY,
+        RCC->PLLCFGR & RCC_PLLCFGR_PLLQEN,
+        (RCC->PLLCFGR & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos,
+        DIV_2468(RCC->PLLCFGR, RCC_PLLCFGR_PLLQ_Pos, RCC_PLLCFGR_PLLQ)
+    );
+}
+
+static uint32_t pllsai1_q_hz(void)
+{
+    return pll_output_hz(
+        RCC->CR & RCC_CR_PLLSAI1RDY,
+        RCC->PLLSAI1CFGR & RCC_PLLSAI1CFGR_PLLSAI1QEN,
+        (RCC->PLLSAI1CFGR & RCC_PLLSAI1CFGR_PLLSAI1N) >> RCC_PLLSAI1CFGR_PLLSAI1N_Pos,
+        DIV_2468(RCC->PLLSAI1CFGR, RCC_PLLSAI1CFGR_PLLSAI1Q_Pos, RCC_PLLSAI1CFGR_PLLSAI1Q)
+    );
+}
+
+static uint32_t pllsai1_r_hz(void)
+{
+    return pll_output_hz(
+        RCC->CR & RCC_CR_PLLSAI1RDY,
+        RCC->PLLSAI1CFGR & RCC_PLLSAI1CFGR_PLLSAI1REN,
+        (RCC->PLLSAI1CFGR & RCC_PLLSAI1CFGR_PLLSAI1N) >> RCC_PLLSAI1CFGR_PLLSAI1N_Pos,
+        DIV_2468(RCC->PLLSAI1CFGR, RCC_PLLSAI1CFGR_PLLSAI1R_Pos, RCC_PLLSAI1CFGR_PLLSAI1R)
+    );
+}
+
+static uint32_t pllsai2_r_hz(void)
+{
+    return pll_output_hz(
+        RCC->CR & RCC_CR_PLLSAI2RDY,
+        RCC->PLLSAI2CFGR & RCC_PLLSAI2CFGR_PLLSAI2REN,
+        (RCC->PLLSAI2CFGR & RCC_PLLSAI2CFGR_PLLSAI2N) >> RCC_PLLSAI2CFGR_PLLSAI2N_Pos,
+        DIV_2468(RCC->PLLSAI2CFGR, RCC_PLLSAI2CFGR_PLLSAI2R_Pos, RCC_PLLSAI2CFGR_PLLSAI2R)
+    );
+}
+
+// ---------------------------------------------------------------------+-
+// The timer clock of an APB; twice the PCLK unless the prescaler is 1.
+// ---------------------------------------------------------------------+-
+static uint32_t timpclk_hz(uint32_t pclk_hz, uint32_t ppre)
+{
+    return (APBPrescTable[ppre] == 0) ? pclk_hz : (pclk_hz * 2U);
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Clock_Tree_Read(MCU_Clock_Tree_Info *info)
+{
+    uint32_t cfgr  = RCC->CFGR;
+    uint32_t hpre  = (cfgr & RCC_CFGR_HPRE)  >> RCC_CFGR_HPRE_Pos;
+    uint32_t ppre1 = (cfgr & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    uint32_t ppre2 = (cfgr & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos;
+
+    info->pllclk_hz = pll_r_hz();
+
+    switch ((cfgr & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos)
+    {
+        case 0:  info->sysclk_source = "MSI";   info->sysclk_hz = msi_hz();         break;
+        case 1:  info->sysclk_source = "HSI16"; info->sysclk_hz = HSI16_HZ;         break;
+        case 2:  info->sysclk_source = "HSE";   info->sysclk_hz = MCU_CLOCK_HSE_HZ; break;
+        default: info->sysclk_source = "PLL";   info->sysclk_hz = info->pllclk_hz;  break;
+    }
+
+    info->hclk_hz     = info->sysclk_hz >> AHBPrescTable[hpre];
+    info->pclk1_hz    = info->hclk_hz   >> APBPrescTable[ppre1];
+    info->pclk2_hz    = info->hclk_hz   >> APBPrescTable[ppre2];
+    info->timpclk1_hz = timpclk_hz(info->pclk1_hz, ppre1);
+    info->timpclk2_hz = timpclk_hz(info->pclk2_hz, ppre2);
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Clock_Tree_Kernel_Hz(MCU_Clock_Kernel kernel, const char **source)
+{
+    if (kernel >= MCU_CLOCK_KERNEL_NumOf) return 0;
+
+    const Kernel_Def *def = &Kernels[kernel];
+    Source            src = def->sel[(RCC->CCIPR >> def->sel_pos) & 3U];
+    uint32_t          hz;
+
+    MCU_Clock_Tree_Info info;
+
+    switch (src)
+    {
+        case SRC_SYSCLK:    MCU_Clock_Tree_Read(&info); hz = info.sysclk_hz; break;
+        case SRC_PCLK1:     MCU_Clock_Tree_Read(&info); hz = info.pclk1_hz;  break;
+        case SRC_PCLK2:     MCU_Clock_Tree_Read(&info); hz = info.pclk2_hz;  break;
+        case SRC_HSI16:     hz = (RCC->CR   & RCC_CR_HSIRDY)   ? HSI16_HZ : 0; break;
+        case SRC_MSI:       hz = msi_hz(); break;
+        case SRC_LSE:       hz = (RCC->BDCR & RCC_BDCR_LSERDY) ? LSE_HZ   : 0; break;
+        case SRC_LSI:       hz = (RCC->CSR  & RCC_CSR_LSIRDY)  ? LSI_HZ   : 0; break;
+        case SRC_PLL_Q:     hz = pll_q_hz();     break;
+        case SRC_PLLSAI1_Q: hz = pllsai1_q_hz(); break;
+        case SRC_PLLSAI1_R: hz = pllsai1_r_hz(); break;
+        case SRC_PLLSAI2_R: hz = pllsai2_r_hz(); break;
+        default:            hz = 0; break;
+    }
+
+    if (source != NULL) *source = Source_Names[src];
+    return hz;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+const char *MCU_Clock_Tree_Kernel_Name(MCU_Clock_Kernel kernel)
+{
+    if (kernel >= MCU_CLOCK_KERNEL_NumOf) return NULL;
+    return Kernels[kernel].name;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Clock_Tree_Update_System_Core_Clock(void)
+{
+    MCU_Clock_Tree_Info info;
+
+    MCU_Clock_Tree_Read(&info);
+    SystemCoreClock = info.hclk_hz;
+    return info.hclk_hz;
+};
@@ -0,0 +1,118 @@
+/*
+================================================================================================#=
+CLOCK TREE INFO
+mcu/clock/clock-tree-info.h
+
+Description:
+    Reconstructs the frequencies of the clock tree from the RCC registers,
+    after the manner of the CMSIS SystemCoreClockUpdate(); i.e. from the
+    state of the hardware, rather than from what the configuration code
+    last recorded.  It therefore holds after a change of clock made
+    elsewhere, e.g. by a bootloader that handed over with the PLL running.
+
+    The oscillator frequencies are those of the reference manual, except
+    the HSE, which depends on the board; see MCU_CLOCK_HSE_HZ below.
+    An oscillator that is not ready, or a PLL output that is not enabled,
+    counts as zero Hz.
+
+    KERNEL CLOCKS
+    Some peripherals may run from a clock other than their bus clock,
+    as selected in RCC_CCIPR on the L4 and RCC_CFGR3 on the F0; e.g. a USART
+    from the HSI16 so that its baud rate holds across a change of SYSCLK.
+    MCU_Clock_Tree_Kernel_Hz() returns the frequency of such a clock.
+
+    The STM32F0 has a single APB; its PCLK is reported as both PCLK1 and PCLK2.
+
+    A timer on an APB runs at the PCLK if the APB prescaler is 1, and at
+    twice the PCLK otherwise; these are the TIMPCLK frequencies below.
+
+DEPENDENCIES:
+    CMSIS device headers;
+    STM32L4 or STM32F0 MCU; see clock-tree-info-stm32l4.c and clock-tree-info-stm32f0.c
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// MCU_CLOCK_HSE_HZ
+//     The HSE frequency; there is no way to read it from the hardware.
+//     Defaults to MCU_PLL_SOURCE_HZ if the HSE is the PLL source of
+//     pll-solver.h, else to 8MHz, the MCO of the ST-LINK on the Nucleo boards.
+// -----------------------------------------------------------------------------+-
+
+
+// -----------------------------------------------------------------------------+-
+// The frequencies of the clock tree;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    const char *sysclk_source;      // e.g. "PLL", "MSI", "HSI16"
+    uint32_t    sysclk_hz;
+    uint32_t    pllclk_hz;          // The PLL output to the SYSCLK; zero if off.
+    uint32_t    hclk_hz;
+    uint32_t    pclk1_hz;
+    uint32_t    pclk2_hz;
+    uint32_t    timpclk1_hz;
+    uint32_t    timpclk2_hz;
+
+}   MCU_Clock_Tree_Info;
+
+// -----------------------------------------------------------------------------+-
+// Peripherals with a kernel clock selection; see above.
+// -----------------------------------------------------------------------------+-
+typedef enum
+{
+#if defined(MCUFAM_STM32L4)
+    MCU_CLOCK_KERNEL_USART1,
+    MCU_CLOCK_KERNEL_USART2,
+    MCU_CLOCK_KERNEL_USART3,
+    MCU_CLOCK_KERNEL_UART4,
+    MCU_CLOCK_KERNEL_UART5,
+    MCU_CLOCK_KERNEL_LPUART1,
+    MCU_CLOCK_KERNEL_I2C1,
+    MCU_CLOCK_KERNEL_I2C2,
+    MCU_CLOCK_KERNEL_I2C3,
+    MCU_CLOCK_KERNEL_LPTIM1,
+    MCU_CLOCK_KERNEL_LPTIM2,
+    MCU_CLOCK_KERNEL_CLK48,         // USB OTG FS, RNG and SDMMC;
+    MCU_CLOCK_KERNEL_ADC,
+#elif defined(MCUFAM_STM32F0)
+    MCU_CLOCK_KERNEL_USART1,
+    MCU_CLOCK_KERNEL_USART2,
+    MCU_CLOCK_KERNEL_USART3,
+    MCU_CLOCK_KERNEL_I2C1,
+#endif
+    MCU_CLOCK_KERNEL_NumOf,
+
+}   MCU_Clock_Kernel;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Fill in the given info from the RCC registers;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Clock_Tree_Read(MCU_Clock_Tree_Info *info);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the frequency of the given kernel clock, from the RCC registers;
+// zero if its source is off or the kernel is not valid.
+// If source is not NULL, it is set to the name of the source, e.g. "PCLK1".
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+uint32_t MCU_Clock_Tree_Kernel_Hz(MCU_Clock_Kernel kernel, const char **source);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the short name of the given kernel clock, e.g. "usart2", or NULL;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+const char *MCU_Clock_Tree_Kernel_Name(MCU_Clock_Kernel kernel);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Set the CMSIS SystemCoreClock variable to the HCLK, from the RCC registers;
+// The equivalent of the CMSIS SystemCoreClockUpdate().  Returns the HCLK.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+uint32_t MCU_Clock_Tree_Update_System_Core_Clock(void);
@@ -127,6 +127,25 @@ const uint8_t  AHBPrescTable[16] = {
 };
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// GLOBAL: APBPrescTable[]
+//
+// The same idea, for the PPRE fields in the RCC CFGR register;
+// i.e. the PPRE (F0), or the PPRE1 and PPRE2 (L4), of the APB prescalers:
+//         0xx: HCLK not divided
+//         100: HCLK divided by 2
+//         101: HCLK divided by 4
+//         110: HCLK divided by 8
+//         111: HCLK divided by 16
+//
+// Used by __LL_RCC_CALC_PCLK1_FREQ() and friends, and by clock-tree-info.h
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+const uint8_t  APBPrescTable[8] = {
+    0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U
+};
+
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 // Use the given value to set the SystemCoreClock variable.
 //
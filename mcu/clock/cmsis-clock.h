@@ -28,6 +28,9 @@ extern const uint32_t MSIRangeTable[];
 extern const uint8_t  AHBPrescTable[];
 
 
+extern const uint8_t  APBPrescTable[];
+
+
 // =============================================================================================#=
 // Public API Services
 // =============================================================================================#=
@@ -0,0 +1,468 @@
+
+/*
+================================================================================================#=
+Flash Latency CLI
+
+See flash-cli.h for a description of this module.
+================================================================================================#=
+*/
+
+#include "mcu/clock/flash-cli.h"
+#include "mcu/clock/flash-latency.h"
+
+#include <string.h>
+
+#include "platform/cli/cli-cmd.h"
+#include "stm32l4xx.h"
+
+
+// -----------------------------------------------------------------------------+-
+// Benchmark sizes; the passes are timed after one untimed pass to warm up.
+// -----------------------------------------------------------------------------+-
+#define BENCH_PASSES    (20U)
+#define LIST_NODES      (32U)
+#define MATRIX_N        (8U)
+
+enum { KERNEL_LIST, KERNEL_MATRIX, KERNEL_STATE, KERNEL_CRC, KERNEL_COUNT };
+
+// -----------------------------------------------------------------------------+-
+// The results, one row per combination of ART options; shown a page at a
+// time, as all of them do not fit in the CLI response buffer.
+// -----------------------------------------------------------------------------+-
+#ifndef FLASH_CLI_PAGE_ROWS
+#define FLASH_CLI_PAGE_ROWS (4U)
+#endif
+
+#define BENCH_ROWS (MCU_FLASH_ART_ALL + 1U)
+
+typedef struct
+{
+    uint32_t  cycles[KERNEL_COUNT];
+    uint32_t  total;
+    uint16_t  check;
+
+}   Bench_Row;
+
+static Bench_Row  Bench_Rows[BENCH_ROWS];
+static uint32_t   Bench_Wait_States;
+static uint32_t   Bench_Next_Row = BENCH_ROWS;
+
+// -----------------------------------------------------------------------------+-
+// The list lives in RAM; its nodes are linked out of order.
+// -----------------------------------------------------------------------------+-
+typedef struct List_Node
+{
+    struct List_Node  *next;
+    int16_t            value;
+
+}   List_Node;
+
+static List_Node  Nodes[LIST_NODES];
+static List_Node *List_Head;
+
+// -----------------------------------------------------------------------------+-
+// The constant operand of the matrix multiply, and the input of the
+// state machine, are read from flash; i.e. through the data cache.
+// -----------------------------------------------------------------------------+-
+static const int16_t Matrix_A[MATRIX_N][MATRIX_N] = {
+    {  -17,  -61,    2,   67,  -87,  -81,   38,  -75 },
+    {   -6,   50,  -85,   30,  -45,  -90,  -77,   12 },
+    {    8,  -82,  -38,  -76,   42,    9,  -84,   45 },
+    {  -68,  -42,   62,   61,   50,  -84,   48,   50 },
+    {    2,  -87,  -43,  -88,   43,  -65,  -25,    8 },
+    {  -63,   39,  -69,   47,  -21,   44,   75,  -53 },
+    {  -73,   49,   47,   64,  -51,   -4,  -75,   41 },
+    {   83,  -83,   45,  -84,   59,  -47,   28,   75 },
+};
+
+static int32_t Matrix_B[MATRIX_N][MATRIX_N];
+static int32_t Matrix_C[MATRIX_N][MATRIX_N];
+
+static const char State_Input[] =
+    "5012,1.23e-4,-874,+122,7.4,0x1f,3e9,-.5,88x,6.02E+23,0,-1,"
+    "+.25,1e,42,.,999999,-3.1415,2.5e+10,abc,17,-0.0,1.e-9,65535,";
+
+typedef enum
+{
+    STATE_START,
+    STATE_INVALID,
+    STATE_SIGN,
+    STATE_INT,
+    STATE_FLOAT,
+    STATE_EXP_MARK,
+    STATE_EXP_SIGN,
+    STATE_SCIENTIFIC,
+    STATE_COUNT,
+
+}   Scan_State;
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// Link the list nodes in a stride order, 13 being prime to LIST_NODES,
+// and fill the matrix operand in RAM.
+// -----------------------------------------------------------------------------+-
+static void bench_init(void)
+{
+    List_Head = NULL;
+    for (uint32_t idx=LIST_NODES; idx>0; idx--)
+    {
+        List_Node *node = &Nodes[((idx - 1U) * 13U) % LIST_NODES];
+
+        node->value = (int16_t)(((idx * 2654435761U) >> 20) & 0x7FFU) - 1024;
+        node->next  = List_Head;
+        List_Head   = node;
+    }
+
+    for (uint32_t row=0; row<MATRIX_N; row++) {
+        for (uint32_t col=0; col<MATRIX_N; col++) {
+            Matrix_B[row][col] = (int32_t)(row * MATRIX_N + col) - 31;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// Sum the list and find its largest value; then reverse it twice, so that
+// it is left as it was found.
+// -----------------------------------------------------------------------------+-
+static uint32_t list_kernel(void)
+{
+    uint32_t sum = 0;
+    int16_t  max = INT16_MIN;
+
+    for (List_Node *node=List_Head; node != NULL; node=node->next)
+    {
+        sum += (uint32_t)node->value;
+        if (node->value > max) max = node->value;
+    }
+
+    for (uint32_t times=0; times<2; times++)
+    {
+        List_Node *prev = NULL;
+        List_Node *node = List_Head;
+
+        while (node != NULL) {
+            List_Node *next = node->next;
+            node->next = prev;
+            prev       = node;
+            node       = next;
+        }
+        List_Head = prev;
+    }
+    return sum ^ (uint16_t)max;
+}
+
+// -----------------------------------------------------------------------------+-
+// C = A x B; returns the sum of C.
+// -----------------------------------------------------------------------------+-
+static uint32_t matrix_kernel(void)
+{
+    uint32_t sum = 0;
+
+    for (uint32_t row=0; row<MATRIX_N; row++) {
+        for (uint32_t col=0; col<MATRIX_N; col++)
+        {
+            int32_t acc = 0;
+            for (uint32_t idx=0; idx<MATRIX_N; idx++) {
+                acc += Matrix_A[row][idx] * Matrix_B[idx][col];
+            }
+            Matrix_C[row][col] = acc;
+            sum += (uint32_t)acc;
+        }
+    }
+    return sum;
+}
+
+// -----------------------------------------------------------------------------+-
+// Classify each comma separated token of the input as an integer, a float,
+// a number in scientific notation, or invalid; returns the tally.
+// -----------------------------------------------------------------------------+-
+static uint32_t state_kernel(void)
+{
+    uint32_t   counts[STATE_COUNT] = {0};
+    Scan_State state = STATE_START;
+
+    for (const char *next=State_Input; *next != '\0'; next++)
+    {
+        char c        = *next;
+        bool is_digit = (c >= '0' && c <= '9');
+
+        if (c == ',') {
+            counts[state]++;
+            state = STATE_START;
+            continue;
+        }
+
+        switch (state)
+        {
+            case STATE_START:
+                if      (is_digit)              state = STATE_INT;
+                else if (c == '+' || c == '-')  state = STATE_SIGN;
+                else if (c == '.')              state = STATE_FLOAT;
+                else                            state = STATE_INVALID;
+                break;
+
+            case STATE_SIGN:
+                if      (is_digit)              state = STATE_INT;
+                else if (c == '.')              state = STATE_FLOAT;
+                else                            state = STATE_INVALID;
+                break;
+
+            case STATE_INT:
+                if      (is_digit)              state = STATE_INT;
+                else if (c == '.')              state = STATE_FLOAT;
+                else if (c == 'e' || c == 'E')  state = STATE_EXP_MARK;
+                else                            state = STATE_INVALID;
+                break;
+
+            case STATE_FLOAT:
+                if      (is_digit)              state = STATE_FLOAT;
+                else if (c == 'e' || c == 'E')  state = STATE_EXP_MARK;
+                else                            state = STATE_INVALID;
+                break;
+
+            case STATE_EXP_MARK:
+                if      (is_digit)              state = STATE_SCIENTIFIC;
+                else if (c == '+' || c == '-')  state = STATE_EXP_SIGN;
+                else                            state = STATE_INVALID;
+                break;
+
+            case STATE_EXP_SIGN:
+            case STATE_SCIENTIFIC:
+                if      (is_digit)              state = STATE_SCIENTIFIC;
+                else                            state = STATE_INVALID;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    uint32_t tally = 0;
+    for (uint32_t idx=0; idx<STATE_COUNT; idx++) {
+        tally = tally * 31U + counts[idx];
+    }
+    return tally;
+}
+
+// -----------------------------------------------------------------------------+-
+// CRC16-CCITT, bit by bit, of the given value onto the given CRC;
+// -----------------------------------------------------------------------------+-
+static uint16_t crc_kernel(uint16_t crc, uint32_t value)
+{
+    for (uint32_t bit=0; bit<32; bit++)
+    {
+        bool top = ((crc >> 15) ^ (value >> 31)) & 1U;
+
+        crc     = (uint16_t)(crc << 1);
+        value <<= 1;
+        if (top) crc ^= 0x1021U;
+    }
+    return crc;
+}
+
+// -----------------------------------------------------------------------------+-
+// Add the cycles since the given start to the given total;
+// Returns the cycle count now, the start of the next lap.
+// -----------------------------------------------------------------------------+-
+static uint32_t lap(uint32_t *total, uint32_t start)
+{
+    uint32_t now = DWT->CYCCNT;
+
+    *total += now - start;
+    return now;
+}
+
+// -----------------------------------------------------------------------------+-
+// Run all the kernels for the given number of passes; adds the cycles
+// of each to the given totals.  Returns the CRC of all their results.
+// -----------------------------------------------------------------------------+-
+static uint16_t run_kernels(uint32_t passes, uint32_t cycles[KERNEL_COUNT])
+{
+    uint16_t crc = 0xFFFFU;
+
+    for (uint32_t pass=0; pass<passes; pass++)
+    {
+        uint32_t start = DWT->CYCCNT;
+
+        uint32_t list_result   = list_kernel();
+        start = lap(&cycles[KERNEL_LIST], start);
+
+        uint32_t matrix_result = matrix_kernel();
+        start = lap(&cycles[KERNEL_MATRIX], start);
+
+        uint32_t state_result  = state_kernel();
+        start = lap(&cycles[KERNEL_STATE], start);
+
+        crc = crc_kernel(crc, list_result);
+        crc = crc_kernel(crc, matrix_result);
+        crc = crc_kernel(crc, state_result);
+        lap(&cycles[KERNEL_CRC], start);
+    }
+    return crc;
+}
+
+// -----------------------------------------------------------------------------+-
+// flash more
+// Show the next page of the results; the footer follows the last row.
+// -----------------------------------------------------------------------------+-
+static void flash_more(void)
+{
+    uint32_t shown = 0;
+
+    if (Bench_Next_Row >= BENCH_ROWS) {
+        CLI_CMD_Printf("flash: nothing more; run 'flash bench' first\n");
+        return;
+    }
+
+    while (shown < FLASH_CLI_PAGE_ROWS && Bench_Next_Row < BENCH_ROWS)
+    {
+        uint32_t         options = Bench_Next_Row;
+        const Bench_Row *row     = &Bench_Rows[options];
+        uint32_t         all_off = Bench_Rows[0].total;
+
+        CLI_CMD_Printf("  %-3s %-3s %-3s %8lu %8lu %8lu %8lu %9lu %5lu%%  0x%04x\n",
+            (options & MCU_FLASH_ART_ICACHE)   ? "on" : "-",
+            (options & MCU_FLASH_ART_DCACHE)   ? "on" : "-",
+            (options & MCU_FLASH_ART_PREFETCH) ? "on" : "-",
+            (unsigned long)row->cycles[KERNEL_LIST],
+            (unsigned long)row->cycles[KERNEL_MATRIX],
+            (unsigned long)row->cycles[KERNEL_STATE],
+            (unsigned long)row->cycles[KERNEL_CRC],
+            (unsigned long)row->total,
+            (unsigned long)(all_off ? (uint64_t)row->total * 100U / all_off : 0U),
+            (unsigned)row->check
+        );
+        Bench_Next_Row++;
+        shown++;
+    }
+
+    if (Bench_Next_Row < BENCH_ROWS) {
+        CLI_CMD_Printf("  -- row %lu of %u; 'flash more' to continue --\n",
+            (unsigned long)Bench_Next_Row, BENCH_ROWS);
+        return;
+    }
+    CLI_CMD_Printf("  (cycles for %u passes; %lu wait states)\n",
+        BENCH_PASSES, (unsigned long)Bench_Wait_States);
+}
+
+// -----------------------------------------------------------------------------+-
+// flash bench
+// Every combination of the ART options, from all off to all on; each starts
+// with empty caches.  All are run before the first page is shown.
+// -----------------------------------------------------------------------------+-
+static void flash_bench(void)
+{
+    uint32_t saved = MCU_Flash_Get_ART();
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    bench_init();
+
+    for (uint32_t options=0; options<BENCH_ROWS; options++)
+    {
+        Bench_Row *row = &Bench_Rows[options];
+        uint32_t   warm_up[KERNEL_COUNT] = {0};
+
+        memset(row, 0, sizeof(*row));
+
+        MCU_Flash_Set_ART(0);
+        MCU_Flash_Set_ART(options);
+
+        run_kernels(1, warm_up);
+        row->check = run_kernels(BENCH_PASSES, row->cycles);
+
+        for (uint32_t idx=0; idx<KERNEL_COUNT; idx++) row->total += row->cycles[idx];
+    }
+
+    MCU_Flash_Set_ART(0);
+    MCU_Flash_Set_ART(saved);
+
+    Bench_Wait_States = MCU_Flash_Get_Wait_States();
+    Bench_Next_Row    = 0;
+
+    CLI_CMD_Printf("  %-3s %-3s %-3s %8s %8s %8s %8s %9s %6s  %s\n",
+        "ic", "dc", "pf", "list", "matrix", "state", "crc", "total", "vs off", "check");
+    flash_more();
+}
+
+// -----------------------------------------------------------------------------+-
+// flash
+// -----------------------------------------------------------------------------+-
+static void flash_show(void)
+{
+    uint32_t options = MCU_Flash_Get_ART();
+
+    CLI_CMD_Printf("flash: %lu wait states at HCLK %lu MHz; icache %s, dcache %s, prefetch %s\n",
+        (unsigned long)MCU_Flash_Get_Wait_States(),
+        (unsigned long)(SystemCoreClock / 1000000U),
+        (options & MCU_FLASH_ART_ICACHE)   ? "on" : "off",
+        (options & MCU_FLASH_ART_DCACHE)   ? "on" : "off",
+        (options & MCU_FLASH_ART_PREFETCH) ? "on" : "off"
+    );
+}
+
+// -----------------------------------------------------------------------------+-
+// flash [art [icache] [dcache] [prefetch] | bench | more]
+// -----------------------------------------------------------------------------+-
+static void flash_cmd(int argc, char *argv[])
+{
+    if (argc == 1) {
+        flash_show();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "bench") == 0) {
+        flash_bench();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "more") == 0) {
+        flash_more();
+        return;
+    }
+
+    if (strcmp(argv[1], "art") == 0)
+    {
+        uint32_t options = 0;
+
+        for (int idx=2; idx<argc; idx++)
+        {
+            if      (strcmp(argv[idx], "icache")   == 0) options |= MCU_FLASH_ART_ICACHE;
+            else if (strcmp(argv[idx], "dcache")   == 0) options |= MCU_FLASH_ART_DCACHE;
+            else if (strcmp(argv[idx], "prefetch") == 0) options |= MCU_FLASH_ART_PREFETCH;
+            else {
+                CLI_CMD_Printf("flash: \"%s\" is not an ART option\n", argv[idx]);
+                return;
+            }
+        }
+        MCU_Flash_Set_ART(options);
+        flash_show();
+        return;
+    }
+
+    CLI_CMD_Printf("usage: flash [art [icache] [dcache] [prefetch] | bench | more]\n");
+}
+
+static const CLI_CMD_Descriptor Flash_Cmd = {
+    .name    = "flash",
+    .help    = "show or set the flash ART options; benchmark them",
+    .handler = flash_cmd,
+};
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void MCU_Flash_CLI_Init(void)
+{
+    CLI_CMD_Register(&Flash_Cmd);
+}
@@ -0,0 +1,30 @@
+/*
+================================================================================================#=
+Flash Latency CLI
+
+Provides the 'flash' command to show and try out the flash wait states and
+ART accelerator settings of flash-latency.h from the command line interface.
+
+    flash                                   show the wait states and the ART options
+    flash art [icache] [dcache] [prefetch]  enable the given ART options, disable the rest
+    flash bench                             time CoreMark-style loops with each combination
+                                            of ART options, then restore the current ones;
+                                            shows the first page of the results
+    flash more                              show the next page of the results
+
+The benchmark runs four small kernels after the manner of CoreMark: a linked
+list walk, a matrix multiply with a constant matrix in flash, a state machine
+that scans a constant string in flash, and a CRC16 over their results.
+Each is timed with the DWT cycle counter, from a warm start, and the CRC
+is shown as a check that every combination did the same work.
+
+The command runs in the context of the CLI, i.e. the USART interrupt;
+the benchmark holds off all other interrupts of the same or lower priority
+for the few tens of milliseconds it takes.
+================================================================================================#=
+*/
+
+#pragma once
+
+// Register the 'flash' command with the CLI;
+void MCU_Flash_CLI_Init(void);
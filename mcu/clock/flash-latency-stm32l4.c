@@ -0,0 +1,167 @@
+
+/*
+================================================================================================#=
+FLASH LATENCY AND ART ACCELERATOR
+mcu/clock/flash-latency-stm32l4.c
+
+Description:
+    The STM32L4 implementation of flash-latency.h;
+    see that file for a description of this module.
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/flash-latency.h"
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+// STM32 Low Level Drivers
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_system.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+// -----------------------------------------------------+-
+// The highest HCLK for each number of wait states;
+// See Table 11 of the RM0351 Reference Manual,
+// "Number of wait states according to CPU clock (HCLK) frequency".
+// -----------------------------------------------------+-
+static const uint32_t Range_1_Max_Hz[] = {
+    16000000UL,     // 0 WS
+    32000000UL,     // 1 WS
+    48000000UL,     // 2 WS
+    64000000UL,     // 3 WS
+    80000000UL,     // 4 WS
+};
+
+static const uint32_t Range_2_Max_Hz[] = {
+     6000000UL,     // 0 WS
+    12000000UL,     // 1 WS
+    18000000UL,     // 2 WS
+    26000000UL,     // 3 WS
+};
+
+#define COUNT_OF(_array_) (sizeof(_array_) / sizeof((_array_)[0]))
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// Set the wait states, and wait until the flash interface has taken them;
+// LL_FLASH_LATENCY_n is n, the value of the LATENCY field.
+// ---------------------------------------------------------------------+-
+static void set_wait_states(uint32_t wait_states)
+{
+    LL_FLASH_SetLatency(wait_states);
+    while(LL_FLASH_GetLatency() != wait_states) {};
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Flash_Wait_States(uint32_t hclk_hz, MCU_Flash_Voltage_Range range)
+{
+    const uint32_t *max_hz = Range_1_Max_Hz;
+    uint32_t        count  = COUNT_OF(Range_1_Max_Hz);
+
+    if (range == MCU_FLASH_RANGE_2) {
+        max_hz = Range_2_Max_Hz;
+        count  = COUNT_OF(Range_2_Max_Hz);
+    }
+
+    for (uint32_t ws=0; ws<count; ws++)
+    {
+        if (hclk_hz <= max_hz[ws]) return ws;
+    }
+    return MCU_FLASH_WS_INVALID;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+bool MCU_Flash_Before_HCLK_Change(uint32_t new_hclk_hz, MCU_Flash_Voltage_Range range)
+{
+    uint32_t wait_states = MCU_Flash_Wait_States(new_hclk_hz, range);
+
+    if (wait_states == MCU_FLASH_WS_INVALID) return false;
+
+    if (wait_states > LL_FLASH_GetLatency()) {
+        set_wait_states(wait_states);
+    }
+    return true;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Flash_After_HCLK_Change(uint32_t new_hclk_hz, MCU_Flash_Voltage_Range range)
+{
+    uint32_t wait_states = MCU_Flash_Wait_States(new_hclk_hz, range);
+
+    if (wait_states == MCU_FLASH_WS_INVALID) return;
+
+    if (wait_states < LL_FLASH_GetLatency()) {
+        set_wait_states(wait_states);
+    }
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Flash_Get_Wait_States(void)
+{
+    return LL_FLASH_GetLatency();
+};
+
+// ---------------------------------------------------------------------+-
+// The cache reset bits only take effect while the cache is disabled;
+// RM0351, 3.3.4 Adaptive real-time memory accelerator (ART Accelerator).
+// ---------------------------------------------------------------------+-
+void MCU_Flash_Set_ART(uint32_t options)
+{
+    if (options & MCU_FLASH_ART_PREFETCH) LL_FLASH_EnablePrefetch();
+    else                                  LL_FLASH_DisablePrefetch();
+
+    if (!(options & MCU_FLASH_ART_ICACHE)) {
+        LL_FLASH_DisableInstCache();
+    }
+    else if (!(FLASH->ACR & FLASH_ACR_ICEN)) {
+        LL_FLASH_EnableInstCacheReset();
+        LL_FLASH_DisableInstCacheReset();
+        LL_FLASH_EnableInstCache();
+    }
+
+    if (!(options & MCU_FLASH_ART_DCACHE)) {
+        LL_FLASH_DisableDataCache();
+    }
+    else if (!(FLASH->ACR & FLASH_ACR_DCEN)) {
+        LL_FLASH_EnableDataCacheReset();
+        LL_FLASH_DisableDataCacheReset();
+        LL_FLASH_EnableDataCache();
+    }
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+uint32_t MCU_Flash_Get_ART(void)
+{
+    uint32_t options = 0;
+
+    if (FLASH->ACR & FLASH_ACR_ICEN)   options |= MCU_FLASH_ART_ICACHE;
+    if (FLASH->ACR & FLASH_ACR_DCEN)   options |= MCU_FLASH_ART_DCACHE;
+    if (FLASH->ACR & FLASH_ACR_PRFTEN) options |= MCU_FLASH_ART_PREFETCH;
+
+    return options;
+};
@@ -0,0 +1,108 @@
+/*
+================================================================================================#=
+FLASH LATENCY AND ART ACCELERATOR
+mcu/clock/flash-latency.h
+
+Description:
+    Keeps the flash wait states in step with the clock tree, and manages
+    the flash memory accelerator (ART): its instruction cache, data cache
+    and prefetch buffer.
+
+    The flash cannot be read at the HCLK frequency; each read takes a number
+    of wait states that depends on HCLK and on the voltage range of the
+    core regulator.  The wait states must be raised BEFORE the HCLK rises,
+    and may only be lowered AFTER it has fallen.  So, around any change to
+    the SYSCLK source, the PLL or the AHB prescaler:
+
+        if (!MCU_Flash_Before_HCLK_Change(new_hclk_hz, range)) { ...too fast... }
+        ...change the clock tree...
+        MCU_Flash_After_HCLK_Change(new_hclk_hz, range);
+
+    Both wait until the new setting reads back from the FLASH_ACR register,
+    as the reference manual requires; RM0351, 3.3.3 Read access latency.
+
+    The ART hides most of the wait states for code and constants that it
+    has cached.  The instruction and data caches are reset as they are
+    enabled, so that neither holds anything from before.  The prefetch
+    buffer reads the next flash line ahead of sequential code; it helps
+    most with the caches off, and costs some power.
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU; see flash-latency-stm32l4.c
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// Voltage range of the core regulator; see the VOS bits of PWR_CR1.
+// Range 1 is the reset default, and the only one that allows 80MHz.
+// -----------------------------------------------------------------------------+-
+typedef enum
+{
+    MCU_FLASH_RANGE_1 = 1,      // High performance; HCLK up to 80MHz;
+    MCU_FLASH_RANGE_2 = 2,      // Low power; HCLK up to 26MHz;
+
+}   MCU_Flash_Voltage_Range;
+
+// Returned by MCU_Flash_Wait_States() for an HCLK the range does not allow;
+#define MCU_FLASH_WS_INVALID    (UINT32_MAX)
+
+
+// -----------------------------------------------------------------------------+-
+// ART options; may be or'd together.
+// The default enables both caches and leaves the prefetch off, as does
+// the Cube HAL.
+// -----------------------------------------------------------------------------+-
+#define MCU_FLASH_ART_ICACHE    (1U << 0)
+#define MCU_FLASH_ART_DCACHE    (1U << 1)
+#define MCU_FLASH_ART_PREFETCH  (1U << 2)
+#define MCU_FLASH_ART_ALL       (MCU_FLASH_ART_ICACHE | MCU_FLASH_ART_DCACHE | MCU_FLASH_ART_PREFETCH)
+
+#define MCU_FLASH_ART_DEFAULT   (MCU_FLASH_ART_ICACHE | MCU_FLASH_ART_DCACHE)
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the number of wait states the flash needs at the given HCLK
+// in the given voltage range, or MCU_FLASH_WS_INVALID if the range
+// does not allow that HCLK.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+uint32_t MCU_Flash_Wait_States(uint32_t hclk_hz, MCU_Flash_Voltage_Range range);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Call before the HCLK changes to the given frequency;
+// Raises the wait states if the new HCLK needs more; leaves them be otherwise.
+// Returns false, having changed nothing, if the range does not allow
+// the new HCLK; the clock tree must then not be changed.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Flash_Before_HCLK_Change(uint32_t new_hclk_hz, MCU_Flash_Voltage_Range range);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Call once the HCLK runs at the given frequency;
+// Lowers the wait states if the new HCLK needs fewer.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Flash_After_HCLK_Change(uint32_t new_hclk_hz, MCU_Flash_Voltage_Range range);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the wait states currently set in FLASH_ACR;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+uint32_t MCU_Flash_Get_Wait_States(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Set the ART to the given options, MCU_FLASH_ART_...;
+// Those not given are disabled.  A cache that is enabled here is reset first.
+// Safe to call from code that runs from flash.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Flash_Set_ART(uint32_t options);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the ART options currently enabled, MCU_FLASH_ART_...;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+uint32_t MCU_Flash_Get_ART(void);
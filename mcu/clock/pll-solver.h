@@ -0,0 +1,349 @@
+/*
+================================================================================================#=
+PLL SOLVER
+mcu/clock/pll-solver.h
+
+Description:
+    Derives the PLL dividers for a given source and target SYSCLK at compile
+    time, checks them against the limits of the MCU family with static
+    asserts, and provides the resulting clock frequencies as compile-time
+    constants; so that, e.g., a SysTick reload or a USART BRR computed
+    from them folds to a constant.
+
+    Configure it per board or app with -D, e.g. in the app Makefile:
+
+        CFLAGS += -DMCU_PLL_SOURCE=MCU_PLL_SOURCE_HSE
+        CFLAGS += -DMCU_PLL_SOURCE_HZ=8000000UL
+        CFLAGS += -DMCU_PLL_SYSCLK_HZ=72000000UL
+
+    The defaults are the clock trees this project has always used:
+
+        STM32L4     MSI at 4MHz  ==> PLL ==> 80MHz
+        STM32F0     HSI at 8MHz  ==> PLL ==> 48MHz
+
+    The solver tries the candidates in a fixed order and takes the first
+    that meets every limit; if none does, compilation stops with a static
+    assert.  The dividers may also be given outright, e.g. -DMCU_PLL_M=1
+    -DMCU_PLL_N=40 -DMCU_PLL_R=2 on the L4; they are then only checked.
+
+    STM32L4: RM0351, 6.2.5 PLL
+        VCO input   = source / M            4MHz .. 16MHz,   M 1..8
+        VCO output  = VCO input * N         64MHz .. 344MHz, N 8..86
+        PLLCLK      = VCO output / R        at most 80MHz,   R 2, 4, 6 or 8
+        PLL48M1CLK  = VCO output / Q                         Q 2, 4, 6 or 8
+        PLLSAI3CLK  = VCO output / P                         P 7 or 17
+    Candidates go from the lowest VCO output, i.e. the least power, and
+    for each, the highest VCO input, i.e. the least jitter.  The Q and P
+    outputs are solved for only if MCU_PLL_Q_HZ or MCU_PLL_P_HZ is given;
+    the VCO output must then divide down to them exactly as well.
+
+    STM32F0: RM0091, 6.2.3 PLL
+        PLL input   = source / PREDIV       1MHz .. 24MHz,   PREDIV 1..16
+        PLLCLK      = PLL input * PLLMUL    16MHz .. 48MHz,  PLLMUL 2..16
+    Candidates go from the highest PLL input.
+
+    Every frequency is in Hz.  Include this header, rather than define
+    its results, wherever the clock tree is set up or its rates are used.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+
+// -----------------------------------------------------------------------------+-
+// PLL sources
+// MCU_PLL_SOURCE_MSI is L4 only; MCU_PLL_SOURCE_HSI48 is F0 only.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_SOURCE_MSI      (1)
+#define MCU_PLL_SOURCE_HSI      (2)
+#define MCU_PLL_SOURCE_HSE      (3)
+#define MCU_PLL_SOURCE_HSI48    (4)
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// STM32L4
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+#if defined(MCUFAM_STM32L4)
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_PLL_SOURCE
+#define MCU_PLL_SOURCE          MCU_PLL_SOURCE_MSI
+#endif
+
+#ifndef MCU_PLL_SOURCE_HZ
+#if   MCU_PLL_SOURCE == MCU_PLL_SOURCE_MSI
+#define MCU_PLL_SOURCE_HZ       (4000000UL)
+#elif MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI
+#define MCU_PLL_SOURCE_HZ       (16000000UL)
+#else
+#error "MCU_PLL_SOURCE_HZ must be given for this MCU_PLL_SOURCE"
+#endif
+#endif
+
+#ifndef MCU_PLL_SYSCLK_HZ
+#define MCU_PLL_SYSCLK_HZ       (80000000UL)
+#endif
+
+// Zero for none;
+#ifndef MCU_PLL_Q_HZ
+#define MCU_PLL_Q_HZ            (0UL)
+#endif
+
+#ifndef MCU_PLL_P_HZ
+#define MCU_PLL_P_HZ            (0UL)
+#endif
+
+#if MCU_PLL_SOURCE != MCU_PLL_SOURCE_MSI && MCU_PLL_SOURCE != MCU_PLL_SOURCE_HSI && MCU_PLL_SOURCE != MCU_PLL_SOURCE_HSE
+#error "MCU_PLL_SOURCE must be MSI, HSI or HSE on the STM32L4"
+#endif
+
+// -----------------------------------------------------------------------------+-
+// Limits; RM0351 and the STM32L476xx datasheet, voltage range 1.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_VCO_IN_MIN_HZ   (4000000ULL)
+#define MCU_PLL_VCO_IN_MAX_HZ   (16000000ULL)
+#define MCU_PLL_VCO_MIN_HZ      (64000000ULL)
+#define MCU_PLL_VCO_MAX_HZ      (344000000ULL)
+#define MCU_PLL_N_MIN           (8ULL)
+#define MCU_PLL_N_MAX           (86ULL)
+#define MCU_PLL_SYSCLK_MAX_HZ   (80000000ULL)
+
+// -----------------------------------------------------------------------------+-
+// The solver, for the candidate dividers M and R;
+// N is whatever makes the VCO output SYSCLK * R, if a whole number.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_VCO_OF_(_r_)    ((unsigned long long)MCU_PLL_SYSCLK_HZ * (_r_))
+#define MCU_PLL_N_OF_(_m_, _r_) (MCU_PLL_VCO_OF_(_r_) * (_m_) / MCU_PLL_SOURCE_HZ)
+
+// The divider of the given set that takes the VCO output to the given
+// frequency exactly, or zero;
+#define MCU_PLL_DIV_OF_(_vco_, _hz_, _d1_, _d2_, _d3_, _d4_)    \
+    ( (_hz_) == 0 ? 0U :                                        \
+      (_vco_) == (_hz_) * (_d1_) ? (_d1_) :                     \
+      (_vco_) == (_hz_) * (_d2_) ? (_d2_) :                     \
+      (_vco_) == (_hz_) * (_d3_) ? (_d3_) :                     \
+      (_vco_) == (_hz_) * (_d4_) ? (_d4_) : 0U )
+
+#define MCU_PLL_Q_OF_(_vco_)    MCU_PLL_DIV_OF_(_vco_, (unsigned long long)MCU_PLL_Q_HZ, 2U, 4U, 6U, 8U)
+#define MCU_PLL_P_OF_(_vco_)    MCU_PLL_DIV_OF_(_vco_, (unsigned long long)MCU_PLL_P_HZ, 7U, 17U, 7U, 17U)
+
+#define MCU_PLL_OK_(_m_, _r_)                                                           \
+    (  (unsigned long long)MCU_PLL_SOURCE_HZ >= MCU_PLL_VCO_IN_MIN_HZ * (_m_)           \
+    && (unsigned long long)MCU_PLL_SOURCE_HZ <= MCU_PLL_VCO_IN_MAX_HZ * (_m_)           \
+    && (MCU_PLL_VCO_OF_(_r_) * (_m_)) % MCU_PLL_SOURCE_HZ == 0                          \
+    && MCU_PLL_N_OF_(_m_, _r_) >= MCU_PLL_N_MIN                                         \
+    && MCU_PLL_N_OF_(_m_, _r_) <= MCU_PLL_N_MAX                                         \
+    && MCU_PLL_VCO_OF_(_r_) >= MCU_PLL_VCO_MIN_HZ                                       \
+    && MCU_PLL_VCO_OF_(_r_) <= MCU_PLL_VCO_MAX_HZ                                       \
+    && (MCU_PLL_Q_HZ == 0 || MCU_PLL_Q_OF_(MCU_PLL_VCO_OF_(_r_)) != 0)                  \
+    && (MCU_PLL_P_HZ == 0 || MCU_PLL_P_OF_(MCU_PLL_VCO_OF_(_r_)) != 0) )
+
+#define MCU_PLL_TRY_(_m_, _r_)  MCU_PLL_OK_(_m_, _r_) ? ((_m_) * 16U + (_r_)) :
+
+#define MCU_PLL_CANDIDATES_(_try_)                                                      \
+    _try_(1,2) _try_(2,2) _try_(3,2) _try_(4,2) _try_(5,2) _try_(6,2) _try_(7,2) _try_(8,2) \
+    _try_(1,4) _try_(2,4) _try_(3,4) _try_(4,4) _try_(5,4) _try_(6,4) _try_(7,4) _try_(8,4) \
+    _try_(1,6) _try_(2,6) _try_(3,6) _try_(4,6) _try_(5,6) _try_(6,6) _try_(7,6) _try_(8,6) \
+    _try_(1,8) _try_(2,8) _try_(3,8) _try_(4,8) _try_(5,8) _try_(6,8) _try_(7,8) _try_(8,8)
+
+// M * 16 + R of the first candidate that meets every limit, or zero;
+#define MCU_PLL_SOLUTION_       (MCU_PLL_CANDIDATES_(MCU_PLL_TRY_) 0U)
+
+// -----------------------------------------------------------------------------+-
+// The dividers; solved for, unless given.
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_PLL_M
+#define MCU_PLL_M               (MCU_PLL_SOLUTION_ / 16U)
+#define MCU_PLL_R               (MCU_PLL_SOLUTION_ % 16U)
+#define MCU_PLL_N               ((unsigned)MCU_PLL_N_OF_(MCU_PLL_M, MCU_PLL_R))
+
+_Static_assert(MCU_PLL_SOLUTION_ != 0,
+    "pll-solver: no M, N and R take MCU_PLL_SOURCE_HZ to MCU_PLL_SYSCLK_HZ within the STM32L4 PLL limits");
+#endif
+
+#define MCU_PLL_VCO_IN_HZ       ((unsigned long long)MCU_PLL_SOURCE_HZ / MCU_PLL_M)
+#define MCU_PLL_VCO_HZ          ((unsigned long long)MCU_PLL_SOURCE_HZ * MCU_PLL_N / MCU_PLL_M)
+#define MCU_PLL_Q               (MCU_PLL_Q_OF_(MCU_PLL_VCO_HZ))
+#define MCU_PLL_P               (MCU_PLL_P_OF_(MCU_PLL_VCO_HZ))
+
+// -----------------------------------------------------------------------------+-
+// Checks; these matter most for dividers given outright.
+// -----------------------------------------------------------------------------+-
+_Static_assert(MCU_PLL_M >= 1 && MCU_PLL_M <= 8,
+    "pll-solver: PLLM must be 1..8");
+_Static_assert(MCU_PLL_N >= MCU_PLL_N_MIN && MCU_PLL_N <= MCU_PLL_N_MAX,
+    "pll-solver: PLLN must be 8..86");
+_Static_assert(MCU_PLL_R == 2 || MCU_PLL_R == 4 || MCU_PLL_R == 6 || MCU_PLL_R == 8,
+    "pll-solver: PLLR must be 2, 4, 6 or 8");
+_Static_assert(MCU_PLL_VCO_IN_HZ >= MCU_PLL_VCO_IN_MIN_HZ && MCU_PLL_VCO_IN_HZ <= MCU_PLL_VCO_IN_MAX_HZ,
+    "pll-solver: the VCO input must be 4MHz..16MHz");
+_Static_assert(MCU_PLL_VCO_HZ >= MCU_PLL_VCO_MIN_HZ && MCU_PLL_VCO_HZ <= MCU_PLL_VCO_MAX_HZ,
+    "pll-solver: the VCO output must be 64MHz..344MHz");
+_Static_assert((unsigned long long)MCU_PLL_SOURCE_HZ * MCU_PLL_N == (unsigned long long)MCU_PLL_SYSCLK_HZ * MCU_PLL_R * MCU_PLL_M,
+    "pll-solver: M, N and R do not make MCU_PLL_SYSCLK_HZ exactly");
+_Static_assert(MCU_PLL_SYSCLK_HZ <= MCU_PLL_SYSCLK_MAX_HZ,
+    "pll-solver: the STM32L4 SYSCLK must be at most 80MHz");
+_Static_assert(MCU_PLL_Q_HZ == 0 || MCU_PLL_Q != 0,
+    "pll-solver: no PLLQ makes MCU_PLL_Q_HZ exactly");
+_Static_assert(MCU_PLL_P_HZ == 0 || MCU_PLL_P != 0,
+    "pll-solver: no PLLP makes MCU_PLL_P_HZ exactly");
+
+// -----------------------------------------------------------------------------+-
+// The dividers as the STM32 LL drivers encode them, e.g. for
+// LL_RCC_PLL_ConfigDomain_SYS(); i.e. LL_RCC_PLLM_DIV_n and so on.
+// Expand these only where the CMSIS device header is included.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_LL_M            ((MCU_PLL_M - 1U) << RCC_PLLCFGR_PLLM_Pos)
+#define MCU_PLL_LL_N            (MCU_PLL_N)
+#define MCU_PLL_LL_R            (((MCU_PLL_R / 2U) - 1U) << RCC_PLLCFGR_PLLR_Pos)
+#define MCU_PLL_LL_Q            (((MCU_PLL_Q / 2U) - 1U) << RCC_PLLCFGR_PLLQ_Pos)
+#define MCU_PLL_LL_P            (MCU_PLL_P == 17U ? RCC_PLLCFGR_PLLP : 0U)
+
+#if   MCU_PLL_SOURCE == MCU_PLL_SOURCE_MSI
+#define MCU_PLL_LL_SOURCE       LL_RCC_PLLSOURCE_MSI
+#elif MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI
+#define MCU_PLL_LL_SOURCE       LL_RCC_PLLSOURCE_HSI
+#else
+#define MCU_PLL_LL_SOURCE       LL_RCC_PLLSOURCE_HSE
+#endif
+
+// The MSI range, as selected by MSIRANGE in RCC_CR, for an MSI source;
+#if MCU_PLL_SOURCE == MCU_PLL_SOURCE_MSI
+#if   MCU_PLL_SOURCE_HZ == 4000000UL
+#define MCU_PLL_LL_MSIRANGE     LL_RCC_MSIRANGE_6
+#elif MCU_PLL_SOURCE_HZ == 8000000UL
+#define MCU_PLL_LL_MSIRANGE     LL_RCC_MSIRANGE_7
+#elif MCU_PLL_SOURCE_HZ == 16000000UL
+#define MCU_PLL_LL_MSIRANGE     LL_RCC_MSIRANGE_8
+#elif MCU_PLL_SOURCE_HZ == 24000000UL
+#define MCU_PLL_LL_MSIRANGE     LL_RCC_MSIRANGE_9
+#elif MCU_PLL_SOURCE_HZ == 32000000UL
+#define MCU_PLL_LL_MSIRANGE     LL_RCC_MSIRANGE_10
+#elif MCU_PLL_SOURCE_HZ == 48000000UL
+#define MCU_PLL_LL_MSIRANGE     LL_RCC_MSIRANGE_11
+#else
+#error "MCU_PLL_SOURCE_HZ must be an MSI range of 4MHz or more: 4, 8, 16, 24, 32 or 48MHz"
+#endif
+#endif
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// STM32F0
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+#elif defined(MCUFAM_STM32F0)
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_PLL_SOURCE
+#define MCU_PLL_SOURCE          MCU_PLL_SOURCE_HSI
+#endif
+
+#ifndef MCU_PLL_SOURCE_HZ
+#if   MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI
+#define MCU_PLL_SOURCE_HZ       (8000000UL)
+#elif MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI48
+#define MCU_PLL_SOURCE_HZ       (48000000UL)
+#else
+#error "MCU_PLL_SOURCE_HZ must be given for this MCU_PLL_SOURCE"
+#endif
+#endif
+
+#ifndef MCU_PLL_SYSCLK_HZ
+#define MCU_PLL_SYSCLK_HZ       (48000000UL)
+#endif
+
+#if MCU_PLL_SOURCE != MCU_PLL_SOURCE_HSI && MCU_PLL_SOURCE != MCU_PLL_SOURCE_HSE && MCU_PLL_SOURCE != MCU_PLL_SOURCE_HSI48
+#error "MCU_PLL_SOURCE must be HSI, HSE or HSI48 on the STM32F0"
+#endif
+
+// -----------------------------------------------------------------------------+-
+// Limits; RM0091 and the STM32F091xC datasheet.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_IN_MIN_HZ       (1000000ULL)
+#define MCU_PLL_IN_MAX_HZ       (24000000ULL)
+#define MCU_PLL_OUT_MIN_HZ      (16000000ULL)
+#define MCU_PLL_OUT_MAX_HZ      (48000000ULL)
+#define MCU_PLL_MUL_MIN         (2ULL)
+#define MCU_PLL_MUL_MAX         (16ULL)
+
+// -----------------------------------------------------------------------------+-
+// The solver, for the candidate divider PREDIV;
+// PLLMUL is whatever makes SYSCLK, if a whole number.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_MUL_OF_(_d_)    ((unsigned long long)MCU_PLL_SYSCLK_HZ * (_d_) / MCU_PLL_SOURCE_HZ)
+
+#define MCU_PLL_OK_(_d_)                                                                \
+    (  (unsigned long long)MCU_PLL_SOURCE_HZ >= MCU_PLL_IN_MIN_HZ * (_d_)               \
+    && (unsigned long long)MCU_PLL_SOURCE_HZ <= MCU_PLL_IN_MAX_HZ * (_d_)               \
+    && ((unsigned long long)MCU_PLL_SYSCLK_HZ * (_d_)) % MCU_PLL_SOURCE_HZ == 0         \
+    && MCU_PLL_MUL_OF_(_d_) >= MCU_PLL_MUL_MIN                                          \
+    && MCU_PLL_MUL_OF_(_d_) <= MCU_PLL_MUL_MAX )
+
+#define MCU_PLL_TRY_(_d_)       MCU_PLL_OK_(_d_) ? (_d_) :
+
+#define MCU_PLL_CANDIDATES_(_try_)                                                      \
+    _try_(1U)  _try_(2U)  _try_(3U)  _try_(4U)  _try_(5U)  _try_(6U)  _try_(7U)  _try_(8U)  \
+    _try_(9U)  _try_(10U) _try_(11U) _try_(12U) _try_(13U) _try_(14U) _try_(15U) _try_(16U)
+
+// PREDIV of the first candidate that meets every limit, or zero;
+#define MCU_PLL_SOLUTION_       (MCU_PLL_CANDIDATES_(MCU_PLL_TRY_) 0U)
+
+// -----------------------------------------------------------------------------+-
+// The dividers; solved for, unless given.
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_PLL_PREDIV
+#define MCU_PLL_PREDIV          (MCU_PLL_SOLUTION_)
+#define MCU_PLL_MUL             ((unsigned)MCU_PLL_MUL_OF_(MCU_PLL_PREDIV))
+
+_Static_assert(MCU_PLL_SOLUTION_ != 0,
+    "pll-solver: no PREDIV and PLLMUL take MCU_PLL_SOURCE_HZ to MCU_PLL_SYSCLK_HZ within the STM32F0 PLL limits");
+#endif
+
+#define MCU_PLL_IN_HZ           ((unsigned long long)MCU_PLL_SOURCE_HZ / MCU_PLL_PREDIV)
+
+// -----------------------------------------------------------------------------+-
+// Checks; these matter most for dividers given outright.
+// -----------------------------------------------------------------------------+-
+_Static_assert(MCU_PLL_PREDIV >= 1 && MCU_PLL_PREDIV <= 16,
+    "pll-solver: PREDIV must be 1..16");
+_Static_assert(MCU_PLL_MUL >= MCU_PLL_MUL_MIN && MCU_PLL_MUL <= MCU_PLL_MUL_MAX,
+    "pll-solver: PLLMUL must be 2..16");
+_Static_assert(MCU_PLL_IN_HZ >= MCU_PLL_IN_MIN_HZ && MCU_PLL_IN_HZ <= MCU_PLL_IN_MAX_HZ,
+    "pll-solver: the PLL input must be 1MHz..24MHz");
+_Static_assert((unsigned long long)MCU_PLL_SOURCE_HZ * MCU_PLL_MUL == (unsigned long long)MCU_PLL_SYSCLK_HZ * MCU_PLL_PREDIV,
+    "pll-solver: PREDIV and PLLMUL do not make MCU_PLL_SYSCLK_HZ exactly");
+_Static_assert(MCU_PLL_SYSCLK_HZ >= MCU_PLL_OUT_MIN_HZ && MCU_PLL_SYSCLK_HZ <= MCU_PLL_OUT_MAX_HZ,
+    "pll-solver: the STM32F0 PLL output must be 16MHz..48MHz");
+
+// -----------------------------------------------------------------------------+-
+// The dividers as the RCC_CFGR and RCC_CFGR2 registers encode them;
+// Expand these only where the CMSIS device header is included.
+// -----------------------------------------------------------------------------+-
+#define MCU_PLL_CFGR_PLLMUL     ((MCU_PLL_MUL - 2U) << RCC_CFGR_PLLMUL_Pos)
+#define MCU_PLL_CFGR2_PREDIV    ((MCU_PLL_PREDIV - 1U) << RCC_CFGR2_PREDIV_Pos)
+
+#if   MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI
+#define MCU_PLL_CFGR_PLLSRC     RCC_CFGR_PLLSRC_HSI_PREDIV
+#elif MCU_PLL_SOURCE == MCU_PLL_SOURCE_HSI48
+#define MCU_PLL_CFGR_PLLSRC     RCC_CFGR_PLLSRC_HSI48_PREDIV
+#else
+#define MCU_PLL_CFGR_PLLSRC     RCC_CFGR_PLLSRC_HSE_PREDIV
+#endif
+
+#else
+#error "pll-solver: MCUFAM_STM32L4 or MCUFAM_STM32F0 must be defined"
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// The bus clocks of the default clock tree, with the PLL as the SYSCLK
+// and the AHB and APB prescalers at 1;
+// -----------------------------------------------------------------------------+-
+#define MCU_CLOCK_HCLK_HZ       (MCU_PLL_SYSCLK_HZ)
+#define MCU_CLOCK_PCLK1_HZ      (MCU_PLL_SYSCLK_HZ)
+#define MCU_CLOCK_PCLK2_HZ      (MCU_PLL_SYSCLK_HZ)
@@ -0,0 +1,256 @@
+
+/*
+================================================================================================#=
+TIMEBASE
+mcu/clock/timebase-stm32f0.c
+
+Description:
+    The STM32F0 implementation of timebase.h;
+    see that file for a description of this module.
+    As timebase-stm32l4.c, less the clock profiles, which the F0 lacks.
+
+    The 64-bit count is Base + TIM2->CNT, where Base is the count at which
+    TIM2 last started from zero: at a wrap, or at init.
+    Base changes only with interrupts masked, and each change bumps Generation;
+    a reader that sees Generation change under it reads again.
+
+    The update request source is the counter alone (URS), so that the
+    update event that loads the prescaler sets no wrap flag.
+
+    The alarm is armed on the compare channel only within the window of
+    the counter it falls in; the wrap into that window arms it.  One that
+    is due already, or falls due as it is armed, is raised at once by
+    a software compare event.
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32F0 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/timebase.h"
+#include "mcu/clock/clock-tree-info.h"
+
+#include <stddef.h>
+
+#include "CMSIS/Device/ST/STM32F0xx/Include/stm32f091xc.h"
+
+// STM32 Low Level Drivers
+#include "STM32F0xx_HAL_Driver/Inc/stm32f0xx_ll_bus.h"
+#include "STM32F0xx_HAL_Driver/Inc/stm32f0xx_ll_tim.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+#ifndef MCU_TIMEBASE_IRQ_PRIORITY
+#define MCU_TIMEBASE_IRQ_PRIORITY ((1UL << __NVIC_PRIO_BITS) - 1UL)
+#endif
+
+#define WRAP_CYCLES (1ULL << 32)
+
+static volatile uint64_t Base       = 0;
+static volatile uint32_t Generation = 0;
+
+static MCU_Timebase_Alarm_Callback Alarm_Callback = NULL;
+static uint64_t                    Alarm_At       = 0;
+static bool                        Alarm_Armed    = false;
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// The TIM2 prescaler for the given timer clock; or zero, i.e. none,
+// if the clock is not a multiple of MCU_TIMEBASE_HZ, or too fast for
+// the 16-bit prescaler.
+// ---------------------------------------------------------------------+-
+static uint32_t prescaler_for(uint32_t timer_clock_hz)
+{
+    if (timer_clock_hz < MCU_TIMEBASE_HZ || (timer_clock_hz % MCU_TIMEBASE_HZ) != 0) return 0;
+    if (timer_clock_hz / MCU_TIMEBASE_HZ > 65536U) return 0;
+    return (uint32_t)(timer_clock_hz / MCU_TIMEBASE_HZ);
+}
+
+// ---------------------------------------------------------------------+-
+// Put the compare channel in step with the alarm and Base;
+// to be called with interrupts masked.
+// ---------------------------------------------------------------------+-
+static void arm_compare(void)
+{
+    LL_TIM_DisableIT_CC1(TIM2);
+    LL_TIM_ClearFlag_CC1(TIM2);
+
+    if (!Alarm_Armed) return;
+
+    if (MCU_Timebase_Now_Cycles() < Alarm_At)
+    {
+        // For a later window, the wrap into it arms it;
+        if (Alarm_At - Base >= WRAP_CYCLES) return;
+
+        LL_TIM_OC_SetCompareCH1(TIM2, (uint32_t)(Alarm_At - Base));
+        LL_TIM_EnableIT_CC1(TIM2);
+
+        // Unless the counter passed it meanwhile;
+        if (MCU_Timebase_Now_Cycles() < Alarm_At) return;
+    }
+
+    LL_TIM_EnableIT_CC1(TIM2);
+    LL_TIM_GenerateEvent_CC1(TIM2);
+}
+
+// ---------------------------------------------------------------------+-
+// Start TIM2 from zero at the given prescaler, with Base at the given
+// count; to be called with interrupts masked.
+// ---------------------------------------------------------------------+-
+static void restart(uint64_t base, uint32_t prescaler)
+{
+    LL_TIM_SetPrescaler(TIM2, prescaler - 1U);
+    LL_TIM_GenerateEvent_UPDATE(TIM2);
+    LL_TIM_ClearFlag_UPDATE(TIM2);
+
+    Base = base;
+    Generation++;
+    arm_compare();
+}
+
+
+
+// =============================================================================================#=
+// Interrupt Handler
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// TIM2 wrapped, or the alarm compare matched;
+// The wrap flag is cleared and Base moved as one, so that no reader sees
+// the one without the other.  The alarm callback runs unmasked.
+// ---------------------------------------------------------------------+-
+void TIM2_IRQHandler(void)
+{
+    MCU_Timebase_Alarm_Callback due = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (TIM2->SR & TIM_SR_UIF) {
+        TIM2->SR = ~TIM_SR_UIF;
+        Base = Base + WRAP_CYCLES;
+        Generation++;
+        arm_compare();
+    }
+
+    if (LL_TIM_IsEnabledIT_CC1(TIM2) && (TIM2->SR & TIM_SR_CC1IF)) {
+        TIM2->SR = ~TIM_SR_CC1IF;
+        if (Alarm_Armed && MCU_Timebase_Now_Cycles() >= Alarm_At) {
+            Alarm_Armed = false;
+            LL_TIM_DisableIT_CC1(TIM2);
+            due = Alarm_Callback;
+        }
+    }
+
+    __set_PRIMASK(primask);
+
+    if (due != NULL) due();
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+bool MCU_Timebase_Init(void)
+{
+    MCU_Clock_Tree_Info info;
+    MCU_Clock_Tree_Read(&info);
+
+    uint32_t prescaler = prescaler_for(info.timpclk1_hz);
+    if (prescaler == 0) return false;
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+
+    LL_TIM_DisableCounter(TIM2);
+    LL_TIM_SetCounterMode(TIM2, LL_TIM_COUNTERMODE_UP);
+    LL_TIM_SetAutoReload(TIM2, UINT32_MAX);
+    LL_TIM_SetUpdateSource(TIM2, LL_TIM_UPDATESOURCE_COUNTER);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    restart(0, prescaler);
+    LL_TIM_EnableIT_UPDATE(TIM2);
+    LL_TIM_EnableCounter(TIM2);
+
+    __set_PRIMASK(primask);
+
+    NVIC_SetPriority(TIM2_IRQn, MCU_TIMEBASE_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TIM2_IRQn);
+
+    return true;
+};
+
+// ---------------------------------------------------------------------+-
+// A wrap flagged but not yet counted by the interrupt handler is counted
+// here; the counter is then read again, as the first read may have come
+// just before the wrap.
+// ---------------------------------------------------------------------+-
+uint64_t MCU_Timebase_Now_Cycles(void)
+{
+    uint32_t generation;
+    uint64_t base;
+    uint32_t count;
+
+    do {
+        generation = Generation;
+        base       = Base;
+        count      = TIM2->CNT;
+
+        if (TIM2->SR & TIM_SR_UIF) {
+            base  += WRAP_CYCLES;
+            count  = TIM2->CNT;
+        }
+    } while (generation != Generation);
+
+    return base + count;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Timebase_Register_Alarm_Callback(MCU_Timebase_Alarm_Callback callback)
+{
+    Alarm_Callback = callback;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Timebase_Set_Alarm(uint64_t at_cycles)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Alarm_At    = at_cycles;
+    Alarm_Armed = true;
+    arm_compare();
+
+    __set_PRIMASK(primask);
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Timebase_Cancel_Alarm(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Alarm_Armed = false;
+    arm_compare();
+
+    __set_PRIMASK(primask);
+};
@@ -0,0 +1,146 @@
+/*
+================================================================================================#=
+TIMEBASE
+mcu/clock/timebase.h
+
+Description:
+    A free-running, 64-bit, monotonic timebase; for timestamps, profiling
+    and timeouts, in bare-metal and FreeRTOS apps alike.
+
+    TIM2, a 32-bit timer, counts at MCU_TIMEBASE_HZ; its update interrupt,
+    on each wrap, extends the count to 64 bits, which never wraps in
+    practice.  Reading it takes no lock and masks no interrupt: a reader
+    re-reads if the wrap interrupt ran meanwhile, and counts a wrap that
+    is pending but not yet handled, e.g. while interrupts are masked.
+    It may be called from any context, at any priority, once initialized.
+
+    Its counts are cycles of MCU_TIMEBASE_HZ, not of the core clock;
+    for the latter, see the DWT cycle counter, as used by the trace
+    timestamps, which wraps within a minute.
+
+    CLOCK PROFILES
+    The rate holds across a change of clock profile; see clock-profile.h.
+    The timebase subscribes to the changes and re-programs the TIM2
+    prescaler for the new timer clock, which must be a multiple of
+    MCU_TIMEBASE_HZ; every built-in profile is, for the default rate.
+    Until the SYSCLK itself switches, e.g. while the PLL locks, TIM2 still
+    counts at the old rate, correctly.  From then until the subscriber
+    re-programs the prescaler it counts at the new timer clock over the old
+    prescaler: too fast after a rise, too slow after a fall, by the ratio of
+    the two clocks; and a switch from the PLL to the MSI passes through the
+    PLL input clock on the way.  The window holds at most a few hundred core
+    cycles, at the new clock: the lowering of the wait states and voltage
+    range on a fall, and the subscribers registered before the timebase.
+    The error is the window times the ratio less one; e.g. up to a hundred
+    microseconds or so per switch between the 80MHz and 2MHz profiles, and
+    well under ten between the faster ones.
+
+    ALARM
+    A single alarm, on the TIM2 compare channel 1, calls back at a given
+    count; e.g. for the software timers of timer-service.h, its one client.
+    The callback runs in the TIM2 interrupt, at MCU_TIMEBASE_IRQ_PRIORITY.
+
+DEPENDENCIES:
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 or STM32F0 MCU; see timebase-stm32l4.c and timebase-stm32f0.c
+    The STM32F0 has no clock profiles; its rate holds as configured.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// The count rate, in Hz;
+// The default of 2MHz, i.e. 0.5us, suits the 2MHz low-power run profile;
+// an app that never uses it may raise the rate to, e.g., 16MHz.
+// It must be a divisor of the timer clock in each profile used.
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_TIMEBASE_HZ
+#define MCU_TIMEBASE_HZ (2000000ULL)
+#endif
+
+// -----------------------------------------------------------------------------+-
+// MCU_TIMEBASE_IRQ_PRIORITY
+// The priority of the TIM2 interrupt, which counts the wraps and calls
+// back the alarm; any priority will do for the former, since readers count
+// a pending wrap themselves.  Defaults to the lowest.
+// -----------------------------------------------------------------------------+-
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Start the timebase at zero, at MCU_TIMEBASE_HZ from the timer clock now in
+// effect; call it once the clock tree has been configured.
+// Returns false, having started nothing, if the timer clock is not a
+// multiple of MCU_TIMEBASE_HZ.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Timebase_Init(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the cycles since MCU_Timebase_Init(), at MCU_TIMEBASE_HZ;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+uint64_t MCU_Timebase_Now_Cycles(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// The alarm; see above.
+// Set_Alarm() replaces any alarm not yet due; one already due calls back at
+// once.  The alarm is disarmed when it calls back.  Both may be called from
+// any context, including the callback itself.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+typedef void (*MCU_Timebase_Alarm_Callback)(void);
+
+void MCU_Timebase_Register_Alarm_Callback(MCU_Timebase_Alarm_Callback callback);
+void MCU_Timebase_Set_Alarm(uint64_t at_cycles);
+void MCU_Timebase_Cancel_Alarm(void);
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Conversions between cycles and microseconds;
+// Exact, with the remainder truncated, and free of overflow for the
+// range of a uint64_t; with a constant argument, they fold to a constant.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+static inline uint64_t MCU_Timebase_Cycles_To_Micros(uint64_t cycles)
+{
+    return ((cycles / MCU_TIMEBASE_HZ) * 1000000ULL)
+         + (((cycles % MCU_TIMEBASE_HZ) * 1000000ULL) / MCU_TIMEBASE_HZ);
+}
+
+static inline uint64_t MCU_Timebase_Micros_To_Cycles(uint64_t micros)
+{
+    return ((micros / 1000000ULL) * MCU_TIMEBASE_HZ)
+         + (((micros % 1000000ULL) * MCU_TIMEBASE_HZ) / 1000000ULL);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Returns the microseconds since MCU_Timebase_Init();
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+static inline uint64_t MCU_Timebase_Now_Micros(void)
+{
+    return MCU_Timebase_Cycles_To_Micros(MCU_Timebase_Now_Cycles());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Timeouts; e.g.
+//
+//     uint64_t deadline = MCU_Timebase_Deadline_Micros(500);
+//     while (!ready()) {
+//         if (MCU_Timebase_Expired(deadline)) return false;
+//     }
+//
+// A 64-bit count never wraps, so a plain comparison is safe.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+static inline uint64_t MCU_Timebase_Deadline_Micros(uint64_t micros)
+{
+    return MCU_Timebase_Now_Cycles() + MCU_Timebase_Micros_To_Cycles(micros);
+}
+
+static inline bool MCU_Timebase_Expired(uint64_t deadline)
+{
+    return MCU_Timebase_Now_Cycles() >= deadline;
+}
@@ -0,0 +1,359 @@
+
+/*
+================================================================================================#=
+TIMER SERVICE
+mcu/clock/timer-service.c
+
+Description:
+    See timer-service.h for a description of this module.
+
+    Each slot is a doubly linked list of its timers, in no order; a timer
+    goes in the slot of its tick, i.e. its expiry in slot widths, modulo
+    the wheel.  Processed_Tick is the tick of the last alarm handled: no
+    timer in the wheel has an earlier tick, so that, from one alarm to the
+    next, only the slots of the ticks in between need looking through.
+
+    The timers due are moved to a list of their own, with interrupts
+    masked, then called back one by one, unmasked; a timer stopped or
+    re-started in the meantime simply leaves that list.
+
+DEPENDENCIES:
+    mcu/clock/timebase.h;
+    Cortex-M MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/clock/timer-service.h"
+#include "mcu/clock/timebase.h"
+
+#include <stddef.h>
+
+#if defined(MCUFAM_STM32F0)
+    #include "CMSIS/Device/ST/STM32F0xx/Include/stm32f091xc.h"
+#elif defined(MCUFAM_STM32L4)
+    #include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+#else
+    #error "MCU Family Name Not Defined."
+#endif
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+#define SLOT_MASK  (MCU_TIMER_WHEEL_SLOTS - 1U)
+#define DUE_SLOT   (0xFFU)
+#define NO_SLOT    (0xFEU)
+#define NO_ALARM   (UINT64_MAX)
+
+static MCU_Timer *Slots[MCU_TIMER_WHEEL_SLOTS];
+static MCU_Timer *Due = NULL;
+
+static uint64_t Occupied       = 0;
+static uint64_t Processed_Tick = 0;
+static uint64_t Alarm_At       = NO_ALARM;
+
+// All of the above is guarded with PRIMASK rather than BASEPRI, as for the timebase itself.
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+static inline uint64_t tick_of(uint64_t cycles)
+{
+    return cycles >> MCU_TIMER_SLOT_SHIFT;
+}
+
+static inline MCU_Timer **head_of(uint8_t slot)
+{
+    return (slot == DUE_SLOT) ? &Due : &Slots[slot];
+}
+
+// ---------------------------------------------------------------------+-
+// Link a timer into a list, the wheel or the due list, and take it out;
+// to be called with interrupts masked.
+// ---------------------------------------------------------------------+-
+static void link(MCU_Timer *timer, uint8_t slot)
+{
+    MCU_Timer **head = head_of(slot);
+
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL) (*head)->prev = timer;
+    *head = timer;
+
+    if (slot != DUE_SLOT) Occupied |= (1ULL << slot);
+}
+
+static void unlink(MCU_Timer *timer)
+{
+    if (timer->slot == NO_SLOT) return;
+
+    MCU_Timer **head = head_of(timer->slot);
+
+    if (timer->prev != NULL) timer->prev->next = timer->next;
+    else                     *head             = timer->next;
+    if (timer->next != NULL) timer->next->prev = timer->prev;
+
+    if (timer->slot != DUE_SLOT && *head == NULL) Occupied &= ~(1ULL << timer->slot);
+
+    timer->slot = NO_SLOT;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+static void link_into_wheel(MCU_Timer *timer)
+{
+    link(timer, (uint8_t)(tick_of(timer->expiry) & SLOT_MASK));
+}
+
+// ---------------------------------------------------------------------+-
+// The distance, from the given slot, of the next occupied slot at or
+// beyond the given distance; or MCU_TIMER_WHEEL_SLOTS, if none.
+// ---------------------------------------------------------------------+-
+static uint32_t next_occupied(uint32_t from_slot, uint32_t distance)
+{
+    if (distance >= MCU_TIMER_WHEEL_SLOTS) return MCU_TIMER_WHEEL_SLOTS;
+
+    uint64_t rotated = (from_slot == 0)
+                     ? Occupied
+                     : ((Occupied >> from_slot) | (Occupied << (MCU_TIMER_WHEEL_SLOTS - from_slot)));
+
+    rotated &= ~0ULL << distance;
+    return (rotated == 0) ? MCU_TIMER_WHEEL_SLOTS : (uint32_t)__builtin_ctzll(rotated);
+}
+
+// ---------------------------------------------------------------------+-
+// Move the timers due by now from the wheel to the due list;
+// to be called with interrupts masked.
+// ---------------------------------------------------------------------+-
+static void collect_due(uint64_t now)
+{
+    uint64_t now_tick = tick_of(now);
+    uint32_t from     = (uint32_t)(Processed_Tick & SLOT_MASK);
+    uint64_t span     = now_tick - Processed_Tick;
+    uint32_t last     = (span >= MCU_TIMER_WHEEL_SLOTS) ? SLOT_MASK : (uint32_t)span;
+
+    for (uint32_t d = next_occupied(from, 0); d <= last; d = next_occupied(from, d + 1))
+    {
+        MCU_Timer *timer = Slots[(from + d) & SLOT_MASK];
+        while (timer != NULL)
+        {
+            MCU_Timer *next = timer->next;
+            if (timer->expiry <= now) {
+                unlink(timer);
+                link(timer, DUE_SLOT);
+            }
+            timer = next;
+        }
+    }
+
+    Processed_Tick = now_tick;
+}
+
+// ---------------------------------------------------------------------+-
+// Set the alarm for the next occupied slot; see timer-service.h.
+// A slot that holds only timers of later rounds is passed over, if it is
+// the slot of Processed_Tick itself, since its start has gone by.
+// To be called with interrupts masked.
+// ---------------------------------------------------------------------+-
+static void rearm(void)
+{
+    uint32_t from = (uint32_t)(Processed_Tick & SLOT_MASK);
+
+    for (uint32_t d = next_occupied(from, 0); d < MCU_TIMER_WHEEL_SLOTS; d = next_occupied(from, d + 1))
+    {
+        uint64_t tick     = Processed_Tick + d;
+        uint64_t earliest = NO_ALARM;
+
+        for (MCU_Timer *timer = Slots[(from + d) & SLOT_MASK]; timer != NULL; timer = timer->next) {
+            if (tick_of(timer->expiry) == tick && timer->expiry < earliest) earliest = timer->expiry;
+        }
+
+        if (earliest != NO_ALARM) {
+            Alarm_At = earliest;
+            MCU_Timebase_Set_Alarm(Alarm_At);
+            return;
+        }
+        if (d > 0) {
+            Alarm_At = tick << MCU_TIMER_SLOT_SHIFT;
+            MCU_Timebase_Set_Alarm(Alarm_At);
+            return;
+        }
+    }
+
+    if (Occupied != 0) {
+        Alarm_At = (Processed_Tick + MCU_TIMER_WHEEL_SLOTS) << MCU_TIMER_SLOT_SHIFT;
+        MCU_Timebase_Set_Alarm(Alarm_At);
+        return;
+    }
+
+    Alarm_At = NO_ALARM;
+    MCU_Timebase_Cancel_Alarm();
+}
+
+// ---------------------------------------------------------------------+-
+// Start a timer at the given expiry and period, in cycles;
+// ---------------------------------------------------------------------+-
+static void start(MCU_Timer *timer, uint64_t delay_cycles, uint64_t period_cycles)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    unlink(timer);
+    timer->expiry = MCU_Timebase_Now_Cycles() + delay_cycles;
+    timer->period = period_cycles;
+    timer->active = true;
+    link_into_wheel(timer);
+
+    if (timer->expiry < Alarm_At) {
+        Alarm_At = timer->expiry;
+        MCU_Timebase_Set_Alarm(Alarm_At);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+// ---------------------------------------------------------------------+-
+// The timebase alarm callback; in the TIM2 interrupt.
+// ---------------------------------------------------------------------+-
+static void timer_alarm(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t now     = MCU_Timebase_Now_Cycles();
+
+    Alarm_At = NO_ALARM;
+    collect_due(now);
+
+    while (Due != NULL)
+    {
+        MCU_Timer *timer = Due;
+        unlink(timer);
+
+        if (timer->period != 0) {
+            timer->expiry += timer->period;
+            if (timer->expiry <= now) {
+                timer->expiry += ((now - timer->expiry) / timer->period + 1U) * timer->period;
+            }
+            link_into_wheel(timer);
+        }
+        else {
+            timer->active = false;
+        }
+
+        MCU_Timer_Callback callback = timer->callback;
+        void              *context  = timer->context;
+
+        __set_PRIMASK(primask);
+        if (callback != NULL) callback(context);
+        primask = __get_PRIMASK();
+        __disable_irq();
+    }
+
+    rearm();
+    __set_PRIMASK(primask);
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Timer_Service_Init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Processed_Tick = tick_of(MCU_Timebase_Now_Cycles());
+    MCU_Timebase_Register_Alarm_Callback(timer_alarm);
+
+    __set_PRIMASK(primask);
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Timer_Init(MCU_Timer *timer, MCU_Timer_Callback callback, void *context)
+{
+    timer->next     = NULL;
+    timer->prev     = NULL;
+    timer->expiry   = 0;
+    timer->period   = 0;
+    timer->callback = callback;
+    timer->context  = context;
+    timer->slot     = NO_SLOT;
+    timer->active   = false;
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Timer_Start_Once(MCU_Timer *timer, uint64_t delay_us)
+{
+    start(timer, MCU_Timebase_Micros_To_Cycles(delay_us), 0);
+};
+
+// ---------------------------------------------------------------------+-
+// A period shorter than a cycle is made one cycle.
+// ---------------------------------------------------------------------+-
+void MCU_Timer_Start_Periodic(MCU_Timer *timer, uint64_t period_us)
+{
+    uint64_t period = MCU_Timebase_Micros_To_Cycles(period_us);
+    if (period == 0) period = 1;
+
+    start(timer, period, period);
+};
+
+// ---------------------------------------------------------------------+-
+// The alarm is left as it is; should it find nothing due, it re-arms.
+// ---------------------------------------------------------------------+-
+void MCU_Timer_Stop(MCU_Timer *timer)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    unlink(timer);
+    timer->active = false;
+
+    __set_PRIMASK(primask);
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+bool MCU_Timer_Is_Active(const MCU_Timer *timer)
+{
+    return timer->active;
+};
+
+// ---------------------------------------------------------------------+-
+// The check and the WFI are made with interrupts masked, so that the
+// timer cannot expire in between; a pending interrupt still ends the WFI,
+// and is served as soon as they are unmasked.
+// ---------------------------------------------------------------------+-
+void MCU_Timer_Delay_Us(uint64_t micros)
+{
+    MCU_Timer timer;
+
+    MCU_Timer_Init(&timer, NULL, NULL);
+    MCU_Timer_Start_Once(&timer, micros);
+
+    for (;;)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (!timer.active) {
+            __set_PRIMASK(primask);
+            break;
+        }
+        __WFI();
+        __set_PRIMASK(primask);
+    }
+};
+
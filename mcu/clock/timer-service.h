@@ -0,0 +1,114 @@
+/*
+================================================================================================#=
+TIMER SERVICE
+mcu/clock/timer-service.h
+
+Description:
+    Software timers, one-shot and periodic, at microsecond resolution;
+    any number of them multiplexed onto the single alarm of the timebase.
+
+    The timers live in a hashed timing wheel of MCU_TIMER_WHEEL_SLOTS
+    slots, each a list of the timers that expire within one slot width,
+    at that position of the wheel, in this or a later round.  Starting and
+    stopping a timer is O(1): a link into, or out of, a slot list.
+    A bitmap of the occupied slots leads straight to the next of them.
+
+    The alarm is set at the earliest expiry in the next occupied slot;
+    or at the start of that slot, if it holds only timers of later rounds.
+    Timers are therefore exact to a timebase cycle, not to a slot width;
+    the slot width bounds only the work per alarm.
+
+    The callbacks run in the TIM2 interrupt, at MCU_TIMEBASE_IRQ_PRIORITY;
+    see timebase.h.  A periodic timer is re-started, a period after it was
+    due, before its callback runs; one late by more than a period skips
+    the periods missed rather than calling back for each.  A callback may
+    start and stop timers, its own included.
+
+    The timers are the caller's to allocate, statically or otherwise, and
+    must stay put while active.  The fields of an MCU_Timer are private.
+
+DEPENDENCIES:
+    mcu/clock/timebase.h; initialized before this service;
+    Cortex-M MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// The slot width is 2^MCU_TIMER_SLOT_SHIFT timebase cycles;
+// The default of 2^14 cycles at 2MHz is some 8ms, for a wheel of some 0.5s.
+// Narrower slots mean fewer timers to look through per alarm, and more
+// alarms, at the start of each occupied slot, for timers of later rounds.
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_TIMER_SLOT_SHIFT
+#define MCU_TIMER_SLOT_SHIFT (14U)
+#endif
+
+// The slots, one per bit of the occupancy bitmap;
+#define MCU_TIMER_WHEEL_SLOTS (64U)
+
+
+// -----------------------------------------------------------------------------+-
+// A timer;
+// -----------------------------------------------------------------------------+-
+typedef void (*MCU_Timer_Callback)(void *context);
+
+typedef struct MCU_Timer
+{
+    struct MCU_Timer   *next;
+    struct MCU_Timer   *prev;
+    uint64_t            expiry;     // In timebase cycles;
+    uint64_t            period;     // In timebase cycles; zero for a one-shot;
+    MCU_Timer_Callback  callback;
+    void               *context;
+    uint8_t             slot;
+    volatile bool       active;
+} MCU_Timer;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Take over the timebase alarm; call it once, after MCU_Timebase_Init().
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Timer_Service_Init(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Prepare a timer, stopped, with the given callback and its context;
+// The callback may be NULL; e.g. for a timer that is only polled.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Timer_Init(MCU_Timer *timer, MCU_Timer_Callback callback, void *context);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// (Re)start a timer, to call back once, or every period, from now;
+// A timer already active is re-started; it does not call back for the
+// old start.  These, and the two below, may be called from any context.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Timer_Start_Once(MCU_Timer *timer, uint64_t delay_us);
+void MCU_Timer_Start_Periodic(MCU_Timer *timer, uint64_t period_us);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Stop a timer; it does not call back, unless its callback runs already.
+// Stopping a timer that is not active does nothing.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Timer_Stop(MCU_Timer *timer);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// True from a start until a one-shot calls back, or the timer is stopped.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Timer_Is_Active(const MCU_Timer *timer);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Sleep, in WFI, for the given microseconds; in place of a busy-wait loop.
+// Other interrupts are served meanwhile.  For thread mode, or for an
+// interrupt of lower priority than MCU_TIMEBASE_IRQ_PRIORITY; not for a
+// FreeRTOS task, which should use vTaskDelay().
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Timer_Delay_Us(uint64_t micros);
+
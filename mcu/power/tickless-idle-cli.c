@@ -0,0 +1,106 @@
+
+/*
+================================================================================================#=
+Tickless Idle CLI
+
+See tickless-idle-cli.h for a description of this module.
+================================================================================================#=
+*/
+
+#include "mcu/power/tickless-idle-cli.h"
+#include "mcu/power/tickless-idle.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "platform/cli/cli-cmd.h"
+
+
+// -----------------------------------------------------------------------------+-
+// The LPTIM1 counts in microseconds;
+// -----------------------------------------------------------------------------+-
+static unsigned long counts_to_us(uint32_t counts, uint32_t lptim_hz)
+{
+    if (lptim_hz == 0) return 0;
+    return (unsigned long)(((uint64_t)counts * 1000000ULL) / lptim_hz);
+}
+
+// -----------------------------------------------------------------------------+-
+// tickless
+// -----------------------------------------------------------------------------+-
+static void tickless_show(void)
+{
+    MCU_Tickless_Stats stats;
+    MCU_Tickless_Get_Stats(&stats);
+
+    if (stats.lptim_hz == 0) {
+        CLI_CMD_Printf("tickless: not running; neither LSE nor LSI started\n");
+        return;
+    }
+
+    CLI_CMD_Printf("LPTIM1   %lu Hz, from the %s\n",
+        (unsigned long)stats.lptim_hz, (stats.lptim_hz == 32768UL) ? "LSE" : "LSI");
+    CLI_CMD_Printf("sleeps   %lu in Stop 2, %lu in Sleep; %lu aborted\n",
+        (unsigned long)stats.stop_sleeps, (unsigned long)stats.sleep_sleeps, (unsigned long)stats.aborted);
+    CLI_CMD_Printf("slept    %lu ticks\n", (unsigned long)stats.ticks_slept);
+    CLI_CMD_Printf("latency  last %lu us, max %lu us\n",
+        counts_to_us(stats.latency_last, stats.lptim_hz), counts_to_us(stats.latency_max, stats.lptim_hz));
+    CLI_CMD_Printf("drift    %ld us\n", (long)stats.drift_us);
+}
+
+// -----------------------------------------------------------------------------+-
+// tickless [clear | stop <secs> | stop off]
+// -----------------------------------------------------------------------------+-
+static void tickless_cmd(int argc, char *argv[])
+{
+    if (argc == 1) {
+        tickless_show();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        MCU_Tickless_Clear_Stats();
+        CLI_CMD_Printf("tickless: cleared\n");
+        return;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "stop") == 0)
+    {
+        if (strcmp(argv[2], "off") == 0) {
+            MCU_Tickless_Allow_Stop(false, 0);
+            CLI_CMD_Printf("tickless: Sleep mode only\n");
+            return;
+        }
+
+        char         *end;
+        unsigned long secs = strtoul(argv[2], &end, 10);
+
+        if (*end == '\0') {
+            if (secs == 0) CLI_CMD_Printf("tickless: Stop 2 allowed for ever\n");
+            else           CLI_CMD_Printf("tickless: Stop 2 allowed for %lu s\n", secs);
+            MCU_Tickless_Allow_Stop(true, (uint32_t)(secs * configTICK_RATE_HZ));
+            return;
+        }
+    }
+
+    CLI_CMD_Printf("usage: tickless [clear | stop <secs> | stop off]\n");
+}
+
+static const CLI_CMD_Descriptor Tickless_Cmd = {
+    .name    = "tickless",
+    .help    = "show the tickless idle measurements, or allow Stop 2",
+    .handler = tickless_cmd,
+};
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void MCU_Tickless_CLI_Init(void)
+{
+    CLI_CMD_Register(&Tickless_Cmd);
+}
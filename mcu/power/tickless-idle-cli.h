@@ -0,0 +1,22 @@
+
+/*
+================================================================================================#=
+Tickless Idle CLI
+
+Provides the 'tickless' command to show the tickless idle measurements
+of tickless-idle.h, and to allow Stop 2, from the command line interface.
+
+    tickless                show the sleeps, the ticks slept, the wake-up latency and the drift
+    tickless clear          clear the measurements; the drift starts again from zero
+    tickless stop <secs>    allow Stop 2 for so many seconds; 0 for ever
+    tickless stop off       sleep in Sleep mode only
+
+The CLI USART cannot wake the MCU from Stop 2; while it is allowed, the
+CLI hears nothing.  Hence the seconds, after which it hears again.
+================================================================================================#=
+*/
+
+#pragma once
+
+// Register the 'tickless' command with the CLI;
+void MCU_Tickless_CLI_Init(void);
@@ -0,0 +1,442 @@
+
+/*
+================================================================================================#=
+TICKLESS IDLE
+mcu/power/tickless-idle-stm32l4.c
+
+Description:
+    The STM32L4 implementation of tickless-idle.h;
+    see that file for a description of this module.
+
+    LPTIM1 counts up, continuously, from 0 to 0xFFFF; the compare is set
+    for each sleep, and stays where it was in between, matching harmlessly
+    once a round.  Its updates take effect at once (PRELOAD clear), and
+    each is complete only once CMPOK is set, some two LPTIM1 counts later.
+    The counter runs on a clock of its own, and must be read twice, alike,
+    to be sure of it.
+
+    The wraps are counted from the autoreload match, i.e. as the counter
+    reaches 0xFFFF; the extended count is therefore that of the counter
+    plus one.  The interrupt of each match wakes the MCU, once a round;
+    a sleep across it simply goes on in another.
+
+DEPENDENCIES:
+    FreeRTOS;
+    mcu/clock/clock-profile.h
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU;
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include "mcu/power/tickless-idle.h"
+#include "mcu/clock/clock-profile.h"
+#include "mcu/clock/clock-tree-default-config.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "CMSIS/Device/ST/STM32L4xx/Include/stm32l4xx.h"
+
+// STM32 Low Level Drivers
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_bus.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_exti.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_lptim.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_pwr.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_rcc.h"
+#include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_utils.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+#define LSE_HZ                (32768UL)
+#define LSI_HZ                (32000UL)
+
+#define LSI_START_TIMEOUT_MS  (10UL)
+
+#define COUNTER_MASK          (0xFFFFUL)
+#define COUNTER_ROUND         (0x10000ULL)
+
+// The longest sleep, in counts; short of a round, with room for the latency.
+#define MAX_SLEEP_COUNTS      (0xFF00UL)
+
+// The shortest, in counts; the compare must be set before the counter gets there.
+#define MIN_SLEEP_COUNTS      (4UL)
+
+static bool              Ready    = false;
+static uint32_t          Lptim_Hz = 0;
+static volatile uint32_t Wraps    = 0;
+
+// The fraction of a cycle carried from one sleep to the next, in 1/Lptim_Hz;
+static uint64_t          Cycle_Fraction = 0;
+
+static bool              Stop_Allowed = (MCU_TICKLESS_STOP_DEFAULT != 0);
+static bool              Stop_Forever = true;
+static TickType_t        Stop_Until   = 0;
+
+// The reference for the drift; the tick count and extended count at clear.
+static TickType_t        Ref_Ticks = 0;
+static uint64_t          Ref_Count = 0;
+
+static MCU_Tickless_Stats Stats;
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// Start the LSI; false if not ready in time.
+// For the LSE, see clock-tree-default-config.h
+// ---------------------------------------------------------------------+-
+static bool start_lsi(void)
+{
+    LL_RCC_LSI_Enable();
+
+    for (uint32_t ms = 0; ms < LSI_START_TIMEOUT_MS; ms++) {
+        if (LL_RCC_LSI_IsReady()) return true;
+        LL_mDelay(1);
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------+-
+// The counter, read twice alike;
+// ---------------------------------------------------------------------+-
+static uint32_t read_counter(void)
+{
+    uint32_t first;
+    uint32_t second;
+
+    do {
+        first  = LPTIM1->CNT;
+        second = LPTIM1->CNT;
+    } while (first != second);
+
+    return first & COUNTER_MASK;
+}
+
+// ---------------------------------------------------------------------+-
+// The counter, as soon as it changes; i.e. just after an edge.
+// ---------------------------------------------------------------------+-
+static uint32_t read_counter_at_edge(void)
+{
+    uint32_t before = read_counter();
+    uint32_t after;
+
+    do {
+        after = read_counter();
+    } while (after == before);
+
+    return after;
+}
+
+// ---------------------------------------------------------------------+-
+// The extended count; see above.  A wrap flagged but not yet counted is
+// counted here, and the counter read again; to be called masked.
+// ---------------------------------------------------------------------+-
+static uint64_t extended_count(void)
+{
+    uint64_t wraps = Wraps;
+    uint32_t count = read_counter();
+
+    if (LPTIM1->ISR & LPTIM_ISR_ARRM) {
+        wraps += 1U;
+        count  = read_counter();
+    }
+
+    return (wraps * COUNTER_ROUND) + ((count + 1U) & COUNTER_MASK);
+}
+
+// ---------------------------------------------------------------------+-
+// Set the compare, and wait for the update to complete;
+// ---------------------------------------------------------------------+-
+static void set_compare(uint32_t value)
+{
+    LPTIM1->ICR = LPTIM_ICR_CMPOKCF;
+    LL_LPTIM_SetCompare(LPTIM1, value & COUNTER_MASK);
+    while ((LPTIM1->ISR & LPTIM_ISR_CMPOK) == 0) {};
+    LPTIM1->ICR = LPTIM_ICR_CMPOKCF | LPTIM_ICR_CMPMCF;
+}
+
+// ---------------------------------------------------------------------+-
+// Whether to sleep in Stop 2; if only for a while, the sleep ends with it.
+// ---------------------------------------------------------------------+-
+static bool stop_allowed(TickType_t now, uint32_t *expected_idle_ticks)
+{
+    if (!Stop_Allowed) return false;
+    if (Stop_Forever)  return true;
+
+    TickType_t left = Stop_Until - now;
+    if ((int32_t)left <= 0) {
+        Stop_Allowed = false;
+        return false;
+    }
+
+    if (*expected_idle_ticks > left) *expected_idle_ticks = left;
+    return true;
+}
+
+
+
+// =============================================================================================#=
+// Interrupt Handler
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// LPTIM1 reached 0xFFFF, or the compare; the latter only ends a sleep.
+// ---------------------------------------------------------------------+-
+void LPTIM1_IRQHandler(void)
+{
+    uint32_t isr = LPTIM1->ISR;
+
+    if (isr & LPTIM_ISR_ARRM) {
+        LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+        Wraps = Wraps + 1U;
+    }
+    if (isr & LPTIM_ISR_CMPM) {
+        LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    }
+}
+
+
+
+// =============================================================================================#=
+// Public API Services
+// =============================================================================================#=
+
+// ---------------------------------------------------------------------+-
+// The interrupt enables may only change while LPTIM1 is disabled, and the
+// autoreload and compare only while it is enabled.
+// EXTI line 32, of LPTIM1, is the one that wakes the MCU from Stop.
+// ---------------------------------------------------------------------+-
+bool MCU_Tickless_Init(void)
+{
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_PWR);
+
+    if (MCU_Clock_LSE_Start()) {
+        Lptim_Hz = LSE_HZ;
+        LL_RCC_SetLPTIMClockSource(LL_RCC_LPTIM1_CLKSOURCE_LSE);
+    }
+    else if (start_lsi()) {
+        Lptim_Hz = LSI_HZ;
+        LL_RCC_SetLPTIMClockSource(LL_RCC_LPTIM1_CLKSOURCE_LSI);
+    }
+    else {
+        return false;
+    }
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_LPTIM1);
+
+    LL_LPTIM_Disable(LPTIM1);
+    LL_LPTIM_SetClockSource(LPTIM1, LL_LPTIM_CLK_SOURCE_INTERNAL);
+    LL_LPTIM_SetPrescaler(LPTIM1, LL_LPTIM_PRESCALER_DIV1);
+    LL_LPTIM_SetUpdateMode(LPTIM1, LL_LPTIM_UPDATE_MODE_IMMEDIATE);
+    LL_LPTIM_TrigSw(LPTIM1);
+    LPTIM1->IER = LPTIM_IER_ARRMIE | LPTIM_IER_CMPMIE;
+
+    LL_LPTIM_Enable(LPTIM1);
+
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+    LL_LPTIM_SetAutoReload(LPTIM1, COUNTER_MASK);
+    while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0) {};
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+
+    set_compare(COUNTER_MASK);
+    LL_LPTIM_StartCounter(LPTIM1, LL_LPTIM_OPERATING_MODE_CONTINUOUS);
+
+    LL_EXTI_EnableIT_32_63(LL_EXTI_LINE_32);
+
+    NVIC_SetPriority(LPTIM1_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+    NVIC_EnableIRQ(LPTIM1_IRQn);
+
+    Ready = true;
+    MCU_Tickless_Clear_Stats();
+    return true;
+};
+
+// ---------------------------------------------------------------------+-
+// With interrupts masked by PRIMASK, the interrupt that wakes the MCU
+// stays pending until the ticks have been stepped over; BASEPRI, as the
+// kernel masks, would not let it wake the MCU at all.
+//
+// The SysTick had 'left' cycles to go to its next tick when stopped;
+// the sleep is set to end at the tick at which the next task is due.
+// ---------------------------------------------------------------------+-
+void MCU_Tickless_Sleep(uint32_t expected_idle_ticks)
+{
+    if (!Ready) return;
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        Stats.aborted++;
+        __enable_irq();
+        return;
+    }
+
+    bool stop = stop_allowed(xTaskGetTickCount(), &expected_idle_ticks);
+
+    uint32_t core_hz  = SystemCoreClock;
+    uint32_t per_tick = SysTick->LOAD + 1UL;
+
+    // Start on an LPTIM1 edge, with the SysTick stopped;
+    uint32_t start       = read_counter_at_edge();
+    uint32_t start_cycle = DWT->CYCCNT;
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    uint32_t left = SysTick->VAL;
+
+    // A tick due already is counted first, by the SysTick handler;
+    if (left == 0 || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        Stats.aborted++;
+        __enable_irq();
+        return;
+    }
+
+    uint64_t target_cycles = (uint64_t)left + ((uint64_t)(expected_idle_ticks - 1U) * per_tick);
+    uint64_t target_counts = (target_cycles * Lptim_Hz) / core_hz;
+
+    if (target_counts > MAX_SLEEP_COUNTS) target_counts = MAX_SLEEP_COUNTS;
+
+    if (target_counts < MIN_SLEEP_COUNTS + MCU_TICKLESS_WAKEUP_COUNTS) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        Stats.aborted++;
+        __enable_irq();
+        return;
+    }
+
+    uint32_t wake = start + (uint32_t)target_counts - MCU_TICKLESS_WAKEUP_COUNTS;
+    set_compare(wake);
+
+    if (stop) {
+        MCU_Clock_Prepare_Stop();
+        LL_PWR_SetPowerMode(LL_PWR_MODE_STOP2);
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    }
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    if (stop) {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        MCU_Clock_Resume_From_Stop();
+    }
+
+    // End on an edge; the counts slept, then the cycles;
+    uint32_t end       = read_counter_at_edge();
+    uint32_t end_cycle = DWT->CYCCNT;
+    uint32_t counts    = (end - start) & COUNTER_MASK;
+
+    uint64_t scaled  = ((uint64_t)counts * core_hz) + Cycle_Fraction;
+    uint64_t elapsed = scaled / Lptim_Hz;
+    Cycle_Fraction   = scaled % Lptim_Hz;
+
+    // The ticks that went by, and what is left of the one under way;
+    uint32_t ticks;
+    uint32_t left_now;
+
+    if (elapsed < left) {
+        ticks    = 0;
+        left_now = left - (uint32_t)elapsed;
+    }
+    else {
+        uint64_t after = elapsed - left;
+        ticks    = 1U + (uint32_t)(after / per_tick);
+        left_now = per_tick - (uint32_t)(after % per_tick);
+    }
+
+    // No further than the task due; its tick comes from the SysTick, at once;
+    if (ticks >= expected_idle_ticks) {
+        ticks    = expected_idle_ticks - 1U;
+        left_now = 1U;
+    }
+
+    SysTick->LOAD = ((left_now > 1U) ? left_now : 2U) - 1U;
+    SysTick->VAL  = 0UL;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = per_tick - 1UL;
+
+    if (ticks > 0) vTaskStepTick(ticks);
+
+    // The cycle counter stood still for the time asleep;
+    uint32_t awake = end_cycle - start_cycle;
+    if (elapsed > awake) DWT->CYCCNT += (uint32_t)(elapsed - awake);
+
+    if (stop) Stats.stop_sleeps++;
+    else      Stats.sleep_sleeps++;
+    Stats.ticks_slept += ticks;
+
+    if (counts >= (uint32_t)target_counts - MCU_TICKLESS_WAKEUP_COUNTS) {
+        Stats.latency_last = (end - wake) & COUNTER_MASK;
+        if (Stats.latency_last > Stats.latency_max) Stats.latency_max = Stats.latency_last;
+    }
+
+    __enable_irq();
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Tickless_Allow_Stop(bool allow, uint32_t ticks)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Stop_Allowed = allow;
+    Stop_Forever = (ticks == 0);
+    Stop_Until   = xTaskGetTickCount() + ticks;
+
+    __set_PRIMASK(primask);
+};
+
+// ---------------------------------------------------------------------+-
+// The tick count lags the time by the part of a tick under way, so that
+// the drift reads up to a tick behind.
+// ---------------------------------------------------------------------+-
+void MCU_Tickless_Get_Stats(MCU_Tickless_Stats *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *stats = Stats;
+
+    if (Ready)
+    {
+        uint64_t ticks  = (uint64_t)(TickType_t)(xTaskGetTickCount() - Ref_Ticks);
+        uint64_t counts = extended_count() - Ref_Count;
+
+        int64_t tick_us  = (int64_t)((ticks  * 1000000ULL) / configTICK_RATE_HZ);
+        int64_t count_us = (int64_t)((counts * 1000000ULL) / Lptim_Hz);
+
+        stats->drift_us = (int32_t)(tick_us - count_us);
+    }
+
+    __set_PRIMASK(primask);
+};
+
+// ---------------------------------------------------------------------+-
+// ---------------------------------------------------------------------+-
+void MCU_Tickless_Clear_Stats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Stats          = (MCU_Tickless_Stats){ 0 };
+    Stats.lptim_hz = Lptim_Hz;
+
+    if (Ready) {
+        Ref_Ticks = xTaskGetTickCount();
+        Ref_Count = extended_count();
+    }
+
+    __set_PRIMASK(primask);
+};
+
@@ -0,0 +1,125 @@
+/*
+================================================================================================#=
+TICKLESS IDLE
+mcu/power/tickless-idle.h
+
+Description:
+    The FreeRTOS tickless idle, on LPTIM1; the MCU sleeps, in Stop 2 where
+    allowed, through the ticks in which no task is due to run, rather than
+    waking a thousand times a second for the SysTick.
+
+    FreeRTOSConfig.h maps portSUPPRESS_TICKS_AND_SLEEP() here, with
+    configUSE_TICKLESS_IDLE set to 2, i.e. an implementation of the port's
+    own.  The idle task calls it when the next task is at least
+    configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks away.
+
+    LPTIM1 counts LSE cycles, at 32768Hz, or LSI cycles, at 32kHz, if the
+    LSE does not start.  It runs all the time, in Run, Sleep and Stop 2
+    alike; the SysTick still makes the ticks while the CPU is awake.
+    To sleep, the SysTick stops, and the LPTIM1 compare is set for the tick
+    at which the next task is due; on waking, for that or any other reason,
+    the ticks slept are counted from LPTIM1 and stepped over at once, and
+    the SysTick resumes with what was left of its tick.  The sleep starts
+    and ends on an LPTIM1 edge, so that no fraction of a count is lost, and
+    the time slept accumulates without drift against LPTIM1.
+
+    The counter is 16 bits; one sleep lasts at most two seconds, after which
+    the idle task simply sleeps again.
+
+    STOP 2
+    In Stop 2, all clocks but LSE and LSI stop; the MCU wakes on the MSI, or
+    the HSI16, and the clock profile starts the PLL again, if it uses it;
+    see MCU_Clock_Resume_From_Stop() of clock-profile.h.  That restart, with
+    the wake-up itself, is the wake-up latency measured below.
+    Only EXTI lines, and the few peripherals with a clock of their own, wake
+    the MCU from Stop 2; e.g. LPTIM1, LPUART1, RTC and a GPIO edge.  The
+    USARTs, TIM2 and so the timebase stop; while any of them matters, Stop 2
+    must not be allowed.  Where not allowed, the sleep is in Sleep mode,
+    still tickless.  A debugger loses the MCU in Stop 2 unless DBGMCU_CR
+    DBG_STOP is set.
+
+    The DWT cycle counter stops while the MCU sleeps, in either mode; it is
+    advanced by the cycles slept on waking, so that the trace timestamps,
+    the run time statistics and the CPU load, which count on it, take the
+    sleep for idle time, as it is.
+
+    MEASUREMENTS
+    The number of sleeps and the ticks slept; the wake-up latency, from the
+    LPTIM1 compare to the SysTick resumed, in LPTIM1 counts, for the sleeps
+    that ended on it; and the drift, between the tick count and LPTIM1,
+    since MCU_Tickless_Init().  The drift should stay within a tick, less
+    the error of the LSE, or LSI, which is its reference.
+
+DEPENDENCIES:
+    FreeRTOS; the Cortex-M4F port, with configUSE_TICKLESS_IDLE set to 2;
+    mcu/clock/clock-profile.h
+    STM32 Cube HAL Low Level Drivers;
+    STM32L4 MCU; see tickless-idle-stm32l4.c
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// -----------------------------------------------------------------------------+-
+// BUILD-TIME CONFIGURATION
+// Whether Stop 2 is allowed from init; see MCU_Tickless_Allow_Stop().
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_TICKLESS_STOP_DEFAULT
+#define MCU_TICKLESS_STOP_DEFAULT (0)
+#endif
+
+// The LPTIM1 counts, by which the compare is set early, to allow for the
+// wake-up latency; some 60us, i.e. a Stop 2 wake-up and a PLL lock.
+#ifndef MCU_TICKLESS_WAKEUP_COUNTS
+#define MCU_TICKLESS_WAKEUP_COUNTS (2U)
+#endif
+
+// -----------------------------------------------------------------------------+-
+// The measurements; see above.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t  lptim_hz;             // 32768 for the LSE, 32000 for the LSI;
+    uint32_t  stop_sleeps;          // Sleeps in Stop 2;
+    uint32_t  sleep_sleeps;         // Sleeps in Sleep mode;
+    uint32_t  aborted;              // Sleeps not taken, as a task became ready;
+    uint64_t  ticks_slept;          // Ticks stepped over;
+    uint32_t  latency_last;         // Wake-up latency, in LPTIM1 counts;
+    uint32_t  latency_max;
+    int32_t   drift_us;             // Tick count ahead (+) of LPTIM1, in us;
+
+}   MCU_Tickless_Stats;
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Start the LSE, or the LSI, and LPTIM1 on it; call it once, before the
+// scheduler starts.
+// Returns false if neither oscillator starts; the idle then never sleeps.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+bool MCU_Tickless_Init(void);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// portSUPPRESS_TICKS_AND_SLEEP(); for the idle task alone.
+// The expected idle time is a TickType_t, i.e. 32 bits.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Tickless_Sleep(uint32_t expected_idle_ticks);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Allow Stop 2, or not, for the given ticks from now; zero for ever.
+// When they are up, the MCU wakes and sleeps in Sleep mode from then on;
+// e.g. so that a CLI, whose USART cannot wake it, may be heard again.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Tickless_Allow_Stop(bool allow, uint32_t ticks);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Get, and clear, the measurements; clearing restarts the drift as well.
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void MCU_Tickless_Get_Stats(MCU_Tickless_Stats *stats);
+void MCU_Tickless_Clear_Stats(void);
+
@@ -0,0 +1,92 @@
+
+/*
+================================================================================================#=
+Interrupt Statistics CLI
+
+See irq-stat-cli.h for a description of this module.
+================================================================================================#=
+*/
+
+#include "mcu/vtor/irq-stat-cli.h"
+#include "mcu/vtor/irq-stat.h"
+
+#include <string.h>
+
+#include "platform/cli/cli-cmd.h"
+#include "stm32l4xx.h"
+
+
+// -----------------------------------------------------------------------------+-
+// Show one line per handler; times are in cycles;
+// -----------------------------------------------------------------------------+-
+static void irqstat_show(void)
+{
+    IRQSTAT_Stats stats;
+
+    if (!IRQSTAT_Get(0, &stats)) {
+        CLI_CMD_Printf("irqstat: nothing recorded; is the build configured with IRQSTAT_ENABLE=1?\n");
+        return;
+    }
+
+    CLI_CMD_Printf("  %-20s %4s %8s %6s %6s %6s  %6s %6s  (cycles; %lu per us)\n",
+        "handler", "irq", "count", "last", "avg", "max", "lat", "latmax",
+        (unsigned long)(SystemCoreClock / 1000000U)
+    );
+
+    for (uint32_t slot=0; IRQSTAT_Get(slot, &stats); slot++)
+    {
+        uint32_t avg     = stats.count ? (uint32_t)(stats.total_cycles / stats.count) : 0;
+        uint32_t lat_avg = stats.latency_count ? (uint32_t)(stats.total_latency / stats.latency_count) : 0;
+
+        CLI_CMD_Printf("  %-20s %4ld %8lu %6lu %6lu %6lu",
+            stats.name,
+            (long)stats.exception - 16,
+            (unsigned long)stats.count,
+            (unsigned long)stats.last_cycles,
+            (unsigned long)avg,
+            (unsigned long)stats.max_cycles
+        );
+        if (stats.latency_count) {
+            CLI_CMD_Printf("  %6lu %6lu\n", (unsigned long)lat_avg, (unsigned long)stats.max_latency);
+        }
+        else {
+            CLI_CMD_Printf("  %6s %6s\n", "-", "-");
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// irqstat [clear]
+// -----------------------------------------------------------------------------+-
+static void irqstat_cmd(int argc, char *argv[])
+{
+    if (argc == 1) {
+        irqstat_show();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        IRQSTAT_Clear();
+        return;
+    }
+
+    CLI_CMD_Printf("usage: irqstat [clear]\n");
+}
+
+static const CLI_CMD_Descriptor Irqstat_Cmd = {
+    .name    = "irqstat",
+    .help    = "show interrupt handler times and latencies",
+    .handler = irqstat_cmd,
+};
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void IRQSTAT_CLI_Init(void)
+{
+    CLI_CMD_Register(&Irqstat_Cmd);
+}
@@ -0,0 +1,17 @@
+
+/*
+================================================================================================#=
+Interrupt Statistics CLI
+
+Provides the 'irqstat' command to show the interrupt statistics
+collected by irq-stat.h from the command line interface.
+
+    irqstat          show the execution time and entry latency of each wrapped handler
+    irqstat clear    clear the statistics
+================================================================================================#=
+*/
+
+#pragma once
+
+// Register the 'irqstat' command with the CLI;
+void IRQSTAT_CLI_Init(void);
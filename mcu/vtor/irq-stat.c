@@ -0,0 +1,122 @@
+
+/*
+================================================================================================#=
+Interrupt Statistics
+
+See irq-stat.h for a description of this module.
+
+The time charged to a handler excludes the time of the wrapped handlers that
+preempted it.  To that end IRQSTAT_Nested_Cycles accumulates the exclusive
+time of every handler as it exits; the growth of that total between the entry
+and exit of a handler is exactly the time spent in the handlers nested within it.
+================================================================================================#=
+*/
+
+#include "mcu/vtor/irq-stat.h"
+
+#include <string.h>
+
+
+// -----------------------------------------------------------------------------+-
+// Private Internal Data
+// -----------------------------------------------------------------------------+-
+volatile uint32_t IRQSTAT_Nested_Cycles = 0;
+
+static IRQSTAT_Stats Slots[IRQSTAT_MAX_SLOTS];
+static uint32_t      Slot_Count = 0;
+
+// Slot number plus one of each exception number; zero if none yet;
+static uint8_t       Slot_Of[IRQSTAT_NUM_EXCEPTIONS];
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void IRQSTAT_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(Slots,   0, sizeof(Slots));
+    memset(Slot_Of, 0, sizeof(Slot_Of));
+    Slot_Count = 0;
+    __set_PRIMASK(primask);
+}
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void IRQSTAT_Exit(const IRQSTAT_Frame *frame, const char *name)
+{
+    uint32_t exception = __get_IPSR() & 0x1FFU;
+    uint32_t primask   = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t inclusive = DWT->CYCCNT - frame->start;
+    uint32_t exclusive = inclusive - (IRQSTAT_Nested_Cycles - frame->nested);
+
+    IRQSTAT_Nested_Cycles += exclusive;
+
+    if (exception < IRQSTAT_NUM_EXCEPTIONS)
+    {
+        if (Slot_Of[exception] == 0 && Slot_Count < IRQSTAT_MAX_SLOTS) {
+            Slots[Slot_Count].name      = name;
+            Slots[Slot_Count].exception = exception;
+            Slot_Of[exception] = ++Slot_Count;
+        }
+
+        if (Slot_Of[exception] != 0)
+        {
+            IRQSTAT_Stats *stats = &Slots[Slot_Of[exception] - 1];
+
+            stats->count++;
+            stats->last_cycles   = exclusive;
+            stats->total_cycles += exclusive;
+            if (exclusive > stats->max_cycles) stats->max_cycles = exclusive;
+
+            if (frame->latency != IRQSTAT_NO_LATENCY) {
+                stats->latency_count++;
+                stats->last_latency   = frame->latency;
+                stats->total_latency += frame->latency;
+                if (frame->latency > stats->max_latency) stats->max_latency = frame->latency;
+            }
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+bool IRQSTAT_Get(uint32_t slot, IRQSTAT_Stats *stats_out)
+{
+    if (slot >= Slot_Count) return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats_out = Slots[slot];
+    __set_PRIMASK(primask);
+    return true;
+}
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void IRQSTAT_Clear(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t slot=0; slot<Slot_Count; slot++)
+    {
+        const char *name      = Slots[slot].name;
+        uint32_t    exception = Slots[slot].exception;
+
+        memset(&Slots[slot], 0, sizeof(Slots[slot]));
+        Slots[slot].name      = name;
+        Slots[slot].exception = exception;
+    }
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,149 @@
+
+/*
+================================================================================================#=
+Interrupt Statistics
+
+Opt-in accounting of interrupt handler execution time and entry latency.
+
+Wrap the body of an interrupt handler with the IRQSTAT macros:
+
+    void USART2_IRQHandler(void)
+    {
+        IRQSTAT_ENTER();
+        USART_IT_CLI_ISR();
+        IRQSTAT_EXIT();
+    }
+
+Each handler is identified by its exception number, read from IPSR on exit,
+and is assigned one of IRQSTAT_MAX_SLOTS statistics slots the first time it runs.
+For each slot the module keeps the number of calls and the last, maximum and
+total execution time, in CPU cycles as counted by the DWT cycle counter.
+Time spent in nested, higher priority handlers that are themselves wrapped
+is not charged to the handler they preempted.
+
+Where the time at which the interrupt became pending can be recovered,
+pass the cycles elapsed since then to IRQSTAT_ENTER_LATENCY() instead;
+the module then also keeps the last, maximum and total entry latency.
+IRQSTAT_SysTick_Latency() recovers it for the SysTick exception
+from the SysTick down counter.  Most peripherals have no such timestamp.
+
+The macros compile to nothing unless the build defines IRQSTAT_ENABLE to 1.
+Requires the DWT cycle counter; i.e. a Cortex-M3 or above.
+The statistics are shown by the 'irqstat' CLI command; see irq-stat-cli.h.
+================================================================================================#=
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32l4xx.h"
+
+
+// -----------------------------------------------------------------------------+-
+// Build-Time Configuration
+// -----------------------------------------------------------------------------+-
+#ifndef IRQSTAT_ENABLE
+#define IRQSTAT_ENABLE (0)
+#endif
+
+#ifndef IRQSTAT_MAX_SLOTS
+#define IRQSTAT_MAX_SLOTS (8U)
+#endif
+
+// The number of exception numbers tracked; 16 system exceptions plus the IRQs;
+#ifndef IRQSTAT_NUM_EXCEPTIONS
+#define IRQSTAT_NUM_EXCEPTIONS (128U)
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// Statistics for one interrupt handler;
+// All times are in CPU cycles.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    const char *name;             // Name of the handler function;
+    uint32_t    exception;        // Exception number; IRQn + 16;
+    uint32_t    count;
+    uint32_t    last_cycles;
+    uint32_t    max_cycles;
+    uint64_t    total_cycles;
+    uint32_t    latency_count;    // Calls for which the latency was known;
+    uint32_t    last_latency;
+    uint32_t    max_latency;
+    uint64_t    total_latency;
+
+}   IRQSTAT_Stats;
+
+// -----------------------------------------------------------------------------+-
+// State kept on the handler's stack between entry and exit;
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    uint32_t start;
+    uint32_t nested;
+    uint32_t latency;
+
+}   IRQSTAT_Frame;
+
+#define IRQSTAT_NO_LATENCY (0xFFFFFFFFU)
+
+// Exclusive cycles of all completed, wrapped handlers; see irq-stat.c
+extern volatile uint32_t IRQSTAT_Nested_Cycles;
+
+
+// -----------------------------------------------------------------------------+-
+// Instrumentation Macros
+// -----------------------------------------------------------------------------+-
+#if IRQSTAT_ENABLE
+
+#define IRQSTAT_ENTER_LATENCY(latency_cycles)                                   \
+    IRQSTAT_Frame irqstat_frame = {                                             \
+        .start   = DWT->CYCCNT,                                                 \
+        .nested  = IRQSTAT_Nested_Cycles,                                       \
+        .latency = (latency_cycles),                                            \
+    }
+
+#define IRQSTAT_ENTER()  IRQSTAT_ENTER_LATENCY(IRQSTAT_NO_LATENCY)
+#define IRQSTAT_EXIT()   IRQSTAT_Exit(&irqstat_frame, __func__)
+
+#else
+
+#define IRQSTAT_ENTER_LATENCY(latency_cycles)
+#define IRQSTAT_ENTER()
+#define IRQSTAT_EXIT()
+
+#endif
+
+
+// -----------------------------------------------------------------------------+-
+// Cycles since the SysTick counter last reloaded, i.e. since the SysTick
+// exception became pending; only meaningful from within the SysTick handler.
+// -----------------------------------------------------------------------------+-
+static inline uint32_t IRQSTAT_SysTick_Latency(void)
+{
+    uint32_t ticks = SysTick->LOAD - SysTick->VAL;
+
+    // The external SysTick reference clock is HCLK/8 on the STM32;
+    if ((SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk) == 0) ticks *= 8U;
+    return ticks;
+}
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// Enable the DWT cycle counter and clear the statistics;
+void IRQSTAT_Init(void);
+
+// Record the end of a wrapped handler; called by IRQSTAT_EXIT();
+void IRQSTAT_Exit(const IRQSTAT_Frame *frame, const char *name);
+
+// Copy the statistics of the given slot; returns false if the slot is not in use;
+bool IRQSTAT_Get(uint32_t slot, IRQSTAT_Stats *stats_out);
+
+// Clear the statistics; slots stay assigned to their handlers;
+void IRQSTAT_Clear(void);
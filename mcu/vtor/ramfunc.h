@@ -0,0 +1,47 @@
+
+/*
+================================================================================================#=
+RAM Functions
+
+MCU_RAMFUNC places a function in the .ramfunc section; the linker script
+gives it a load address in flash and a run address in SRAM2, and the reset
+handler copies it there, as for initialised data.  Code run from SRAM needs
+no flash wait states and does not depend on the ART cache; i.e. an interrupt
+handler so placed runs in the same number of cycles every time.
+
+    MCU_RAMFUNC void USART_IT_CLI_ISR(void)
+    {
+        ...
+    }
+
+SRAM2 is aliased at 0x10000000, on the I-Code and D-Code buses, so that
+instruction fetches from it do not contend with the stack and data in SRAM1.
+Calls from flash to SRAM, and back, are out of range of a BL instruction;
+the linker adds a veneer for each, in the caller's memory.
+
+Only the function itself is placed; what it calls stays where it is.
+The static inline helpers of the Low Level Drivers are inlined only when
+the build optimises; at -O0 they are called, from flash.
+
+The macro expands to nothing if the build defines MCU_RAMFUNC_ENABLE to 0;
+everything then runs from flash again, e.g. to compare the two.
+Requires the STM32L4 linker script and reset-handler-default-cm4.s;
+see the README of this folder.
+================================================================================================#=
+*/
+
+#pragma once
+
+
+// -----------------------------------------------------------------------------+-
+// Build-Time Configuration
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_RAMFUNC_ENABLE
+#define MCU_RAMFUNC_ENABLE (1)
+#endif
+
+#if MCU_RAMFUNC_ENABLE
+#define MCU_RAMFUNC  __attribute__((section(".ramfunc"), noinline))
+#else
+#define MCU_RAMFUNC
+#endif
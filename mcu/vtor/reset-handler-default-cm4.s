@@ -13,6 +13,8 @@ The purpose of the reset handler is to:
 Details:
 * Set Stack Pointer (is this necessary? I thought the hardware did this?)
 * Copy initialized data to RAM.
+* Copy the RAM functions to SRAM2.
+* Copy initialized data to SRAM2, and zero-fill the BSS in SRAM2.
 * Zero-Fill the BSS Section.
 * Call libc init.
 * Call the application main().
@@ -38,6 +40,17 @@ DEPENDENCIES:
     _sbss    Start address of the BSS zero-initialized data in RAM.
     _ebss    End address of the BSS zero-initialized data in RAM.
 
+    _siramfunc  Start address of the RAM functions in Flash.
+    _sramfunc   Start address of the RAM functions in SRAM2.
+    _eramfunc   End  address  of the RAM functions in SRAM2.
+
+    _sisram2    Start address of the initialized data in Flash, for SRAM2.
+    _ssram2     Start address of the initialized data in SRAM2.
+    _esram2     End  address  of the initialized data in SRAM2.
+
+    _ssram2bss  Start address of the zero-initialized data in SRAM2.
+    _esram2bss  End address of the zero-initialized data in SRAM2.
+
     This handler will 'relocate' RW Data from Flash to RAM.
     Initialized RW Data is initialized using values that have been programmed into Flash.
 
@@ -96,6 +109,23 @@ EndDataRAM:     .word  _edata
 
 StartBSSRAM:    .word  _sbss
 EndBSSRAM:      .word  _ebss
+
+The functions placed in the .ramfunc section, by MCU_RAMFUNC, are copied
+from Flash to SRAM2 in the same way as the initialized data; see ramfunc.h.
+
+_siramfunc  Start address of the RAM functions in Flash.
+_sramfunc   Start address of the RAM functions in SRAM2.
+_eramfunc   End address of the RAM functions in SRAM2.
+
+The data placed in SRAM2, see sram2.h, is initialized in the same way as
+that in RAM; the data in the .sram2.noinit section is left as it is.
+
+_sisram2    Start address of the initialized data in Flash, for SRAM2.
+_ssram2     Start address of the initialized data in SRAM2.
+_esram2     End address of the initialized data in SRAM2.
+
+_ssram2bss  Start address of the BSS data in SRAM2.
+_esram2bss  End address of the BSS data in SRAM2.
 --------------------------------------------------------------------------------+-
 */
 
@@ -161,6 +191,64 @@ LoopCopyDataInit:
         bcc     CopyDataInit      @ (Branch if carry clear)  If not, branch to copy the next word.
 
                                   @ We are done with non-zero initialization.
+
+        // -------------------------------------------------------------+-
+        // RAM Functions
+        // Copy the code of the RAM functions from flash to SRAM2.
+        // -------------------------------------------------------------+-
+        movs    r1, 0             @ R1 is the index from the start of the RAM functions.
+        b       LoopCopyRamFunc   @ First check whether there even are any RAM functions.
+
+CopyRamFunc:                      @ Copy one word of code from Flash to SRAM2.
+        ldr     r3, =_siramfunc   @ R3 is the address in Flash of the first word of the RAM functions.
+        ldr     r3, [r3, r1]      @ Index R3, Load R3 with the next word of code from Flash.
+        str     r3, [r0, r1]      @ Store R3 at the next location in SRAM2.
+        adds    r1, r1, 4         @ Increment the index.
+
+LoopCopyRamFunc:
+        ldr     r0, =_sramfunc    @ R0 is the address in SRAM2 of the first word of the RAM functions.
+        ldr     r3, =_eramfunc    @ R3 is the address in SRAM2 just past the end of the RAM functions.
+        adds    r2, r0, r1        @ R2 is the address in SRAM2 of the next word to be written to.
+        cmp     r2, r3            @ (Compare is R2-R3)  Have we reached the end of the RAM functions?
+        bcc     CopyRamFunc       @ (Branch if carry clear)  If not, branch to copy the next word.
+        dsb                       @ Complete the copy before any of it is fetched as code.
+        isb
+
+        // -------------------------------------------------------------+-
+        // SRAM2 Initialized Data
+        // Copy the SRAM2 data initializers from flash to SRAM2.
+        // -------------------------------------------------------------+-
+        movs    r1, 0             @ R1 is the index from the start of the SRAM2 data.
+        b       LoopCopySram2     @ First check whether there even is any SRAM2 data.
+
+CopySram2:                        @ Copy one word of initialized data from Flash to SRAM2.
+        ldr     r3, =_sisram2     @ R3 is the address in Flash of the first word of SRAM2 data.
+        ldr     r3, [r3, r1]      @ Index R3, Load R3 with the next word of SRAM2 data from Flash.
+        str     r3, [r0, r1]      @ Store R3 at the next location in SRAM2.
+        adds    r1, r1, 4         @ Increment the index.
+
+LoopCopySram2:
+        ldr     r0, =_ssram2      @ R0 is the address in SRAM2 of the first word of initialized data.
+        ldr     r3, =_esram2      @ R3 is the address in SRAM2 just past the end of the initialized data.
+        adds    r2, r0, r1        @ R2 is the address in SRAM2 of the next word to be written to.
+        cmp     r2, r3            @ (Compare is R2-R3)  Have we reached the end of the SRAM2 data?
+        bcc     CopySram2         @ (Branch if carry clear)  If not, branch to copy the next word.
+
+        // -------------------------------------------------------------+-
+        // SRAM2 Zero Initialized Data
+        // -------------------------------------------------------------+-
+        ldr     r2, =_ssram2bss   @ R2 is the address in SRAM2 of the first word of zero initialized data.
+        b       LoopFillSram2Bss
+
+FillSram2Bss:
+        movs    r3, 0             @ The zero to be stored.
+        str     r3, [r2], 4       @ Store the zero at *R2, Increment R2 by 4
+
+LoopFillSram2Bss:
+        ldr     r3, =_esram2bss   @ R3 is the address in SRAM2 just past the end of the zero initialized data.
+        cmp     r2, r3            @ (Compare is R2-R3)  Have we reached the end of zero initialized data?
+        bcc     FillSram2Bss      @ (Branch if carry clear)  If not, branch to zero the next word.
+
         ldr     r2, =_sbss        @ R2 is the address in RAM of the first word of zero initialized data.
         b       LoopFillZerobss   @ Begin zero initialization.
 
@@ -0,0 +1,48 @@
+
+/*
+================================================================================================#=
+SRAM2 Placement
+
+The STM32L476 has 128KB of SRAM: 96KB of SRAM1, at 0x20000000, where the
+linker script puts .data, .bss, the heap and the main stack, and 32KB of
+SRAM2, at 0x10000000.  These macros place variables in SRAM2 instead:
+
+    MCU_SRAM2_DATA     initialised data; loaded in flash, and copied to SRAM2
+                       by the reset handler, as for .data
+    MCU_SRAM2_BSS      zero initialised data; zeroed by the reset handler,
+                       as for .bss
+    MCU_SRAM2_NOINIT   neither loaded nor zeroed; its content survives a
+                       system reset, but not a power cycle
+
+    static uint8_t Rx_Buffer[256] MCU_SRAM2_BSS;
+
+SRAM2 is a good home for buffers and stacks: it is retained in Stop 2, the
+DMA reaches it, and on the I-Code and D-Code buses it does not contend with
+what is in SRAM1.  The USART CLI rings, and the FreeRTOS heap, and so the
+task stacks, of freertos-l4 live there; see the README of this folder.
+
+MCU_SRAM2_DATA and MCU_SRAM2_BSS expand to nothing if the build defines
+MCU_SRAM2_ENABLE to 0; the variables then go back to SRAM1.
+Requires the STM32L4 linker script and reset-handler-default-cm4.s.
+================================================================================================#=
+*/
+
+#pragma once
+
+
+// -----------------------------------------------------------------------------+-
+// Build-Time Configuration
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_SRAM2_ENABLE
+#define MCU_SRAM2_ENABLE (1)
+#endif
+
+#if MCU_SRAM2_ENABLE
+#define MCU_SRAM2_DATA    __attribute__((section(".sram2")))
+#define MCU_SRAM2_BSS     __attribute__((section(".sram2.bss")))
+#else
+#define MCU_SRAM2_DATA
+#define MCU_SRAM2_BSS
+#endif
+
+#define MCU_SRAM2_NOINIT  __attribute__((section(".sram2.noinit")))
@@ -0,0 +1,288 @@
+
+/*
+================================================================================================#=
+Vector Table CLI
+
+See vtor-cli.h for a description of this module.
+================================================================================================#=
+*/
+
+#include "mcu/vtor/vtor-cli.h"
+#include "mcu/vtor/vtor.h"
+#include "mcu/vtor/ramfunc.h"
+#include "mcu/clock/flash-latency.h"
+
+#include <string.h>
+
+#include "platform/cli/cli-cmd.h"
+#include "stm32l4xx.h"
+
+
+// -----------------------------------------------------------------------------+-
+// The samples per combination, and the two interrupts pended;
+// -----------------------------------------------------------------------------+-
+#define BENCH_SAMPLES       (256U)
+#define BENCH_FLASH_IRQn    (TSC_IRQn)
+#define BENCH_SRAM_IRQn     (LCD_IRQn)
+
+// The RAM functions, per the linker script;
+extern uint32_t _sramfunc;
+extern uint32_t _eramfunc;
+
+static volatile uint32_t Entry_Cycles;
+static volatile bool     Entered;
+
+typedef struct
+{
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+
+}   Bench_Stats;
+
+// -----------------------------------------------------------------------------+-
+// The results, one row per combination; shown a page at a time, as all of
+// them do not fit in the CLI response buffer.
+// -----------------------------------------------------------------------------+-
+#ifndef VTOR_CLI_PAGE_ROWS
+#define VTOR_CLI_PAGE_ROWS (4U)
+#endif
+
+#define BENCH_ROWS (8U)
+
+static Bench_Stats  Bench_Rows[BENCH_ROWS];
+static uint32_t     Bench_Row_Count;
+static uint32_t     Bench_Next_Row = BENCH_ROWS;
+static uint32_t     Bench_Wait_States;
+
+
+
+// =============================================================================================#=
+// Benchmark Interrupt Handlers
+// =============================================================================================#=
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// The same handler, once in flash and once in SRAM;
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+void TSC_IRQHandler(void)
+{
+    Entry_Cycles = DWT->CYCCNT;
+    Entered      = true;
+};
+
+MCU_RAMFUNC void LCD_IRQHandler(void)
+{
+    Entry_Cycles = DWT->CYCCNT;
+    Entered      = true;
+};
+
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// Pend the given interrupt, and return the cycles until its handler ran;
+// the ART caches are reset first if cold.
+// -----------------------------------------------------------------------------+-
+static uint32_t sample(IRQn_Type irq, bool cold, uint32_t art)
+{
+    if (cold) {
+        MCU_Flash_Set_ART(0);
+        MCU_Flash_Set_ART(art);
+    }
+
+    Entered = false;
+
+    uint32_t start = DWT->CYCCNT;
+    NVIC_SetPendingIRQ(irq);
+    __DSB();
+    __ISB();
+
+    while (!Entered) {}
+    return Entry_Cycles - start;
+}
+
+// -----------------------------------------------------------------------------+-
+// Sample the given interrupt; an untimed sample first, for the warm case.
+// -----------------------------------------------------------------------------+-
+static void bench_one(IRQn_Type irq, bool cold, uint32_t art, Bench_Stats *stats)
+{
+    stats->min   = UINT32_MAX;
+    stats->max   = 0;
+    stats->total = 0;
+
+    sample(irq, cold, art);
+
+    for (uint32_t idx=0; idx<BENCH_SAMPLES; idx++)
+    {
+        uint32_t cycles = sample(irq, cold, art);
+
+        if (cycles < stats->min) stats->min = cycles;
+        if (cycles > stats->max) stats->max = cycles;
+        stats->total += cycles;
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// vtor more
+// Show the next page of the results; the footer follows the last row.
+// The row index holds the vector table, handler and cache, in that order.
+// -----------------------------------------------------------------------------+-
+static void vtor_more(void)
+{
+    static const char *Where[] = { "flash", "sram" };
+    uint32_t shown = 0;
+
+    if (Bench_Next_Row >= Bench_Row_Count) {
+        CLI_CMD_Printf("vtor: nothing more; run 'vtor bench' first\n");
+        return;
+    }
+
+    while (shown < VTOR_CLI_PAGE_ROWS && Bench_Next_Row < Bench_Row_Count)
+    {
+        uint32_t           row   = Bench_Next_Row;
+        const Bench_Stats *stats = &Bench_Rows[row];
+
+        CLI_CMD_Printf("  %-7s %-7s %-5s %6lu %6lu %6lu %6lu\n",
+            Where[(row >> 2) & 1U], Where[(row >> 1) & 1U], (row & 1U) ? "cold" : "warm",
+            (unsigned long)stats->min,
+            (unsigned long)(stats->total / BENCH_SAMPLES),
+            (unsigned long)stats->max,
+            (unsigned long)(stats->max - stats->min)
+        );
+        Bench_Next_Row++;
+        shown++;
+    }
+
+    if (Bench_Next_Row < Bench_Row_Count) {
+        CLI_CMD_Printf("  -- row %lu of %lu; 'vtor more' to continue --\n",
+            (unsigned long)Bench_Next_Row, (unsigned long)Bench_Row_Count);
+        return;
+    }
+
+    CLI_CMD_Printf("  (cycles from the pend to the handler; %u samples; %lu wait states)\n",
+        BENCH_SAMPLES, (unsigned long)Bench_Wait_States);
+    if (!MCU_VTOR_SRAM_ENABLE) {
+        CLI_CMD_Printf("  (no vector table in SRAM; the build has MCU_VTOR_SRAM_ENABLE=0)\n");
+    }
+}
+
+// -----------------------------------------------------------------------------+-
+// vtor bench
+// Every combination of vector table, handler and cache; the vector table
+// selected, and the ART options, are restored afterwards.  All are run
+// before the first page is shown.
+//
+// This runs in the CLI USART interrupt; the two interrupts, at priority 0,
+// preempt it, as it is at USART_IT_CLI_IRQ_PRIORITY, 1 by default.  BASEPRI
+// at 1 holds off everything else but other interrupts at 0.
+// -----------------------------------------------------------------------------+-
+static void vtor_bench(void)
+{
+    uint32_t art       = MCU_Flash_Get_ART();
+    bool     was_sram  = CMSIS_VTOR_Is_SRAM();
+    uint32_t tables    = MCU_VTOR_SRAM_ENABLE ? 2U : 1U;
+    uint32_t basepri   = __get_BASEPRI();
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    NVIC_SetPriority(BENCH_FLASH_IRQn, 0);
+    NVIC_SetPriority(BENCH_SRAM_IRQn,  0);
+    NVIC_EnableIRQ(BENCH_FLASH_IRQn);
+    NVIC_EnableIRQ(BENCH_SRAM_IRQn);
+
+    for (uint32_t table=0; table<tables; table++) {
+        for (uint32_t handler=0; handler<2; handler++) {
+            for (uint32_t cold=0; cold<2; cold++)
+            {
+                IRQn_Type irq = handler ? BENCH_SRAM_IRQn : BENCH_FLASH_IRQn;
+
+                CMSIS_VTOR_Select_SRAM(table != 0);
+                __set_BASEPRI(1U << (8U - __NVIC_PRIO_BITS));
+                bench_one(irq, cold != 0, art, &Bench_Rows[(table << 2) | (handler << 1) | cold]);
+                __set_BASEPRI(basepri);
+            }
+        }
+    }
+
+    NVIC_DisableIRQ(BENCH_FLASH_IRQn);
+    NVIC_DisableIRQ(BENCH_SRAM_IRQn);
+    CMSIS_VTOR_Select_SRAM(was_sram);
+
+    Bench_Row_Count   = tables * 4U;
+    Bench_Next_Row    = 0;
+    Bench_Wait_States = MCU_Flash_Get_Wait_States();
+
+    CLI_CMD_Printf("  %-7s %-7s %-5s %6s %6s %6s %6s\n",
+        "vectors", "handler", "cache", "min", "avg", "max", "jitter");
+    vtor_more();
+}
+
+// -----------------------------------------------------------------------------+-
+// vtor
+// -----------------------------------------------------------------------------+-
+static void vtor_show(void)
+{
+    uint32_t ramfunc_bytes = (uint32_t)&_eramfunc - (uint32_t)&_sramfunc;
+
+    CLI_CMD_Printf("vtor: vector table in %s at 0x%08lx; %lu bytes of RAM functions at 0x%08lx\n",
+        CMSIS_VTOR_Is_SRAM() ? "SRAM" : "flash",
+        (unsigned long)SCB->VTOR,
+        (unsigned long)ramfunc_bytes,
+        (unsigned long)(uint32_t)&_sramfunc
+    );
+}
+
+// -----------------------------------------------------------------------------+-
+// vtor [sram | flash | bench | more]
+// -----------------------------------------------------------------------------+-
+static void vtor_cmd(int argc, char *argv[])
+{
+    if (argc == 1) {
+        vtor_show();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "bench") == 0) {
+        vtor_bench();
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "more") == 0) {
+        vtor_more();
+        return;
+    }
+
+    if (argc == 2 && (strcmp(argv[1], "sram") == 0 || strcmp(argv[1], "flash") == 0))
+    {
+        if (!CMSIS_VTOR_Select_SRAM(strcmp(argv[1], "sram") == 0)) {
+            CLI_CMD_Printf("vtor: no copy in SRAM; is the build configured with MCU_VTOR_SRAM_ENABLE=1?\n");
+            return;
+        }
+        vtor_show();
+        return;
+    }
+
+    CLI_CMD_Printf("usage: vtor [sram | flash | bench | more]\n");
+}
+
+static const CLI_CMD_Descriptor Vtor_Cmd = {
+    .name    = "vtor",
+    .help    = "show or select the vector table location; benchmark interrupt latency",
+    .handler = vtor_cmd,
+};
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void CMSIS_VTOR_CLI_Init(void)
+{
+    CLI_CMD_Register(&Vtor_Cmd);
+}
@@ -0,0 +1,36 @@
+
+/*
+================================================================================================#=
+Vector Table CLI
+
+Provides the 'vtor' command to show and select the vector table location of
+vtor.h, and to compare the interrupt latency from flash with that from SRAM,
+from the command line interface.
+
+    vtor             show where the vector table and the RAM functions are
+    vtor sram        select the copy of the vector table in SRAM2
+    vtor flash       select the vector table in flash
+    vtor bench       time the entry of an interrupt handler in flash, and of one in
+                     SRAM, with the vector table in each, from a warm and a cold ART cache;
+                     shows the first page of the results
+    vtor more        show the next page of the results
+
+The benchmark pends two interrupts nothing else uses, TSC and LCD, whose
+handlers are defined here: the first in flash, the second in SRAM, per
+ramfunc.h.  Each sample is the cycles from the pend to the handler's first
+read of the DWT cycle counter; the jitter is the spread between the least
+and the most of them.  The cold samples reset the ART caches before each
+pend, as after any other code has evicted the handler.
+
+The command runs in the CLI USART interrupt, which must be of a lower priority
+than the two interrupts, at the highest, 0; see USART_IT_CLI_IRQ_PRIORITY.
+The samples are taken with BASEPRI raised, so that only interrupts at 0 are
+taken; the benchmark holds off all others for the few milliseconds it takes.
+A profiler sample, on TIM6 at 0, that lands within a measurement inflates it.
+================================================================================================#=
+*/
+
+#pragma once
+
+// Register the 'vtor' command with the CLI;
+void CMSIS_VTOR_CLI_Init(void);
@@ -1,69 +1,70 @@
 
 /*
 ================================================================================================#=
-This module contains a project-specific adaptation of the CMSIS SystemInit function.
-It is based on the system_<device>.c file from the STM32CubeL4 MCU Package:
-    Drivers/CMSIS/Device/ST/STM32L4xx/Source/Templates/gcc/startup_stm32l476xx.s
-
-According to the CMSIS documentation, the CMSIS system file may require application specific
-adaptations and therefore should be copied into the application project folder.
-We have done this, in part, by refactoring the vector table location setup code
-and putting into its own module here.
-
-TODO: @@@@@ ReFactor and Thoroughly Comment
-NOTE: this is file is built but is not currently used.
+This module contains a project-specific adaptation of the vector table location
+setup of the CMSIS SystemInit function, from the system_<device>.c file of the
+STM32CubeL4 MCU Package; see vtor.h for a description of this module.
+
+The copy is made from g_pfnVectors, the table in flash, rather than from
+wherever VTOR points; so that selecting SRAM again simply refreshes it.
+Each switch is followed by a DSB, so that the next exception already takes
+its vector from the new table.
 ================================================================================================#=
 */
 
 #include "mcu/vtor/vtor.h"
 #include "stm32l4xx.h"
 
-// @@@ TODO - move this VTOR Table stuff to a new VTOR module that provides a service to manage this.
-// @@@ TODO - move this VTOR Table stuff to a new VTOR module that provides a service to manage this.
-// @@@ TODO - move this VTOR Table stuff to a new VTOR module that provides a service to manage this.
-
-
-/* Note: Following vector table addresses must be defined in line with linker configuration. */
-/*!< Uncomment the following line if you need to relocate the vector table
-     anywhere in Flash or Sram, else the vector table is kept at the automatic remap of boot address selected */
-
-/* #define USER_VECT_TAB_ADDRESS */
-#if defined(USER_VECT_TAB_ADDRESS)
+#include <stdint.h>
 
 
-/*!< Uncomment the following line if you need to relocate your vector Table
-     in Sram else user remap will be done in Flash. */
-/* #define VECT_TAB_SRAM */
+// The vector table in flash; see vector-table-gcc-stm32l476xx.s
+extern const uint32_t g_pfnVectors[];
 
-#if defined(VECT_TAB_SRAM)
-#define VECT_TAB_BASE_ADDRESS   SRAM1_BASE      /*!< Vector Table base address field.
-                                                     This value must be a multiple of 0x200. */
-#define VECT_TAB_OFFSET         0x00000000U     /*!< Vector Table base offset field.
-                                                     This value must be a multiple of 0x200. */
-#else
-#define VECT_TAB_BASE_ADDRESS   FLASH_BASE      /*!< Vector Table base address field.
-                                                     This value must be a multiple of 0x200. */
-#define VECT_TAB_OFFSET         0x00000000U     /*!< Vector Table base offset field.
-                                                     This value must be a multiple of 0x200. */
-#endif /* VECT_TAB_SRAM */
-#endif /* USER_VECT_TAB_ADDRESS */
+#if MCU_VTOR_SRAM_ENABLE
+// The copy in SRAM; see the .ram_vector section of the linker script.
+static uint32_t SRAM_Vectors[MCU_VTOR_NUM_VECTORS]
+    __attribute__((section(".ram_vector"), aligned(MCU_VTOR_ALIGNMENT)));
+#endif
 
 
-// @@@@@@@@@@@@@@@@@@@ REFACTOR & IMPROVE THIS @@@@@@@@@@@@@@@@@@@@@@@@
 // =============================================================================================#=
 // Set Vector Table Location
-// according to the #defines above.
 // =============================================================================================#=
 void CMSIS_VTOR_SetVectorTableLocation(void)
 {
+    CMSIS_VTOR_Select_SRAM(MCU_VTOR_SRAM_ENABLE);
+    return;
+}
 
-// @@@ TODO @@@
-// Refactor and move this VTOR Table stuff to a new VTOR module that provides a service to manage this.
-#if defined(USER_VECT_TAB_ADDRESS)
-    // Configure the Vector Table location
-    SCB->VTOR = VECT_TAB_BASE_ADDRESS | VECT_TAB_OFFSET;
+// =============================================================================================#=
+// Select SRAM, or Flash
+// =============================================================================================#=
+bool CMSIS_VTOR_Select_SRAM(bool use_sram)
+{
+    if (!use_sram) {
+        SCB->VTOR = (uint32_t)g_pfnVectors;
+        __DSB();
+        return true;
+    }
+
+#if MCU_VTOR_SRAM_ENABLE
+    for (uint32_t idx=0; idx<MCU_VTOR_NUM_VECTORS; idx++) {
+        SRAM_Vectors[idx] = g_pfnVectors[idx];
+    }
+    __DSB();
+    SCB->VTOR = (uint32_t)SRAM_Vectors;
+    __DSB();
+    return true;
+#else
+    return false;
 #endif
-
-    return;
 }
 
+// =============================================================================================#=
+// Is SRAM
+// =============================================================================================#=
+bool CMSIS_VTOR_Is_SRAM(void)
+{
+    return SCB->VTOR != (uint32_t)g_pfnVectors;
+}
@@ -2,11 +2,49 @@
 /*
 ================================================================================================#=
 Vector Table Module API
+
+The vector table is linked into flash, at its start, from where the processor
+takes it at reset.  It can be copied to SRAM2, at 0x10000000, and VTOR pointed
+at the copy; the vector fetch of each exception then no longer waits on the
+flash, nor depends on what the ART cache happens to hold.
+
+The copy is reserved, in the .ram_vector section, only if the build defines
+MCU_VTOR_SRAM_ENABLE to 1; CMSIS_VTOR_SetVectorTableLocation() then makes the
+switch at startup.  Either table may be selected at run time, e.g. to compare
+the two; both hold the same handlers.  Handlers are linked, not installed at
+run time, so the copy never differs from the table in flash.
+
+STM32L4 only; the Cortex-M0 of the STM32F0 has no VTOR.
 ================================================================================================#=
 */
 
-void CMSIS_VTOR_SetVectorTableLocation(void);
+#pragma once
+
+#include <stdbool.h>
 
 
+// -----------------------------------------------------------------------------+-
+// Build-Time Configuration
+// -----------------------------------------------------------------------------+-
+#ifndef MCU_VTOR_SRAM_ENABLE
+#define MCU_VTOR_SRAM_ENABLE (0)
+#endif
+
+// The entries of the STM32L476 vector table: the initial stack pointer,
+// 15 system exceptions and 82 interrupts; see vector-table-gcc-stm32l476xx.s
+#define MCU_VTOR_NUM_VECTORS (98U)
+
+// VTOR requires the table aligned to its size, rounded up to a power of two;
+#define MCU_VTOR_ALIGNMENT   (512U)
+
+
+// Set the vector table location per MCU_VTOR_SRAM_ENABLE; call it once,
+// at startup, before any interrupt is enabled.
+void CMSIS_VTOR_SetVectorTableLocation(void);
 
+// Select the copy in SRAM, or the table in flash;
+// Returns false, having changed nothing, if the build reserved no copy.
+bool CMSIS_VTOR_Select_SRAM(bool use_sram);
 
+// Returns true if VTOR points to the copy in SRAM;
+bool CMSIS_VTOR_Is_SRAM(void);
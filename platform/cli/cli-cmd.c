@@ -0,0 +1,193 @@
+
+// =============================================================================================#=
+// CLI COMMAND DISPATCH
+// platform/cli/cli-cmd.c
+//
+// SPDX-License-Identifier: MIT-0
+// =============================================================================================#=
+
+#include "platform/cli/cli-cmd.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Project Dependencies
+#include "platform/usart/usart-it-cli.h"
+
+#define TRC_MODULE trcModCli
+#include "core/swtrace/trc.h"
+
+
+// =============================================================================================#=
+// Private Internal Types and Data
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// Command Table
+// -----------------------------------------------------------------------------+-
+#ifndef CLI_CMD_MAX_COMMANDS
+#define CLI_CMD_MAX_COMMANDS (24U)
+#endif
+
+static const CLI_CMD_Descriptor *Command_Table[CLI_CMD_MAX_COMMANDS];
+static uint32_t                  Command_Count = 0;
+
+// -----------------------------------------------------------------------------+-
+// Maximum number of arguments in a command line, including the command name;
+// Any arguments beyond this are silently ignored.
+// -----------------------------------------------------------------------------+-
+#ifndef CLI_CMD_MAX_ARGS
+#define CLI_CMD_MAX_ARGS (8U)
+#endif
+
+// -----------------------------------------------------------------------------+-
+// Response formatting buffer;
+// -----------------------------------------------------------------------------+-
+#ifndef CLI_CMD_RESPONSE_BUFFER_SIZE
+#define CLI_CMD_RESPONSE_BUFFER_SIZE (128U)
+#endif
+static char Response_Buffer[CLI_CMD_RESPONSE_BUFFER_SIZE];
+
+
+// =============================================================================================#=
+// Private Internal Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// Built-in 'help' command;
+//
+// The listing outgrows the response buffer, which the USART only drains
+// once the command returns; so it is shown a page at a time, as much as
+// fits, leaving room for the line that points to the next page.
+// The command of the next page is kept between commands.
+// -----------------------------------------------------------------------------+-
+#define HELP_MORE_ROOM (48U)
+
+static uint32_t Help_Next = 0;
+
+static void help_cmd_handler(int argc, char *argv[])
+{
+    if(argc < 2 || strcmp(argv[1], "more") != 0) Help_Next = 0;
+
+    while(Help_Next < Command_Count)
+    {
+        const CLI_CMD_Descriptor *cmd = Command_Table[Help_Next];
+        int line_len = snprintf(NULL, 0, "  %-10s %s\n", cmd->name, cmd->help);
+
+        if(line_len < 0) line_len = 0;
+        if(line_len >= CLI_CMD_RESPONSE_BUFFER_SIZE) line_len = CLI_CMD_RESPONSE_BUFFER_SIZE - 1;
+        if(USART_IT_CLI_Response_Slots_Available() < (uint32_t)line_len + HELP_MORE_ROOM) break;
+
+        CLI_CMD_Printf("  %-10s %s\n", cmd->name, cmd->help);
+        Help_Next++;
+    }
+
+    if(Help_Next < Command_Count) {
+        CLI_CMD_Printf("  -- %lu of %lu; 'help more' to continue --\n",
+            (unsigned long)Help_Next, (unsigned long)Command_Count
+        );
+    }
+}
+
+static const CLI_CMD_Descriptor Help_Cmd = {
+    .name    = "help",
+    .help    = "list the available commands; 'help more' for the next page",
+    .handler = help_cmd_handler,
+};
+
+
+// -----------------------------------------------------------------------------+-
+// Split the given line into white-space separated arguments, in place;
+// Returns the number of arguments found.
+// -----------------------------------------------------------------------------+-
+static int split_args(char *line, char *argv[], int max_args)
+{
+    int argc = 0;
+
+    while(*line != '\0' && argc < max_args) {
+
+        // Skip leading white space;
+        while(*line == ' ' || *line == '\t' || *line == '\n' || *line == '\r') {
+            *line++ = '\0';
+        }
+        if(*line == '\0') break;
+
+        argv[argc++] = line;
+
+        // Find the end of this argument;
+        while(*line != '\0' && *line != ' ' && *line != '\t' && *line != '\n' && *line != '\r') {
+            line++;
+        }
+    }
+    return argc;
+}
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+bool CLI_CMD_Register(const CLI_CMD_Descriptor *given_cmd)
+{
+    // The built-in help command always occupies the first slot;
+    if(Command_Count == 0) {
+        Command_Table[Command_Count++] = &Help_Cmd;
+    }
+
+    if(Command_Count >= CLI_CMD_MAX_COMMANDS) return false;
+
+    Command_Table[Command_Count++] = given_cmd;
+    return true;
+}
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void CLI_CMD_Process_Line(char *given_line)
+{
+    char *argv[CLI_CMD_MAX_ARGS];
+    int   argc = split_args(given_line, argv, CLI_CMD_MAX_ARGS);
+
+    if(argc == 0) return;
+
+    if(strcmp(argv[0], Help_Cmd.name) == 0) {
+        help_cmd_handler(argc, argv);
+        return;
+    }
+
+    for(uint32_t idx=0; idx<Command_Count; idx++) {
+        if(strcmp(argv[0], Command_Table[idx]->name) == 0) {
+            trcSpanBegin(trcSpanCliCommand);
+            Command_Table[idx]->handler(argc, argv);
+            trcSpanEnd(trcSpanCliCommand);
+            return;
+        }
+    }
+
+    CLI_CMD_Printf("%s: command not found; try 'help'\n", argv[0]);
+}
+
+// -----------------------------------------------------------------------------+-
+// -----------------------------------------------------------------------------+-
+void CLI_CMD_Printf(const char *format_string, ...)
+{
+    int     num_chars;
+    va_list argptr;
+
+    va_start(argptr, format_string);
+    num_chars = vsnprintf(
+        Response_Buffer, sizeof(Response_Buffer), format_string, argptr
+    );
+    va_end(argptr);
+
+    if(num_chars < 0) return;
+
+    // A return value of size or more means the output was truncated.
+    if(num_chars >= sizeof(Response_Buffer)) {
+        num_chars = sizeof(Response_Buffer) - 1;
+    }
+
+    USART_IT_CLI_Put_Response((uint8_t *)Response_Buffer, (uint8_t)num_chars);
+}
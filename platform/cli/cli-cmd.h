@@ -0,0 +1,72 @@
+
+// =============================================================================================#=
+// CLI COMMAND DISPATCH API
+// platform/cli/cli-cmd.h
+//
+// This module maps a command line, as delivered by the USART CLI,
+// onto a handler function registered by the module that owns the command.
+//
+// Each command line is split into white-space separated arguments;
+// the first argument names the command and selects the handler;
+// the handler is given the full argument list, including the command name,
+// in the familiar argc/argv form.
+//
+// NOTICE: command lines are delivered by the USART CLI from within its ISR;
+// handlers must therefore be short, must not block, and must only use
+// services that are safe to call from interrupt context.
+//
+// SPDX-License-Identifier: MIT-0
+// =============================================================================================#=
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// =============================================================================================#=
+// API Types
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// Command Handler Function Pointer Type
+// -----------------------------------------------------------------------------+-
+typedef void (*CLI_CMD_Handler)(int argc, char *argv[]);
+
+// -----------------------------------------------------------------------------+-
+// Command Descriptor
+//
+// The client allocates the descriptor, typically as a static const,
+// and it must remain valid for as long as the command is registered.
+// -----------------------------------------------------------------------------+-
+typedef struct
+{
+    const char      *name;     // What the user types to invoke the command;
+    const char      *help;     // One line summary shown by the 'help' command;
+    CLI_CMD_Handler  handler;  // Called to execute the command;
+
+} CLI_CMD_Descriptor;
+
+
+// =============================================================================================#=
+// Public API Functions
+// =============================================================================================#=
+
+// -----------------------------------------------------------------------------+-
+// Register the given command;
+// Returns false if the command table is full.
+// -----------------------------------------------------------------------------+-
+bool CLI_CMD_Register(const CLI_CMD_Descriptor *given_cmd);
+
+// -----------------------------------------------------------------------------+-
+// Parse the given NUL terminated command line and invoke its handler;
+// The line is modified in place as it is split into arguments.
+// -----------------------------------------------------------------------------+-
+void CLI_CMD_Process_Line(char *given_line);
+
+// -----------------------------------------------------------------------------+-
+// Format a command response and send it to the user's terminal;
+// Output is truncated to CLI_CMD_RESPONSE_BUFFER_SIZE characters per call.
+// -----------------------------------------------------------------------------+-
+void CLI_CMD_Printf(const char *format_string, ...)
+    __attribute__((format(printf, 1, 2)));
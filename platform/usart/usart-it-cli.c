@@ -16,9 +16,14 @@
 
 // Project Dependencies
 #include "platform/util/ring-buffer.h"
+#include "mcu/vtor/ramfunc.h"
+#include "mcu/vtor/sram2.h"
 
 #include "core/swtrace/trc-led.h"
 
+#define TRC_MODULE trcModUsart
+#include "core/swtrace/trc.h"
+
 
 // STM32 Low Level Drivers
 #include "STM32L4xx_HAL_Driver/Inc/stm32l4xx_ll_bus.h"
@@ -32,37 +37,64 @@
 // Private Internal Types and Data
 // =============================================================================================#=
 
+#define BAUD_RATE (115200U)
+
+// Below the highest priority, 0, which is left for the interrupts that must
+// preempt the CLI; e.g. the profiler's sampling timer.
+#ifndef USART_IT_CLI_IRQ_PRIORITY
+#define USART_IT_CLI_IRQ_PRIORITY (1U)
+#endif
+
 // -----------------------------------------------------------------------------+-
 // Internal Ring Buffers
 // Size must be a power of two;
+// The rings, and their descriptors, live in SRAM2; see mcu/vtor/sram2.h
 // -----------------------------------------------------------------------------+-
-static uint8_t input_buffer[64];      // RX chars from the user's terminal;
-static uint8_t echo_buffer[64];       // TX chars to be echo'd back to the user;
-static uint8_t trace_buffer[1024];    // TX chars from the software trace facility;
-static uint8_t response_buffer[512];  // TX response chars from command processing;
+static uint8_t input_buffer[64]      MCU_SRAM2_BSS;  // RX chars from the user's terminal;
+static uint8_t echo_buffer[64]       MCU_SRAM2_BSS;  // TX chars to be echo'd back to the user;
+static uint8_t trace_hi_buffer[256]  MCU_SRAM2_BSS;  // TX chars from the software trace facility; high priority lane;
+static uint8_t trace_lo_buffer[1024] MCU_SRAM2_BSS;  // TX chars from the software trace facility; low priority lane;
+static uint8_t response_buffer[512]  MCU_SRAM2_BSS;  // TX response chars from command processing;
 
-static Ring_Buffer input_rb = {
+static Ring_Buffer input_rb MCU_SRAM2_DATA = {
     .buff = input_buffer,
     .size = sizeof(input_buffer),
     .tail = 0,
     .head = 0,
 };
 
-static Ring_Buffer echo_rb = {
+static Ring_Buffer echo_rb MCU_SRAM2_DATA = {
     .buff = echo_buffer,
     .size = sizeof(echo_buffer),
     .tail = 0,
     .head = 0,
 };
 
-static Ring_Buffer trace_rb = {
-    .buff = trace_buffer,
-    .size = sizeof(trace_buffer),
-    .tail = 0,
-    .head = 0,
+// -----------------------------------------------------------------------------+-
+// Trace Lanes
+// One ring buffer per lane, indexed by lane, in priority order.
+//
+// Within each trace ring buffer, every message is preceded by a one byte
+// header that holds the length of the message that follows;
+// This is how the ISR finds the message boundaries.
+// -----------------------------------------------------------------------------+-
+static Ring_Buffer trace_rb[USART_IT_CLI_Trace_Lane_NumOf] MCU_SRAM2_DATA = {
+    [USART_IT_CLI_Trace_Lane_High] = {
+        .buff = trace_hi_buffer,
+        .size = sizeof(trace_hi_buffer),
+        .tail = 0,
+        .head = 0,
+    },
+    [USART_IT_CLI_Trace_Lane_Low] = {
+        .buff = trace_lo_buffer,
+        .size = sizeof(trace_lo_buffer),
+        .tail = 0,
+        .head = 0,
+    },
 };
+#define TRACE_MSG_HEADER_LEN (1U)
 
-static Ring_Buffer response_rb = {
+static Ring_Buffer response_rb MCU_SRAM2_DATA = {
     .buff = response_buffer,
     .size = sizeof(response_buffer),
     .tail = 0,
@@ -113,8 +145,8 @@ typedef struct
     uint32_t  read_idx;  // this is the next char to be read;
 } PCB_Struct;
 
-static uint8_t pcb_a[128];
-static uint8_t pcb_b[128];
+static uint8_t pcb_a[128] MCU_SRAM2_BSS;
+static uint8_t pcb_b[128] MCU_SRAM2_BSS;
 
 static PCB_Struct Double_PCB[] = {
     {
@@ -148,9 +180,11 @@ static int8_t  Cmd_Ready       = BUFF_NONE;
 // -------------------------------------------------------------+-
 static uint32_t input_rb_overflow     = 0;
 static uint32_t echo_rb_overflow      = 0;
-static uint32_t trace_rb_overflow     = 0;
 static uint32_t response_rb_overflow  = 0;
 
+static uint32_t trace_rb_queued[USART_IT_CLI_Trace_Lane_NumOf];
+static uint32_t trace_rb_overflow[USART_IT_CLI_Trace_Lane_NumOf];
+
 
 
 
@@ -408,18 +442,24 @@ static void process_input_char(uint8_t given_char)
 // Also note: any write to the TDR will clear
 // the TXE bit in the USART peripheral;
 // -----------------------------------------------------------------------------+-
-static void usart_tdr_empty(void)
+MCU_RAMFUNC static void usart_tdr_empty(void)
 {
     uint8_t  next_char;
     bool     write_tdr = false;
 
     static bool  CR_Needed            = false;
     static bool  response_in_progress = false;
-    static bool  trace_in_progress    = false;
     static bool  echo_in_progress     = false;
 
+    // Trace is consumed one message at a time;
+    // Remaining is the number of bytes yet to be sent from the current message
+    // in the current lane; zero means we are at a message boundary.
+    static uint32_t     trace_remaining = 0;
+    static Ring_Buffer *trace_lane_rb   = NULL;
+
+    trcSpanBegin(trcSpanUsartTdrEmpty);
+
     if(RB_Is_Empty(&response_rb)) response_in_progress = false;
-    if(RB_Is_Empty(&trace_rb))    trace_in_progress    = false;
     if(RB_Is_Empty(&echo_rb))     echo_in_progress     = false;
 
     // -------------------------------------------------------------+-
@@ -435,10 +475,15 @@ static void usart_tdr_empty(void)
         write_tdr = true;
         restore_user_cmd_line = true;
     }
-    else if(trace_in_progress) {
-        next_char = RB_Read_Byte_From_Head(&trace_rb);
-        write_tdr = true;
-        restore_user_cmd_line = true;
+    else if(trace_remaining > 0) {
+        // Messages are queued whole, under PRIMASK; so the rest of this one
+        // is always in the lane already, and the check is merely defensive.
+        if(RB_Is_Not_Empty(trace_lane_rb)) {
+            next_char = RB_Read_Byte_From_Head(trace_lane_rb);
+            write_tdr = true;
+            restore_user_cmd_line = true;
+            trace_remaining--;
+        }
     }
     else if(echo_in_progress) {
         next_char = RB_Read_Byte_From_Head(&echo_rb);
@@ -452,13 +497,16 @@ static void usart_tdr_empty(void)
         // -------------------------------------------------------------+-
         while(RB_Is_Not_Empty(&input_rb)) {
             next_char = RB_Read_Byte_From_Head(&input_rb);
+
+            trcSpanBegin(trcSpanUsartInputChar);
             process_input_char(next_char);
+            trcSpanEnd(trcSpanUsartInputChar);
         }
 
         // -------------------------------------------------------------+-
         // And then pick a new queue to start consuming;
         // We only start reading from the trace log
-        // if XON is enabled;
+        // if XON is enabled; trace lanes are checked in priority order;
         // -------------------------------------------------------------+-
         if(RB_Is_Not_Empty(&echo_rb)) {
             next_char = RB_Read_Byte_From_Head(&echo_rb);
@@ -471,11 +519,22 @@ static void usart_tdr_empty(void)
             restore_user_cmd_line = true;
             response_in_progress = true;
         }
-        else if(XON && RB_Is_Not_Empty(&trace_rb)) {
-            next_char = RB_Read_Byte_From_Head(&trace_rb);
-            write_tdr = true;
-            restore_user_cmd_line = true;
-            trace_in_progress = true;
+        else if(XON) {
+            for(int lane=0; lane<USART_IT_CLI_Trace_Lane_NumOf; lane++) {
+                if(RB_Is_Empty(&trace_rb[lane])) continue;
+
+                // Every message is at least one byte long;
+                // See USART_IT_CLI_Put_Trace();
+                trace_lane_rb   = &trace_rb[lane];
+                trace_remaining = RB_Read_Byte_From_Head(trace_lane_rb);
+                if(RB_Is_Not_Empty(trace_lane_rb)) {
+                    next_char = RB_Read_Byte_From_Head(trace_lane_rb);
+                    trace_remaining--;
+                    write_tdr = true;
+                    restore_user_cmd_line = true;
+                }
+                break;
+            }
         }
     }
 
@@ -486,6 +545,8 @@ static void usart_tdr_empty(void)
     else {
         LL_USART_DisableIT_TXE(USART2);
     }
+
+    trcSpanEnd(trcSpanUsartTdrEmpty);
     return;
 }
 
@@ -499,7 +560,7 @@ static void usart_tdr_empty(void)
 // each received character into the echo queue and
 // then let the TX ISR handle all of the processing.
 // -----------------------------------------------------------------------------+-
-static void usart_rdr_notempty(void)
+MCU_RAMFUNC static void usart_rdr_notempty(void)
 {
     // Read the RX byte; this also clears the RXNE bit;
     uint8_t rx_byte = LL_USART_ReceiveData8(USART2);
@@ -544,19 +605,40 @@ void USART_IT_CLI_Put_Response(uint8_t *given_buff_addr, uint8_t given_buff_len)
     return;
 }
 
-void USART_IT_CLI_Put_Trace(uint8_t *given_buff_addr, uint8_t given_buff_len)
+bool USART_IT_CLI_Put_Trace(
+    USART_IT_CLI_Trace_Lane  given_lane,
+    uint8_t                 *given_buff_addr,
+    uint8_t                  given_buff_len)
 {
-    uint32_t num_slots = RB_Slots_Available(&trace_rb);
+    if (given_lane >= USART_IT_CLI_Trace_Lane_NumOf) return false;
+    if (given_buff_len == 0) return true;
 
-    if (num_slots < given_buff_len) {
-        trace_rb_overflow++;
-        return;
+    Ring_Buffer *rb = &trace_rb[given_lane];
+
+    // Trace comes from tasks and interrupts alike; a message written in
+    // between the header and the body of another would desync the lane
+    // for good.  PRIMASK, so that writers of any priority are kept out.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t num_slots = RB_Slots_Available(rb);
+
+    if (num_slots < (given_buff_len + TRACE_MSG_HEADER_LEN)) {
+        trace_rb_overflow[given_lane]++;
+        __set_PRIMASK(primask);
+        return false;
     }
+
+    // The message length header must be written first;
+    RB_Write_Byte_To_Tail( rb, given_buff_len );
     for(int idx=0; idx<given_buff_len; idx++) {
-        RB_Write_Byte_To_Tail( &trace_rb, given_buff_addr[idx] );
+        RB_Write_Byte_To_Tail( rb, given_buff_addr[idx] );
     }
+    trace_rb_queued[given_lane]++;
     tx_data_available();
-    return;
+
+    __set_PRIMASK(primask);
+    return true;
 }
 
 // -----------------------------------------------------------------------------+-
@@ -567,9 +649,50 @@ uint32_t USART_IT_CLI_Response_Slots_Available(void)
     return RB_Slots_Available(&response_rb);
 }
 
-uint32_t USART_IT_CLI_Trace_Slots_Available(void)
+uint32_t USART_IT_CLI_Trace_Slots_Available(USART_IT_CLI_Trace_Lane given_lane)
 {
-    return RB_Slots_Available(&trace_rb);
+    if (given_lane >= USART_IT_CLI_Trace_Lane_NumOf) return 0;
+
+    uint32_t num_slots = RB_Slots_Available(&trace_rb[given_lane]);
+    if (num_slots <= TRACE_MSG_HEADER_LEN) return 0;
+
+    // Messages longer than this cannot be represented in the header;
+    num_slots -= TRACE_MSG_HEADER_LEN;
+    return (num_slots > UINT8_MAX) ? UINT8_MAX : num_slots;
+}
+
+// -----------------------------------------------------------------------------+-
+// TRACE LANE OCCUPANCY
+// -----------------------------------------------------------------------------+-
+bool USART_IT_CLI_Trace_Is_Empty(USART_IT_CLI_Trace_Lane given_lane)
+{
+    if (given_lane >= USART_IT_CLI_Trace_Lane_NumOf) return true;
+
+    return RB_Is_Empty(&trace_rb[given_lane]);
+}
+
+uint32_t USART_IT_CLI_Trace_Occupancy_Percent(USART_IT_CLI_Trace_Lane given_lane)
+{
+    if (given_lane >= USART_IT_CLI_Trace_Lane_NumOf) return 0;
+
+    Ring_Buffer *rb = &trace_rb[given_lane];
+
+    return (RB_Bytes_Available(rb) * 100U) / RB_Size(rb);
+}
+
+// -----------------------------------------------------------------------------+-
+// TRACE LANE COUNTERS
+// -----------------------------------------------------------------------------+-
+uint32_t USART_IT_CLI_Trace_Queued_Count(USART_IT_CLI_Trace_Lane given_lane)
+{
+    if (given_lane >= USART_IT_CLI_Trace_Lane_NumOf) return 0;
+    return trace_rb_queued[given_lane];
+}
+
+uint32_t USART_IT_CLI_Trace_Dropped_Count(USART_IT_CLI_Trace_Lane given_lane)
+{
+    if (given_lane >= USART_IT_CLI_Trace_Lane_NumOf) return 0;
+    return trace_rb_overflow[given_lane];
 }
 
 
@@ -640,8 +763,9 @@ uint32_t USART_IT_CLI_Get_Line(
 // USART PERIPHERAL INTERRUPT
 //
 // This should be invoked from the appropriate USART*_IRQHandler.
+// It runs from SRAM, with its two helpers; see mcu/vtor/ramfunc.h
 // -----------------------------------------------------------------------------+-
-void USART_IT_CLI_ISR(void)
+MCU_RAMFUNC void USART_IT_CLI_ISR(void)
 {
     // TXE Event Flag => Transmit Data Register Empty;
     // Hardware sets this flag when data has been transferred
@@ -710,7 +834,7 @@ void USART_IT_CLI_Module_Init(uint32_t given_PCLK1_frequency_in_hertz)
     LL_GPIO_SetPinPull(       GPIOA, LL_GPIO_PIN_3, LL_GPIO_PULL_UP);
 
     // At the NVIC level, configure interrupt: USART2_IRQn
-    NVIC_SetPriority( USART2_IRQn, 0 );
+    NVIC_SetPriority( USART2_IRQn, USART_IT_CLI_IRQ_PRIORITY );
     NVIC_EnableIRQ(   USART2_IRQn    );
 
     // Select PCLK1 as the clock source for the USART2 peripheral;
@@ -741,7 +865,7 @@ void USART_IT_CLI_Module_Init(uint32_t given_PCLK1_frequency_in_hertz)
         USART2,
         given_PCLK1_frequency_in_hertz,
         LL_USART_OVERSAMPLING_16,
-        115200
+        BAUD_RATE
     );
 
     // Enable USART peripheral and wait for confirmation by polling
@@ -760,6 +884,38 @@ void USART_IT_CLI_Module_Init(uint32_t given_PCLK1_frequency_in_hertz)
     // LL_USART_DisableIT_TXE(USART2);
 };
 
+// -----------------------------------------------------------------------------+-
+// CLOCK CHANGE BEGIN
+//
+// With interrupts disabled, the TXE interrupt cannot hand over another byte;
+// so the TDR holds at most one more, and TC is set once it, too, is sent.
+// The BRR may only be written while the USART is disabled.
+// -----------------------------------------------------------------------------+-
+void USART_IT_CLI_Clock_Change_Begin(void)
+{
+    while(!LL_USART_IsActiveFlag_TC(USART2)) {};
+    LL_USART_Disable(USART2);
+};
+
+// -----------------------------------------------------------------------------+-
+// CLOCK CHANGE END
+//
+// Set the baud rate for the new PCLK1 and re-enable the USART;
+// The TXE interrupt, still enabled, resumes where the output left off.
+// -----------------------------------------------------------------------------+-
+void USART_IT_CLI_Clock_Change_End(uint32_t given_PCLK1_frequency_in_hertz)
+{
+    LL_USART_SetBaudRate(
+        USART2,
+        given_PCLK1_frequency_in_hertz,
+        LL_USART_OVERSAMPLING_16,
+        BAUD_RATE
+    );
+
+    LL_USART_Enable(USART2);
+    while((!(LL_USART_IsActiveFlag_TEACK(USART2))) || (!(LL_USART_IsActiveFlag_REACK(USART2)))) {};
+};
+
 // Reserved for debug;
 // Trace_Red_Toggle();
 // Trace_Blue_Toggle();
@@ -34,9 +34,25 @@ void USART_IT_CLI_Module_Init(
     uint32_t  given_PCLK1_frequency_in_hertz
 );
 
+// -----------------------------------------------------------------------------+-
+// Clock Change
+//
+// For a change of the PCLK1 frequency at runtime, e.g. by a clock profile
+// subscriber; both must be called with interrupts disabled, around the change.
+// Begin waits for the byte in progress to be sent, then disables the USART;
+// End sets the baud rate for the given PCLK1 frequency and re-enables it.
+// A byte received meanwhile may be lost.
+// -----------------------------------------------------------------------------+-
+void USART_IT_CLI_Clock_Change_Begin(void);
+void USART_IT_CLI_Clock_Change_End(
+    uint32_t  given_PCLK1_frequency_in_hertz
+);
+
 // -----------------------------------------------------------------------------+-
 // USART Peripheral Interrupt
 // This should be invoked from the USART*_IRQHandler function.
+// It runs at USART_IT_CLI_IRQ_PRIORITY, 1 by default; and so do the CLI
+// command handlers, called from it.
 // -----------------------------------------------------------------------------+-
 void USART_IT_CLI_ISR(void);
 
@@ -45,26 +61,63 @@ void USART_IT_CLI_ISR(void);
 // TX APIs
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
 
+// -----------------------------------------------------------------------------+-
+// TRACE LANES
+//
+// Trace output is queued in one of several lanes, each with its own ring buffer,
+// so that a flood of low priority trace cannot crowd out the high priority trace.
+// Whenever a trace message has been completely sent, the next message is taken
+// from the highest priority lane that is not empty; thus, high priority trace
+// preempts any queued low priority trace at message boundaries.
+// -----------------------------------------------------------------------------+-
+typedef enum
+{
+    USART_IT_CLI_Trace_Lane_High = 0,   // For example: ERROR and FATAL;
+    USART_IT_CLI_Trace_Lane_Low,        // For example: INFO and DEBUG;
+    USART_IT_CLI_Trace_Lane_NumOf,
+}   USART_IT_CLI_Trace_Lane;
+
 // -----------------------------------------------------------------------------+-
 // USART CLI PUT RESPONSE
 // USART CLI PUT TRACE
 //
 // Write the given content into
-// the Command Response ring buff or the Trace Output ring buff, respectively.
+// the Command Response ring buff or the given Trace Output lane, respectively.
+// Each call to Put Trace is treated as a single trace message.
 //
 // Warning: when there is insufficent space available in either ring buffer,
-// the given content is silently thrown away;
+// the given content is thrown away; Put Trace returns false when this happens
+// and counts the loss against the lane.
 // If the client cannot allow it's content to be lost, and if it can afford to wait,
 // use the 'slots available' API call to first check for available TX slots.
 // -----------------------------------------------------------------------------+-
 void USART_IT_CLI_Put_Response(uint8_t *buff_addr, uint8_t buff_len);
-void USART_IT_CLI_Put_Trace(uint8_t *buff_addr, uint8_t buff_len);
+bool USART_IT_CLI_Put_Trace(USART_IT_CLI_Trace_Lane lane, uint8_t *buff_addr, uint8_t buff_len);
 
 // -----------------------------------------------------------------------------+-
 // Returns the number of slots available for new outgoing TX bytes.
+// For a trace lane, this is the longest message that will currently fit.
 // -----------------------------------------------------------------------------+-
 uint32_t USART_IT_CLI_Response_Slots_Available(void);
-uint32_t USART_IT_CLI_Trace_Slots_Available(void);
+uint32_t USART_IT_CLI_Trace_Slots_Available(USART_IT_CLI_Trace_Lane lane);
+
+// -----------------------------------------------------------------------------+-
+// Returns true once every byte queued to the given trace lane
+// has been handed to the USART.
+// -----------------------------------------------------------------------------+-
+bool USART_IT_CLI_Trace_Is_Empty(USART_IT_CLI_Trace_Lane lane);
+
+// -----------------------------------------------------------------------------+-
+// Returns how full the given trace lane is, as a percentage of its capacity.
+// -----------------------------------------------------------------------------+-
+uint32_t USART_IT_CLI_Trace_Occupancy_Percent(USART_IT_CLI_Trace_Lane lane);
+
+// -----------------------------------------------------------------------------+-
+// Returns the running count of trace messages queued to, or dropped from,
+// the given lane since startup.
+// -----------------------------------------------------------------------------+-
+uint32_t USART_IT_CLI_Trace_Queued_Count(USART_IT_CLI_Trace_Lane lane);
+uint32_t USART_IT_CLI_Trace_Dropped_Count(USART_IT_CLI_Trace_Lane lane);
 
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
@@ -3,6 +3,9 @@
 // UTIL RING BUFFER IMPLEMENTATION
 // platform/util/ring-buffer.c
 //
+// The accessors run from SRAM; they are on the path of every USART
+// interrupt.  See mcu/vtor/ramfunc.h
+//
 // NOTICE!
 // The approach used here assumes the buffer size is a power of two;
 // this code won't work otherwise.
@@ -11,6 +14,7 @@
 // =============================================================================================#=
 
 #include "platform/util/ring-buffer.h"
+#include "mcu/vtor/ramfunc.h"
 
 
 
@@ -18,7 +22,7 @@
 // Private Internal Functions
 // =============================================================================================#=
 
-static uint32_t rb_mask( Ring_Buffer *rb, uint32_t headortail )
+MCU_RAMFUNC static uint32_t rb_mask( Ring_Buffer *rb, uint32_t headortail )
 {
     return (headortail & (rb->size - 1));
 };
@@ -29,45 +33,45 @@ static uint32_t rb_mask( Ring_Buffer *rb, uint32_t headortail )
 // Public API Functions
 // =============================================================================================#=
 
-uint32_t RB_Size( Ring_Buffer *rb )
+MCU_RAMFUNC uint32_t RB_Size( Ring_Buffer *rb )
 {
     return rb->size;
 };
 
-uint32_t RB_Bytes_Available( Ring_Buffer *rb )
+MCU_RAMFUNC uint32_t RB_Bytes_Available( Ring_Buffer *rb )
 {
     return rb->tail - rb->head;
 };
 
-uint32_t RB_Slots_Available( Ring_Buffer *rb )
+MCU_RAMFUNC uint32_t RB_Slots_Available( Ring_Buffer *rb )
 {
     return rb->size - RB_Bytes_Available(rb);
 };
 
 
-bool RB_Is_Empty( Ring_Buffer *rb )
+MCU_RAMFUNC bool RB_Is_Empty( Ring_Buffer *rb )
 {
     return rb->head == rb->tail;
 };
 
-bool RB_Is_Not_Empty( Ring_Buffer *rb )
+MCU_RAMFUNC bool RB_Is_Not_Empty( Ring_Buffer *rb )
 {
     return rb->head != rb->tail;
 };
 
-bool RB_Is_Full( Ring_Buffer *rb )
+MCU_RAMFUNC bool RB_Is_Full( Ring_Buffer *rb )
 {
     return RB_Bytes_Available(rb) == rb->size;
 };
 
 
-void RB_Write_Byte_To_Tail( Ring_Buffer *rb, uint8_t given_byte )
+MCU_RAMFUNC void RB_Write_Byte_To_Tail( Ring_Buffer *rb, uint8_t given_byte )
 {
     rb->buff[rb_mask(rb, rb->tail++)] = given_byte;
     return;
 };
 
-uint8_t RB_Read_Byte_From_Head( Ring_Buffer *rb )
+MCU_RAMFUNC uint8_t RB_Read_Byte_From_Head( Ring_Buffer *rb )
 {
     return rb->buff[rb_mask(rb, rb->head++)];
 };
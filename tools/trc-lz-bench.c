@@ -0,0 +1,272 @@
+
+/*
+================================================================================================#=
+TRACE STREAM COMPRESSION BENCHMARK
+tools/trc-lz-bench.c
+
+Description:
+    Runs the trace compressor, core/swtrace/trc-lz.c, on the host over a
+    recorded trace corpus, and reports its compression ratio, throughput
+    and RAM.  Build and run with, e.g.:
+
+        cc -O2 -I core/swtrace -o trc-lz-bench tools/trc-lz-bench.c core/swtrace/trc-lz.c
+        ./trc-lz-bench capture.bin [-o capture.lz]
+
+    The corpus is a capture from the 'usart-bin' sink, i.e. trace frames;
+    bytes that are not part of a valid frame are ignored.  With --text, the
+    corpus is instead a capture from the 'usart' text sink, and each line is
+    made into a frame as the firmware would, with a made-up timestamp.
+
+    Every frame is compressed as if sent on the low priority lane.
+    With -o, the blocks are also written out, so that the round trip can be
+    checked with tools/trc-lz-decode.  The build-time configuration of the
+    codec may be varied with -D, e.g. -DTRC_LZ_HISTORY_SIZE=1024U.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "trc-lz.h"
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// Keep in sync with trc-frame.h and the usart-lz sink in trc-adapt-default.c;
+#define FRAME_SYNC          (0xA5U)
+#define FRAME_HEADER_LEN    (10U)
+#define FRAME_MAX           (240U)
+
+// Made-up timestamp step for text corpora; 1 ms at 80 MHz;
+#define TEXT_TICKS          (80000U)
+
+// Run the corpus at least this long for the throughput;
+#define MIN_SECONDS         (0.5)
+
+typedef struct
+{
+    uint8_t    *bytes;      // Frames, back to back;
+    uint32_t   *lengths;
+    uint32_t    count;
+    uint64_t    frame_bytes;
+    uint64_t    text_bytes;     // The messages alone, as the 'usart' sink would send them;
+
+}   Corpus;
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Add the given frame to the corpus; the storage was sized by the caller.
+// ---------------------------------------------------------------------------------------------+-
+static void add_frame(Corpus *corpus, uint64_t *used, const uint8_t *frame, uint32_t len)
+{
+    memcpy(&corpus->bytes[*used], frame, len);
+    *used += len;
+    corpus->lengths[corpus->count++] = len;
+    corpus->frame_bytes += len;
+    corpus->text_bytes  += len - (FRAME_HEADER_LEN + 1U);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Scan a binary capture for valid frames, as tools/trc-frame-decode does;
+// ---------------------------------------------------------------------------------------------+-
+static void load_frames(Corpus *corpus, const uint8_t *data, size_t size)
+{
+    uint64_t used = 0;
+    size_t   idx  = 0;
+
+    while (idx + 2 <= size)
+    {
+        size_t length = data[idx+1];
+        size_t end    = idx + 2 + length;     // index of the checksum;
+
+        if (data[idx] != FRAME_SYNC || length < FRAME_HEADER_LEN - 2U || end >= size) {
+            idx++;
+            continue;
+        }
+
+        uint8_t sum = 0;
+        for (size_t pos=idx+1; pos<=end; pos++) sum += data[pos];
+        if (sum != 0 || end + 1 - idx > FRAME_MAX) {
+            idx++;
+            continue;
+        }
+
+        add_frame(corpus, &used, &data[idx], (uint32_t)(end + 1 - idx));
+        idx = end + 1;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Make a frame of each line of a text capture, newline and all;
+// ---------------------------------------------------------------------------------------------+-
+static void load_text(Corpus *corpus, const uint8_t *data, size_t size)
+{
+    uint8_t  frame[FRAME_MAX];
+    uint64_t used  = 0;
+    uint32_t stamp = 0;
+    size_t   start = 0;
+
+    while (start < size)
+    {
+        size_t end = start;
+        while (end < size && data[end] != '\n') end++;
+        if (end < size) end++;
+
+        size_t msg_len = end - start;
+        if (msg_len > FRAME_MAX - FRAME_HEADER_LEN - 1U) msg_len = FRAME_MAX - FRAME_HEADER_LEN - 1U;
+
+        stamp += TEXT_TICKS + (uint32_t)(rand() % 1000);
+        frame[0] = FRAME_SYNC;
+        frame[1] = (uint8_t)(FRAME_HEADER_LEN - 2U + msg_len);
+        frame[2] = 0x01;        // info, text;
+        frame[3] = 0x00;        // app;
+        frame[4] = (uint8_t)(stamp);
+        frame[5] = (uint8_t)(stamp >> 8);
+        frame[6] = (uint8_t)(stamp >> 16);
+        frame[7] = (uint8_t)(stamp >> 24);
+        frame[8] = 0;
+        frame[9] = 0;
+        memcpy(&frame[FRAME_HEADER_LEN], &data[start], msg_len);
+
+        uint8_t sum = 0;
+        for (size_t pos=1; pos<FRAME_HEADER_LEN + msg_len; pos++) sum += frame[pos];
+        frame[FRAME_HEADER_LEN + msg_len] = (uint8_t)(0U - sum);
+
+        add_frame(corpus, &used, frame, (uint32_t)(FRAME_HEADER_LEN + msg_len + 1U));
+        start = end;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Compress the whole corpus once; returns the total length of the blocks.
+// ---------------------------------------------------------------------------------------------+-
+static uint64_t run(const Corpus *corpus, FILE *out)
+{
+    static TRC_LZ_Encoder encoder;
+    uint8_t               block[UINT8_MAX];
+    uint64_t              total  = 0;
+    const uint8_t        *frame  = corpus->bytes;
+
+    TRC_LZ_Init(&encoder);
+
+    for (uint32_t idx=0; idx<corpus->count; idx++)
+    {
+        uint32_t block_len = TRC_LZ_Encode(&encoder, frame, corpus->lengths[idx], block, sizeof(block));
+        if (block_len == 0) {
+            fprintf(stderr, "trc-lz-bench: frame %u did not fit in a block\n", idx);
+            exit(1);
+        }
+        if (out) fwrite(block, 1, block_len, out);
+
+        total += block_len;
+        frame += corpus->lengths[idx];
+    }
+    return total;
+}
+
+static double now_seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+
+
+// ==============================================================================#=
+// Main
+// ==============================================================================#=
+int main(int argc, char *argv[])
+{
+    const char *in_name  = NULL;
+    const char *out_name = NULL;
+    int         text     = 0;
+
+    for (int idx=1; idx<argc; idx++)
+    {
+        if      (strcmp(argv[idx], "--text") == 0)             text = 1;
+        else if (strcmp(argv[idx], "-o") == 0 && idx+1 < argc) out_name = argv[++idx];
+        else if (argv[idx][0] != '-' && in_name == NULL)       in_name = argv[idx];
+        else {
+            fprintf(stderr, "usage: trc-lz-bench corpus [--text] [-o blocks.lz]\n");
+            return 1;
+        }
+    }
+    if (in_name == NULL) {
+        fprintf(stderr, "usage: trc-lz-bench corpus [--text] [-o blocks.lz]\n");
+        return 1;
+    }
+
+    FILE *in = fopen(in_name, "rb");
+    if (in == NULL) {
+        perror(in_name);
+        return 1;
+    }
+    fseek(in, 0, SEEK_END);
+    size_t size = (size_t)ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    uint8_t *data = malloc(size + 1);
+    if (data == NULL || fread(data, 1, size, in) != size) {
+        perror(in_name);
+        return 1;
+    }
+    fclose(in);
+
+    // A text line grows by a frame header; a frame never grows;
+    Corpus corpus = {
+        .bytes   = malloc(size * (FRAME_HEADER_LEN + 1U) + 1),
+        .lengths = malloc((size + 1) * sizeof(uint32_t)),
+    };
+    if (text) load_text(&corpus, data, size);
+    else      load_frames(&corpus, data, size);
+
+    if (corpus.count == 0) {
+        fprintf(stderr, "trc-lz-bench: no frames in %s\n", in_name);
+        return 1;
+    }
+
+    FILE *out = NULL;
+    if (out_name && (out = fopen(out_name, "wb")) == NULL) {
+        perror(out_name);
+        return 1;
+    }
+    uint64_t block_bytes = run(&corpus, out);
+    if (out) fclose(out);
+
+    uint32_t passes = 0;
+    double   start  = now_seconds();
+    double   elapsed;
+    do {
+        run(&corpus, NULL);
+        passes++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < MIN_SECONDS);
+
+    double mb_per_s = (double)corpus.frame_bytes * passes / elapsed / 1e6;
+
+    printf("corpus      %u frames, %llu bytes as frames\n",
+        corpus.count, (unsigned long long)corpus.frame_bytes);
+    printf("compressed  %llu bytes in blocks; %.2fx the frames, %.2fx the text alone\n",
+        (unsigned long long)block_bytes,
+        (double)corpus.frame_bytes / (double)block_bytes,
+        (double)corpus.text_bytes  / (double)block_bytes);
+    printf("throughput  %.1f MB/s of frames; %.2f us per frame\n",
+        mb_per_s, elapsed * 1e6 / ((double)passes * corpus.count));
+    printf("ram         %zu bytes of encoder; %u of block buffer\n",
+        sizeof(TRC_LZ_Encoder), UINT8_MAX);
+    printf("config      history %u, hash %u, reset every %u blocks\n",
+        TRC_LZ_HISTORY_SIZE, TRC_LZ_HASH_SIZE, TRC_LZ_RESET_INTERVAL);
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+================================================================================================#=
+TRACE SINK REGISTRY HOST TEST
+tools/trc-sink-test.c
+
+Description:
+    Runs the trace core, core/swtrace/trc-core.c, and the sink registry,
+    core/swtrace/trc-sink.c, on the host, with memory sinks standing in for
+    the backends; see core/swtrace/trc-sink-memory.h.  Checks the per-sink
+    level filtering, the delivered and dropped counts, and that the module
+    levels and the record type filter apply before any sink sees a record.
+    Build and run with, e.g.:
+
+        cc -I core/swtrace -DTRC_ENABLE_LVL_DEBUG=1 -o trc-sink-test tools/trc-sink-test.c \
+            core/swtrace/trc-core.c core/swtrace/trc-sink.c core/swtrace/trc-throttle.c \
+            core/swtrace/trc-sink-memory.c
+        ./trc-sink-test
+
+    Exits non-zero if any check fails.  The trace adaptation is stubbed out
+    here; TRC_Adapt_Init() registers the memory sinks, as the default
+    adaptation registers the USART and SRAM2 sinks on the target.
+
+SPDX-License-Identifier: MIT-0
+================================================================================================#=
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "trc.h"
+#include "trc-core.h"
+#include "trc-adaptation.h"
+#include "trc-sink.h"
+#include "trc-sink-memory.h"
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Data
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// Every level, from debug up; errors only; and one too small for most messages;
+static uint8_t          All_Buff[1024];
+static TRC_Sink_Memory  All_Memory;
+static TRC_Sink         All_Sink;
+
+static uint8_t          Errors_Buff[1024];
+static TRC_Sink_Memory  Errors_Memory;
+static TRC_Sink         Errors_Sink;
+
+static uint8_t          Tiny_Buff[16];
+static TRC_Sink_Memory  Tiny_Memory;
+static TRC_Sink         Tiny_Sink;
+
+static uint32_t Timestamp = 0;
+static uint32_t Failures  = 0;
+
+#define CHECK(_condition_) do { \
+    if (!(_condition_)) { \
+        printf("trc-sink-test: FAIL at line %d: %s\n", __LINE__, #_condition_); \
+        Failures++; \
+    } \
+} while(0)
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Trace Adaptation; a host stand-in for trc-adapt-default.c
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+void TRC_Adapt_Init(void)
+{
+    TRC_Sink_Memory_Init(&All_Sink,    &All_Memory,    "all",    trcLvlDebug, All_Buff,    sizeof(All_Buff));
+    TRC_Sink_Memory_Init(&Errors_Sink, &Errors_Memory, "errors", trcLvlError, Errors_Buff, sizeof(Errors_Buff));
+    TRC_Sink_Memory_Init(&Tiny_Sink,   &Tiny_Memory,   "tiny",   trcLvlDebug, Tiny_Buff,   sizeof(Tiny_Buff));
+
+    TRC_Sink_Register(&All_Sink);
+    TRC_Sink_Register(&Errors_Sink);
+    TRC_Sink_Register(&Tiny_Sink);
+}
+
+uint32_t TRC_Adapt_Timestamp(void)    { return ++Timestamp; }
+uint32_t TRC_Adapt_Timestamp_Hz(void) { return 1000000U; }
+void     TRC_Adapt_Fatal(void)        { }
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Private Internal Functions
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+
+// ---------------------------------------------------------------------------------------------+-
+// Whether the last record held by the given memory sink has the given content;
+// ---------------------------------------------------------------------------------------------+-
+static bool last_is(const TRC_Sink_Memory *memory, const char *text)
+{
+    return memory->last.msg_len == strlen(text)
+        && memcmp(memory->last.msg, text, memory->last.msg_len) == 0;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Each sink takes the records at or above its own level; one formatting,
+// one record, for all of them.
+// ---------------------------------------------------------------------------------------------+-
+static void check_sink_levels(void)
+{
+    trcDebug("debug %d", 1);
+    trcInfo("info %d", 2);
+    trcError("error %d", 3);
+
+    CHECK(All_Sink.delivered    == 3);
+    CHECK(Errors_Sink.delivered == 1);
+    CHECK(All_Memory.records    == 3);
+    CHECK(Errors_Memory.records == 1);
+    CHECK(last_is(&All_Memory,    "error 3"));
+    CHECK(last_is(&Errors_Memory, "error 3"));
+    CHECK(All_Memory.last.level     == trcLvlError);
+    CHECK(All_Memory.last.timestamp == Errors_Memory.last.timestamp);
+
+    // A sink level changed at run time, as with 'trc sink <name> <level>';
+    TRC_Sink_Find("errors")->min_level = trcLvlInfo;
+    trcInfo("info %d", 4);
+    CHECK(Errors_Sink.delivered == 2);
+    CHECK(last_is(&Errors_Memory, "info 4"));
+    TRC_Sink_Find("errors")->min_level = trcLvlError;
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// A sink that is full drops the record, and counts it; the others still
+// take it.
+// ---------------------------------------------------------------------------------------------+-
+static void check_dropped(void)
+{
+    uint32_t tiny_delivered = Tiny_Sink.delivered;
+    uint32_t tiny_dropped   = Tiny_Sink.dropped;
+    uint32_t all_delivered  = All_Sink.delivered;
+
+    TRC_Sink_Memory_Clear(&Tiny_Memory);
+    trcInfo("%s", "short");
+    trcInfo("%s", "longer than sixteen bytes");
+
+    CHECK(Tiny_Sink.delivered == tiny_delivered + 1);
+    CHECK(Tiny_Sink.dropped   == tiny_dropped + 1);
+    CHECK(Tiny_Memory.used    == 5);
+    CHECK(last_is(&Tiny_Memory, "short"));
+    CHECK(All_Sink.delivered  == all_delivered + 2);
+    CHECK(All_Sink.dropped    == 0);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// The module level is checked inline, before the call to the trace core;
+// no sink is offered a record it filters out.
+// ---------------------------------------------------------------------------------------------+-
+static void check_module_levels(void)
+{
+    uint32_t all_delivered = All_Sink.delivered;
+
+    TRC_SetModuleLogLevel(trcModApp, trcLvlError);
+    trcDebug("filtered");
+    trcInfo("filtered");
+    CHECK(All_Sink.delivered == all_delivered);
+
+    trcError("passed");
+    CHECK(All_Sink.delivered == all_delivered + 1);
+    CHECK(last_is(&All_Memory, "passed"));
+
+    TRC_SetModuleLogLevel(trcModApp, trcLvlDebug);
+}
+
+// ---------------------------------------------------------------------------------------------+-
+// Binary event records go only to binary sinks; a memory sink is not one.
+// ---------------------------------------------------------------------------------------------+-
+static void check_binary_records(void)
+{
+    static const uint8_t event[8] = { 0 };
+    uint32_t all_delivered = All_Sink.delivered;
+
+    TRC_Record record = {
+        .type    = trcTypeEvent,
+        .level   = trcLvlError,
+        .module  = trcModRtos,
+        .msg     = event,
+        .msg_len = sizeof(event),
+    };
+
+    CHECK(!TRC_Sink_Dispatch(&record));
+    CHECK(All_Sink.delivered == all_delivered);
+    CHECK(All_Sink.dropped   == 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+// Main
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+~
+int main(void)
+{
+    TRC_Initialize();
+    TRC_SetLogLevel(trcLvlDebug);
+
+    CHECK(TRC_Sink_Count() == 3);
+    CHECK(TRC_Sink_Find("tiny") == &Tiny_Sink);
+
+    check_sink_levels();
+    check_dropped();
+    check_module_levels();
+    check_binary_records();
+
+    if (Failures > 0) {
+        printf("trc-sink-test: %u checks failed\n", Failures);
+        return 1;
+    }
+    printf("trc-sink-test: ok\n");
+    return 0;
+}